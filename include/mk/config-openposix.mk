@@ -0,0 +1,7 @@
+# SPDX-License-Identifier: GPL-2.0-or-later
+# Copyright (c) Linux Test Project, 2016
+# Parameters from the top level configure
+CC=		gcc
+CFLAGS+=	-g -O2
+LDLIBS+=	
+LDFLAGS+=	
@@ -0,0 +1,95 @@
+# SPDX-License-Identifier: GPL-2.0-or-later
+# Copyright (c) Linux Test Project, 2009-2024
+# Copyright (C) 2009, Cisco Systems Inc.
+# Ngie Cooper, July 2009
+
+# See this page for more info about LEX*:
+# http://www.gnu.org/software/hello/manual/autoconf/Particular-Programs.html
+
+# Application specifying variables. You should never have to change these.
+AR			:= ar
+CC			:= gcc
+LEX			:= @LEX@
+RANLIB			:= ranlib
+OBJCOPY			:= objcopy
+STRIP			:= strip
+YACC			:= bison -y
+
+HOSTCC  = 
+build := x86_64-pc-linux-gnu
+host := x86_64-pc-linux-gnu
+ifeq ($(strip $(HOSTCC)),)
+# native build, respect CC
+ifeq ($(build),$(host))
+HOSTCC := $(CC)
+else
+# cross compilation
+HOSTCC := cc
+endif
+endif
+
+AIO_LIBS		:= 
+CAP_LIBS		:= 
+ACL_LIBS		:= 
+CRYPTO_LIBS		:= -lcrypto
+LEXLIB			:= @LEXLIB@
+NUMA_LIBS		:= -lnuma
+SELINUX_LIBS		:= 
+HAVE_RPC		:= 1
+LIBTIRPC_CFLAGS		:= -I/usr/include/tirpc 
+LIBTIRPC_LIBS		:= -ltirpc 
+KEYUTILS_LIBS		:= 
+HAVE_FTS_H		:= 1
+LIBMNL_LIBS		:= 
+LIBMNL_CFLAGS		:= 
+
+prefix			:= /opt/ltp
+
+datarootdir		:= ${prefix}/share
+includedir		:= ${prefix}/include
+exec_prefix		:= ${prefix}
+bindir			:= ${exec_prefix}/bin
+libdir			:= ${exec_prefix}/lib
+mandir			:= ${datarootdir}/man
+
+CPPFLAGS		:=  -D_FORTIFY_SOURCE=2
+CFLAGS			:= -g -O2
+LDLIBS			:= 
+LDFLAGS			:= 
+
+DEBUG_CFLAGS		?= -g
+
+# for -fstrict-aliasing see doc/developers/build_system.rst.
+OPT_CFLAGS		?= -O2 -fno-strict-aliasing -pipe
+
+WCFLAGS			?= -Wall -W -Wold-style-definition
+
+STDCFLAGS		?= -std=gnu99
+
+LDFLAGS			+= $(WLDFLAGS)
+CFLAGS			+= $(DEBUG_CFLAGS) $(OPT_CFLAGS) $(WCFLAGS) $(STDCFLAGS)
+
+LTP_CFLAGS_NOPIE	:= 1
+LTP_CFLAGS_FFIXED_EBP	:= 1
+
+ifeq ($(strip $(HOST_CFLAGS)),)
+HOST_CFLAGS := $(CFLAGS)
+endif
+
+ifeq ($(strip $(HOST_LDFLAGS)),)
+HOST_LDFLAGS := $(LDFLAGS)
+endif
+
+LINUX_VERSION		:= 6.18.44-fc-v139
+LINUX_DIR		:= /lib/modules/6.18.44-fc-v139/build
+LINUX_VERSION_MAJOR	:= 
+LINUX_VERSION_PATCH	:= 
+WITH_MODULES		:= no
+
+HOST_CPU		:= x86_64
+
+ifeq ($(strip $(prefix)),)
+$(error you are using $$(prefix) incorrectly -- set it to $(abs_top_srcdir) if you want to build in the source tree)
+endif
+
+export datarootdir includedir libdir mandir prefix
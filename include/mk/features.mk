@@ -0,0 +1,25 @@
+# Copyright (c) Linux Test Project, 2008-2025
+# SPDX-License-Identifier: GPL-2.0-or-later
+# Ngie Cooper, October 2010
+
+# Tools enable knobs
+WITH_EXPECT			:= no
+
+WITH_PERL			:= no
+
+WITH_PYTHON			:= no
+
+METADATA_GENERATOR		:= @METADATA_GENERATOR@
+WITH_METADATA			:= @WITH_METADATA@
+WITH_METADATA_HTML		:= @WITH_METADATA_HTML@
+WITH_METADATA_PDF		:= @WITH_METADATA_PDF@
+
+# Features knobs
+
+# Test suite knobs
+
+# Enable testcases/open_posix_testsuite's compile and install?
+WITH_OPEN_POSIX_TESTSUITE	:= no
+
+# Enable testcases/kernel/kvm compile and install?
+WITH_KVM_TESTSUITE		:= yes
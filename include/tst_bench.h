@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) Linux Test Project, 2026
+ */
+
+ /*
+
+    Microbenchmark library.
+
+    The test defines a function that executes the measured operation once and
+    sets it in the tst_test structure, the rest of the work is done by the
+    library.
+
+    static void bench(void)
+    {
+	getpid();
+    }
+
+    static struct tst_test test = {
+	.scall = "getpid()",
+	.bench = bench,
+    };
+
+    The library pins the test to a single CPU, calls the function in batches
+    sized so that a batch takes at least 20 microseconds, takes a number of
+    samples after a warmup, subtracts the measurement loop overhead and
+    reports the cost of the operation in ns/op with percentiles. The median
+    can be stored into a baseline file (-B) and later compared against it
+    (-b).
+
+  */
+
+#ifndef TST_BENCH_H__
+#define TST_BENCH_H__
+
+#include "tst_test.h"
+
+# ifdef TST_NO_DEFAULT_MAIN
+struct tst_test *tst_bench_setup(struct tst_test *test);
+# endif /* TST_NO_DEFAULT_MAIN */
+#endif /* TST_BENCH_H__ */
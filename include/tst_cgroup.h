@@ -116,6 +116,12 @@ extern const struct tst_cg_group *const tst_cg_drain;
  * controllers. Called automatically by tst_cg_require.
  */
 void tst_cg_scan(void);
+/* Returns 1 if the controller is already mounted, 0 otherwise. Unlike
+ * tst_cg_require it neither mounts anything nor exits with TCONF, so a test
+ * can run with and without the controller.
+ */
+int tst_cg_ctrl_mounted(const char *const ctrl_name)
+			__attribute__ ((nonnull));
 /* Print the config detected by tst_cg_scan and print the internal
  * state associated with each controller. Output can be passed to
  * tst_cg_load_config to configure the internal state to that of the
@@ -13,4 +13,26 @@
  */
 uint32_t tst_crc32c(uint8_t *buf, size_t buf_len);
 
+/*
+ * Incremental CRC32c, the checksum of data passed in several chunks is:
+ *
+ * crc = tst_crc32c_init();
+ * crc = tst_crc32c_update(crc, chunk1, len1);
+ * crc = tst_crc32c_update(crc, chunk2, len2);
+ * csum = tst_crc32c_final(crc);
+ *
+ * The SSE4.2 or ARMv8 CRC32 instructions are used when the CPU supports
+ * them, otherwise falls back to a slice-by-8 table implementation.
+ */
+uint32_t tst_crc32c_init(void);
+uint32_t tst_crc32c_update(uint32_t crc, const void *buf, size_t buf_len);
+uint32_t tst_crc32c_final(uint32_t crc);
+
+/*
+ * Selects the CPU instructions (enable = 1, the default when supported) or
+ * the table implementation (enable = 0). Returns 1 if the instructions are
+ * used afterwards, 0 otherwise.
+ */
+int tst_crc32c_use_hw(int enable);
+
 #endif
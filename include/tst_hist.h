@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright (c) Linux Test Project, 2026
+ */
+
+/*
+ * Log-linear histogram for latency measurements.
+ *
+ * Values below TST_HIST_SUB have a bucket each, every higher power of two
+ * range is split into TST_HIST_SUB buckets, i.e. the error of a percentile
+ * is bounded by 12.5% over the whole 64bit range.
+ *
+ * The histogram does not depend on the test library, so it can be used by
+ * the benchmarks in utils/ as well.
+ */
+
+#ifndef TST_HIST_H__
+#define TST_HIST_H__
+
+#include <stdint.h>
+#include <time.h>
+
+#define TST_HIST_SUB_BITS 3
+#define TST_HIST_SUB (1 << TST_HIST_SUB_BITS)
+#define TST_HIST_BUCKETS ((64 - TST_HIST_SUB_BITS + 1) * TST_HIST_SUB)
+
+struct tst_hist {
+	uint64_t buckets[TST_HIST_BUCKETS];
+	uint64_t samples;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t max;
+};
+
+static inline unsigned int tst_hist_bucket(uint64_t val)
+{
+	unsigned int bits;
+
+	if (val < TST_HIST_SUB)
+		return val;
+
+	bits = 63 - __builtin_clzll(val);
+
+	return (bits - TST_HIST_SUB_BITS + 1) * TST_HIST_SUB +
+		((val >> (bits - TST_HIST_SUB_BITS)) & (TST_HIST_SUB - 1));
+}
+
+static inline void tst_hist_add(struct tst_hist *hist, uint64_t val)
+{
+	hist->buckets[tst_hist_bucket(val)]++;
+
+	if (!hist->samples || val < hist->min)
+		hist->min = val;
+
+	if (val > hist->max)
+		hist->max = val;
+
+	hist->samples++;
+	hist->sum += val;
+}
+
+/* CLOCK_MONOTONIC in ns, for timing the recorded operations */
+static inline uint64_t tst_hist_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Smallest value that falls into the bucket */
+uint64_t tst_hist_bucket_min(unsigned int bucket);
+
+/* Largest value that falls into the bucket */
+uint64_t tst_hist_bucket_max(unsigned int bucket);
+
+/*
+ * Adds src to dst.
+ *
+ * The update of dst is atomic, several threads or processes, with dst in
+ * shared memory, may merge into the same histogram at the same time.
+ */
+void tst_hist_merge(struct tst_hist *dst, const struct tst_hist *src);
+
+/*
+ * Returns the upper bound of the bucket that contains the percentile, but
+ * not more than the maximal value recorded. Returns 0 for an empty histogram.
+ *
+ * @hist: histogram
+ * @pct: percentile, between 0 and 100
+ */
+uint64_t tst_hist_percentile(const struct tst_hist *hist, double pct);
+
+#endif /* TST_HIST_H__ */
@@ -193,4 +193,14 @@ int tst_netdev_remove_traffic_filter(const char *file, const int lineno,
 	tst_netdev_remove_traffic_filter(__FILE__, __LINE__, 1, (ifname), \
 		(parent), (handle), (protocol), (priority), (f_kind))
 
+/*
+ * Set up network topology (namespaces, devices, addresses and routes)
+ * described by spec, see lib/tst_netdev_topology.c for the syntax.
+ * The rtnetlink requests are sent in batches.
+ */
+int tst_netdev_setup_topology(const char *file, const int lineno, int strict,
+	const char *spec);
+#define NETDEV_SETUP_TOPOLOGY(spec) \
+	tst_netdev_setup_topology(__FILE__, __LINE__, 1, (spec))
+
 #endif /* TST_NETDEVICE_H */
@@ -59,4 +59,19 @@ bool tst_check_cmd(const char *cmd, const int brk_nosupp);
  */
 const char **tst_get_supported_fs_types(const char *const *skiplist);
 
+/*
+ * Per test CGroup v2 resource accounting, see lib/tst_cgroup_stats.c.
+ *
+ * tst_cg_stats_start() creates the group before the test process is forked,
+ * tst_cg_stats_attach() moves the forked test process into it and
+ * tst_cg_stats_stop() records the statistics and removes the group once the
+ * test process has been reaped.
+ */
+void tst_cg_stats_init(void);
+void tst_cg_stats_start(void);
+void tst_cg_stats_attach(void);
+void tst_cg_stats_stop(void);
+void tst_cg_stats_print(void);
+void tst_cg_stats_cleanup(void);
+
 #endif
@@ -6,10 +6,42 @@
 #define TST_RAND_DATA_H__
 
 #include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
 
 /* Includes null byte */
 extern const size_t tst_rand_data_len;
 /* statically defined random data */
 extern const char *const tst_rand_data;
 
+/*
+ * Fills buffer with a slice of a pseudorandom stream.
+ *
+ * The stream is identified by the seed and every byte is a function of the
+ * seed and its offset in the stream only, hence any range can be generated
+ * (and later verified) independently. Unlike tst_rand_data the data does not
+ * repeat, so it cannot be compressed or deduplicated by the storage.
+ *
+ * @seed: stream identifier
+ * @off: offset of the first byte in the stream
+ * @buf: buffer to fill
+ * @len: number of bytes to generate
+ */
+void tst_rand_data_fill(uint64_t seed, uint64_t off, void *buf, size_t len);
+
+/*
+ * Checks that buffer contains a slice of a stream generated by
+ * tst_rand_data_fill().
+ *
+ * @seed: stream identifier
+ * @off: offset of the first byte in the stream
+ * @buf: buffer to check
+ * @len: number of bytes to check
+ *
+ * Returns offset of the first mismatching byte in the buffer or -1 if the
+ * whole buffer matches.
+ */
+ssize_t tst_rand_data_verify(uint64_t seed, uint64_t off, const void *buf,
+			     size_t len);
+
 #endif
@@ -27,6 +27,12 @@ struct tst_io_uring {
 	const struct io_uring_cqe *cqr_entries;
 	const uint32_t *cqr_tail, *cqr_mask, *cqr_overflow;
 	uint32_t *cqr_head;
+
+	/* Flags passed to io_uring_setup() */
+	uint32_t setup_flags;
+
+	/* Tail including entries from tst_io_uring_get_sqe() not yet submitted */
+	uint32_t sqe_tail;
 };
 
 /*
@@ -59,4 +65,135 @@ int safe_io_uring_enter(const char *file, const int lineno, int strict,
 	int fd, unsigned int to_submit, unsigned int min_complete,
 	unsigned int flags, sigset_t *sig);
 
+/*
+ * Call io_uring_register() and check for errors.
+ */
+#define SAFE_IO_URING_REGISTER(uring, opcode, arg, nr_args) \
+	safe_io_uring_register(__FILE__, __LINE__, (uring), (opcode), (arg), \
+		(nr_args))
+int safe_io_uring_register(const char *file, const int lineno,
+	struct tst_io_uring *uring, unsigned int opcode, void *arg,
+	unsigned int nr_args);
+
+#define SAFE_IO_URING_REGISTER_BUFFERS(uring, iovecs, nr) \
+	SAFE_IO_URING_REGISTER((uring), IORING_REGISTER_BUFFERS, (iovecs), (nr))
+#define SAFE_IO_URING_UNREGISTER_BUFFERS(uring) \
+	SAFE_IO_URING_REGISTER((uring), IORING_UNREGISTER_BUFFERS, NULL, 0)
+#define SAFE_IO_URING_REGISTER_FILES(uring, fds, nr) \
+	SAFE_IO_URING_REGISTER((uring), IORING_REGISTER_FILES, (fds), (nr))
+#define SAFE_IO_URING_UNREGISTER_FILES(uring) \
+	SAFE_IO_URING_REGISTER((uring), IORING_UNREGISTER_FILES, NULL, 0)
+
+/*
+ * Return the next free submission queue entry cleared to zero or NULL if
+ * the queue is full. Prepared entries are passed to the kernel by
+ * SAFE_IO_URING_SUBMIT().
+ */
+struct io_uring_sqe *tst_io_uring_get_sqe(struct tst_io_uring *uring);
+
+/*
+ * Submit all entries returned by tst_io_uring_get_sqe() and wait for at least
+ * wait_nr completions. With IORING_SETUP_SQPOLL, io_uring_enter() is called
+ * only when the polling thread has to be woken up or wait_nr is non-zero.
+ * Returns the number of submitted entries.
+ */
+#define SAFE_IO_URING_SUBMIT(uring, wait_nr) \
+	safe_io_uring_submit(__FILE__, __LINE__, (uring), (wait_nr))
+int safe_io_uring_submit(const char *file, const int lineno,
+	struct tst_io_uring *uring, unsigned int wait_nr);
+
+/*
+ * Return the oldest completion queue entry or NULL if the queue is empty.
+ * Call tst_io_uring_cqe_seen() once the entry has been processed.
+ */
+const struct io_uring_cqe *tst_io_uring_peek_cqe(struct tst_io_uring *uring);
+void tst_io_uring_cqe_seen(struct tst_io_uring *uring);
+
+/*
+ * Wait up to timeout_ms milliseconds (forever if negative) for a completion.
+ * Returns the same as tst_io_uring_peek_cqe(), NULL on timeout. The ring
+ * file descriptor is polled, this does not work with IORING_SETUP_IOPOLL.
+ */
+#define SAFE_IO_URING_WAIT_CQE(uring, timeout_ms) \
+	safe_io_uring_wait_cqe(__FILE__, __LINE__, (uring), (timeout_ms))
+const struct io_uring_cqe *safe_io_uring_wait_cqe(const char *file,
+	const int lineno, struct tst_io_uring *uring, int timeout_ms);
+
+/* Submission queue entry preparation */
+static inline void tst_io_uring_prep_rw(struct io_uring_sqe *sqe, int opcode,
+	int fd, const void *addr, uint32_t len, uint64_t offset)
+{
+	sqe->opcode = opcode;
+	sqe->fd = fd;
+	sqe->addr = (uintptr_t)addr;
+	sqe->len = len;
+	sqe->off = offset;
+}
+
+static inline void tst_io_uring_prep_nop(struct io_uring_sqe *sqe)
+{
+	sqe->opcode = IORING_OP_NOP;
+}
+
+static inline void tst_io_uring_prep_read(struct io_uring_sqe *sqe, int fd,
+	void *buf, uint32_t len, uint64_t offset)
+{
+	tst_io_uring_prep_rw(sqe, IORING_OP_READ, fd, buf, len, offset);
+}
+
+static inline void tst_io_uring_prep_write(struct io_uring_sqe *sqe, int fd,
+	const void *buf, uint32_t len, uint64_t offset)
+{
+	tst_io_uring_prep_rw(sqe, IORING_OP_WRITE, fd, buf, len, offset);
+}
+
+static inline void tst_io_uring_prep_readv(struct io_uring_sqe *sqe, int fd,
+	const struct iovec *iov, uint32_t nr_vecs, uint64_t offset)
+{
+	tst_io_uring_prep_rw(sqe, IORING_OP_READV, fd, iov, nr_vecs, offset);
+}
+
+static inline void tst_io_uring_prep_writev(struct io_uring_sqe *sqe, int fd,
+	const struct iovec *iov, uint32_t nr_vecs, uint64_t offset)
+{
+	tst_io_uring_prep_rw(sqe, IORING_OP_WRITEV, fd, iov, nr_vecs, offset);
+}
+
+/* buf must lie within the registered buffer buf_index */
+static inline void tst_io_uring_prep_read_fixed(struct io_uring_sqe *sqe,
+	int fd, void *buf, uint32_t len, uint64_t offset, int buf_index)
+{
+	tst_io_uring_prep_rw(sqe, IORING_OP_READ_FIXED, fd, buf, len, offset);
+	sqe->buf_index = buf_index;
+}
+
+static inline void tst_io_uring_prep_write_fixed(struct io_uring_sqe *sqe,
+	int fd, const void *buf, uint32_t len, uint64_t offset, int buf_index)
+{
+	tst_io_uring_prep_rw(sqe, IORING_OP_WRITE_FIXED, fd, buf, len, offset);
+	sqe->buf_index = buf_index;
+}
+
+static inline void tst_io_uring_prep_fsync(struct io_uring_sqe *sqe, int fd,
+	uint32_t fsync_flags)
+{
+	sqe->opcode = IORING_OP_FSYNC;
+	sqe->fd = fd;
+	sqe->fsync_flags = fsync_flags;
+}
+
+static inline void tst_io_uring_prep_send(struct io_uring_sqe *sqe,
+	int sockfd, const void *buf, uint32_t len, int flags)
+{
+	tst_io_uring_prep_rw(sqe, IORING_OP_SEND, sockfd, buf, len, 0);
+	sqe->msg_flags = flags;
+}
+
+static inline void tst_io_uring_prep_recv(struct io_uring_sqe *sqe,
+	int sockfd, void *buf, uint32_t len, int flags)
+{
+	tst_io_uring_prep_rw(sqe, IORING_OP_RECV, sockfd, buf, len, 0);
+	sqe->msg_flags = flags;
+}
+
 #endif /* TST_IO_URING_H__ */
@@ -357,6 +357,16 @@ struct tst_fs {
  *                     Testcases that modify system wallclock use this to
  *                     restore the system to the previous state.
  *
+ * @parallel_tcases: If set the tst_test.test() test cases are distributed over
+ *                   a pool of forked worker processes, one per CPU the test is
+ *                   allowed to run on, each pinned to its CPU. The workers are
+ *                   forked after tst_test.setup() so the test cases have to be
+ *                   independent of each other and must not rely on changes
+ *                   done to the test process state by previous test cases.
+ *                   The output is printed in the test case order. A
+ *                   tst_brk() in a test case stops dispatching the remaining
+ *                   test cases. Implies forks_child.
+ *
  * @all_filesystems: If set the test is executed for all supported filesystems,
  *                   i.e. file system that is supported by the kernel and has
  *                   mkfs installed on the system.The file system is mounted at
@@ -490,10 +500,16 @@ struct tst_fs {
  *            can be set. May be executed several times if test was passed '-i'
  *            or '-d' command line parameters.
  *
- * @scall: Internal only (timer measurement library).
+ * @scall: Internal only (timer measurement and microbenchmark libraries).
  *
  * @sample: Internal only (timer measurement library).
  *
+ * @bench: Microbenchmark function that executes the measured operation once,
+ *         only one of the tst_test.test, test_all and bench can be set. The
+ *         function is called in a tight measured loop pinned to a single CPU
+ *         and the cost in ns/op is reported, the operation is described by
+ *         tst_test.scall. See tst_bench.h for details.
+ *
  * @resource_files: A NULL terminated array of filenames that will be copied
  *                  to the test temporary directory from the LTP datafiles
  *                  directory.
@@ -562,6 +578,7 @@ struct tst_fs {
 	unsigned int runs_script:1;
 	unsigned int needs_devfs:1;
 	unsigned int restore_wallclock:1;
+	unsigned int parallel_tcases:1;
 
 	unsigned int all_filesystems:1;
 
@@ -603,6 +620,7 @@ struct tst_fs {
 
 	const char *scall;
 	int (*sample)(int clk_id, long long usec);
+	void (*bench)(void);
 
 	const char *const *resource_files;
 	const char * const *needs_drivers;
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 /*
  * Copyright © International Business Machines  Corp., 2006-2008
+ * Copyright (c) Linux Test Project, 2026
  *
  * AUTHOR
  *        Darren Hart <dvhltc@us.ibm.com>
@@ -10,44 +11,401 @@
  *      It directly comes from the librttest.h (see its HISTORY).
  */
 
+/*
+ * Cycle counter access.
+ *
+ * tst_tsc_read() reads the counter without any ordering against the
+ * surrounding code, tst_tsc_read_start() and tst_tsc_read_end() wait for the
+ * preceding instructions to finish and are meant to bracket the measured code.
+ *
+ * The counters used are the x86 TSC, the aarch64 virtual counter
+ * (CNTVCT_EL0), the riscv time CSR and the powerpc time base. All but the x86
+ * TSC tick at a fixed rate that is usually much lower than the CPU frequency,
+ * the rate has to be calibrated with tst_tsc_calibrate() before the ticks can
+ * be converted to time:
+ *
+ *   struct tst_tsc tsc;
+ *   uint64_t start, end;
+ *
+ *   if (tst_tsc_calibrate(&tsc))
+ *           ... the counter is not usable, errno is ENOTSUP ...
+ *
+ *   start = tst_tsc_read_start();
+ *   ...
+ *   end = tst_tsc_read_end();
+ *
+ *   printf("%.1f ns\n", tst_tsc_to_ns(&tsc, end - start));
+ *
+ * The header is self contained so that it can be used by both the tst_test
+ * tests and the realtime tests that link only librealtime.
+ */
+
 #ifndef TST_TSC_H
 #define TST_TSC_H
 
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
 #undef TSC_UNSUPPORTED
 
-/* TSC macros */
-#if defined(__i386__)
-#define rdtscll(val) __asm__ __volatile__("rdtsc" : "=A" (val))
-#elif defined(__x86_64__)
-#define rdtscll(val)					\
-	do {						\
-		uint32_t low, high;			\
-		__asm__ __volatile__ ("rdtsc" : "=a" (low), "=d" (high)); \
-		val = (uint64_t)high << 32 | low;	\
-	} while (0)
+#if defined(__i386__) || defined(__x86_64__)
+
+#include <cpuid.h>
+
+static inline uint64_t tst_tsc_read(void)
+{
+	uint32_t low, high;
+
+	__asm__ __volatile__ ("rdtsc" : "=a" (low), "=d" (high));
+
+	return (uint64_t)high << 32 | low;
+}
+
+# if defined(__x86_64__)
+/*
+ * CPUID is slow, in a VM it exits to the hypervisor, so the result is cached.
+ * The cache is per translation unit and is filled by the first
+ * tst_tsc_read_start(), outside of the measured code.
+ */
+static inline int tst_tsc_has_rdtscp_(void)
+{
+	static int rdtscp = -1;
+	unsigned int eax, ebx, ecx, edx;
+
+	if (rdtscp < 0) {
+		rdtscp = __get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx) &&
+			 (edx & (1U << 27));
+	}
+
+	return rdtscp;
+}
+
+static inline uint64_t tst_tsc_read_start(void)
+{
+	uint32_t low, high;
+
+	tst_tsc_has_rdtscp_();
+
+	__asm__ __volatile__ ("lfence\n\trdtsc\n\tlfence"
+			      : "=a" (low), "=d" (high) :: "memory");
+
+	return (uint64_t)high << 32 | low;
+}
+
+static inline uint64_t tst_tsc_read_end(void)
+{
+	uint32_t low, high, aux;
+
+	if (tst_tsc_has_rdtscp_()) {
+		__asm__ __volatile__ ("rdtscp\n\tlfence"
+				      : "=a" (low), "=d" (high), "=c" (aux)
+				      :: "memory");
+	} else {
+		__asm__ __volatile__ ("lfence\n\trdtsc\n\tlfence"
+				      : "=a" (low), "=d" (high) :: "memory");
+	}
+
+	return (uint64_t)high << 32 | low;
+}
+# else
+/* lfence needs SSE2, do not rely on it on 32bit */
+static inline uint64_t tst_tsc_read_start(void)
+{
+	__asm__ __volatile__ ("" ::: "memory");
+	return tst_tsc_read();
+}
+
+static inline uint64_t tst_tsc_read_end(void)
+{
+	uint64_t val = tst_tsc_read();
+
+	__asm__ __volatile__ ("" ::: "memory");
+	return val;
+}
+# endif
+
+#elif defined(__aarch64__)
+
+static inline uint64_t tst_tsc_read(void)
+{
+	uint64_t val;
+
+	__asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (val));
+
+	return val;
+}
+
+static inline uint64_t tst_tsc_read_start(void)
+{
+	uint64_t val;
+
+	__asm__ __volatile__ ("isb\n\tmrs %0, cntvct_el0\n\tisb"
+			      : "=r" (val) :: "memory");
+
+	return val;
+}
+
+static inline uint64_t tst_tsc_read_end(void)
+{
+	return tst_tsc_read_start();
+}
+
+#elif defined(__riscv)
+
+static inline uint64_t tst_tsc_read(void)
+{
+# if __riscv_xlen == 32
+	uint32_t low, high, tmp;
+
+	do {
+		__asm__ __volatile__ ("rdtimeh %0" : "=r" (high));
+		__asm__ __volatile__ ("rdtime %0" : "=r" (low));
+		__asm__ __volatile__ ("rdtimeh %0" : "=r" (tmp));
+	} while (high != tmp);
+
+	return (uint64_t)high << 32 | low;
+# else
+	uint64_t val;
+
+	__asm__ __volatile__ ("rdtime %0" : "=r" (val));
+
+	return val;
+# endif
+}
+
+static inline uint64_t tst_tsc_read_start(void)
+{
+	uint64_t val;
+
+	__asm__ __volatile__ ("fence" ::: "memory");
+	val = tst_tsc_read();
+	__asm__ __volatile__ ("fence" ::: "memory");
+
+	return val;
+}
+
+static inline uint64_t tst_tsc_read_end(void)
+{
+	return tst_tsc_read_start();
+}
+
 #elif defined(__powerpc__)
-#if defined(__powerpc64__)	/* 64bit version */
-#define rdtscll(val)					\
-	do {								\
-		__asm__ __volatile__ ("mfspr %0, 268" : "=r" (val));	\
-	} while (0)
-#else	/*__powerpc__ 32bit version */
-#define rdtscll(val)							\
-	 do {								\
-		uint32_t tbhi, tblo ;					\
-		__asm__ __volatile__ ("mftbu %0" : "=r" (tbhi));	\
-		__asm__ __volatile__ ("mftbl %0" : "=r" (tblo));	\
-		val = 1000 * ((uint64_t) tbhi << 32) | tblo;		\
-	} while (0)
-#endif
+
+static inline uint64_t tst_tsc_read(void)
+{
+# if defined(__powerpc64__)
+	uint64_t val;
+
+	__asm__ __volatile__ ("mfspr %0, 268" : "=r" (val));
+
+	return val;
+# else
+	uint32_t tbhi, tblo, tmp;
+
+	do {
+		__asm__ __volatile__ ("mftbu %0" : "=r" (tbhi));
+		__asm__ __volatile__ ("mftb %0" : "=r" (tblo));
+		__asm__ __volatile__ ("mftbu %0" : "=r" (tmp));
+	} while (tbhi != tmp);
+
+	return (uint64_t)tbhi << 32 | tblo;
+# endif
+}
+
+static inline uint64_t tst_tsc_read_start(void)
+{
+	uint64_t val;
+
+	__asm__ __volatile__ ("isync" ::: "memory");
+	val = tst_tsc_read();
+	__asm__ __volatile__ ("isync" ::: "memory");
+
+	return val;
+}
+
+static inline uint64_t tst_tsc_read_end(void)
+{
+	return tst_tsc_read_start();
+}
+
 #else
-#warning TSC UNSUPPORTED
 /* All tests will be compiled also for the
  * architecture without TSC support (e.g. SH).
- * At run-time these will fail with ENOTSUP.
+ * At run-time tst_tsc_calibrate() fails with ENOTSUP.
  */
-#define rdtscll(val)	do {  } while (0)
 #define TSC_UNSUPPORTED
+
+static inline uint64_t tst_tsc_read(void)
+{
+	return 0;
+}
+
+static inline uint64_t tst_tsc_read_start(void)
+{
+	return 0;
+}
+
+static inline uint64_t tst_tsc_read_end(void)
+{
+	return 0;
+}
+#endif
+
+#define rdtscll(val) ((val) = tst_tsc_read())
+
+struct tst_tsc {
+	/* counter ticks per ns */
+	double ticks_per_ns;
+	/* cost of a tst_tsc_read_start() and tst_tsc_read_end() pair in ns */
+	double overhead_ns;
+	/*
+	 * smallest non-zero difference of two back to back tst_tsc_read() in
+	 * ns, the read cost for counters faster than a read, the counter step
+	 * for the slower ones
+	 */
+	double read_ns;
+};
+
+#define TST_TSC_CALIBRATE_NS 10000000
+#define TST_TSC_LOOPS 1000
+
+static inline uint64_t tst_tsc_raw_ns_(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ * Reads the counter together with CLOCK_MONOTONIC_RAW, returns the clock in
+ * the middle of the tightest of a few tries.
+ */
+static inline uint64_t tst_tsc_sample_(uint64_t *ticks)
+{
+	uint64_t t0, t1, c, best = UINT64_MAX, ret = 0;
+	int i;
+
+	*ticks = 0;
+
+	for (i = 0; i < 5; i++) {
+		t0 = tst_tsc_raw_ns_();
+		c = tst_tsc_read_start();
+		t1 = tst_tsc_raw_ns_();
+
+		if (t1 - t0 < best) {
+			best = t1 - t0;
+			ret = t0 + best / 2;
+			*ticks = c;
+		}
+	}
+
+	return ret;
+}
+
+/*
+ * The x86 TSC ticks at a constant rate only if the CPU says so, the other
+ * counters are constant rate by definition.
+ */
+static inline int tst_tsc_constant_rate_(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+	char line[4096];
+	int ret = 0;
+	FILE *f;
+
+	f = fopen("/proc/cpuinfo", "r");
+	if (!f)
+		return 0;
+
+	while (fgets(line, sizeof(line), f)) {
+		if (!strncmp(line, "flags", 5)) {
+			ret = !!strstr(line, " constant_tsc");
+			break;
+		}
+	}
+
+	fclose(f);
+
+	return ret;
+#else
+	return 1;
 #endif
+}
+
+/*
+ * Measures the counter rate against CLOCK_MONOTONIC_RAW, the overhead of a
+ * measurement and the read cost or step of the counter.
+ *
+ * Returns 0 on success, -1 with errno set to ENOTSUP if the counter is not
+ * supported, does not tick at a constant rate or does not advance.
+ */
+static inline int tst_tsc_calibrate(struct tst_tsc *tsc)
+{
+	uint64_t t0, t1, c0, c1, prev, cur, min_delta = UINT64_MAX;
+	int i;
+
+	memset(tsc, 0, sizeof(*tsc));
+
+#ifdef TSC_UNSUPPORTED
+	errno = ENOTSUP;
+	return -1;
+#endif
+
+	if (!tst_tsc_constant_rate_()) {
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	t0 = tst_tsc_sample_(&c0);
+	do {
+		t1 = tst_tsc_sample_(&c1);
+	} while (t1 - t0 < TST_TSC_CALIBRATE_NS);
+
+	if (c1 <= c0) {
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	tsc->ticks_per_ns = (double)(c1 - c0) / (t1 - t0);
+
+	for (i = 0; i < TST_TSC_LOOPS; i++) {
+		c0 = tst_tsc_read_start();
+		c1 = tst_tsc_read_end();
+
+		if (c1 - c0 < min_delta)
+			min_delta = c1 - c0;
+	}
+
+	tsc->overhead_ns = min_delta / tsc->ticks_per_ns;
+
+	/* slow counters need a few reads until they advance */
+	min_delta = UINT64_MAX;
+	prev = tst_tsc_read();
+	for (i = 0; i < TST_TSC_LOOPS; i++) {
+		cur = tst_tsc_read();
+
+		if (cur != prev && cur - prev < min_delta)
+			min_delta = cur - prev;
+
+		prev = cur;
+	}
+
+	if (min_delta == UINT64_MAX)
+		min_delta = 1;
+
+	tsc->read_ns = min_delta / tsc->ticks_per_ns;
+
+	return 0;
+}
+
+static inline double tst_tsc_to_ns(const struct tst_tsc *tsc, uint64_t ticks)
+{
+	return ticks / tsc->ticks_per_ns;
+}
 
 #endif
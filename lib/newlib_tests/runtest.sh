@@ -6,9 +6,11 @@
 # TODO TBROK: test_exec_child test_kconfig01 test_kconfig02 tst_needs_cmds04 tst_needs_cmds05 test_runtime02 test01 test02 test03 test04 test06 test11 test13 test22 test25 tst_safe_fileops
 # TODO TWARN: test_guarded_buf test14 tst_capability01 tst_print_result
 LTP_C_API_TESTS="${LTP_C_API_TESTS:-
+test_bench
 test_children_cleanup.sh
 test_kconfig.sh
 test_kconfig03
+test_parallel_tcases
 test_parse_filesize
 test_runtime01
 test_timer
@@ -19,6 +21,7 @@ test2[04]
 tst_bool_expr
 tst_capability02
 tst_checkpoint
+tst_crc32c
 tst_checkpoint_parent
 tst_checkpoint_wait_timeout
 tst_checkpoint_wake_timeout
@@ -27,6 +30,7 @@ tst_expiration_timer
 tst_filesystems01
 tst_fuzzy_sync0[1-3]
 tst_needs_cmds0[1-36-8]
+tst_rand_data
 tst_res_hexd
 tst_safe_sscanf
 tst_strstatus}"
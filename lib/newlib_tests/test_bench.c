@@ -0,0 +1,22 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) Linux Test Project, 2026
+ */
+
+/*
+ * Test the microbenchmark library on getppid(), try with -B and -b to store
+ * and compare against a baseline.
+ */
+
+#include "tst_test.h"
+#include "lapi/syscalls.h"
+
+static void bench(void)
+{
+	tst_syscall(__NR_getppid);
+}
+
+static struct tst_test test = {
+	.scall = "getppid()",
+	.bench = bench,
+};
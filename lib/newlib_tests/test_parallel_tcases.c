@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) Linux Test Project, 2026
+ */
+
+/*
+ * Test that .parallel_tcases runs all test cases, including results reported
+ * from children of the worker processes, and prints the output in the test
+ * case order. Run with LTP_TCASE_WORKERS=4 on a single CPU machine.
+ */
+
+#include <stdlib.h>
+#include "tst_test.h"
+
+#define TCNT 32
+
+static void do_test(unsigned int n)
+{
+	/* Make later test cases finish first */
+	usleep((TCNT - n) * 1000);
+
+	if (n % 8 == 0) {
+		if (!SAFE_FORK()) {
+			tst_res(TPASS, "Test case %u child", n);
+			exit(0);
+		}
+
+		return;
+	}
+
+	tst_res(TINFO, "Test case %u running in pid %i", n, getpid());
+	tst_res(TPASS, "Test case %u", n);
+}
+
+static struct tst_test test = {
+	.test = do_test,
+	.tcnt = TCNT,
+	.parallel_tcases = 1,
+};
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2026 Linux Test Project
+ */
+
+/*
+ * Checks tst_crc32c() and the incremental API against a bitwise reference
+ * implementation for various lengths and alignments, for both the table and
+ * the CPU instruction implementation.
+ */
+
+#include "tst_test.h"
+#include "tst_checksum.h"
+#include "tst_rand_data.h"
+
+#define BUF_LEN 4096
+
+static uint8_t *buf;
+
+static uint32_t crc32c_ref(const uint8_t *p, size_t len)
+{
+	uint32_t crc = 0xffffffff;
+	int i;
+
+	while (len--) {
+		crc ^= *p++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (0x82f63b78 & -(crc & 1));
+	}
+
+	return ~crc;
+}
+
+static void run(unsigned int n)
+{
+	uint8_t check[] = "123456789";
+	size_t off, len, split;
+	uint32_t crc, ref;
+
+	if (tst_crc32c_use_hw(n) != (int)n) {
+		tst_res(TCONF, "CPU has no CRC32c instructions");
+		return;
+	}
+
+	tst_res(TINFO, "Testing %s implementation", n ? "hardware" : "software");
+
+	crc = tst_crc32c(check, 9);
+	if (crc != 0xe3069283)
+		tst_res(TFAIL, "crc32c(\"123456789\") = 0x%08x", crc);
+	else
+		tst_res(TPASS, "crc32c(\"123456789\") = 0x%08x", crc);
+
+	for (off = 0; off < 8; off++) {
+		for (len = 0; len + off <= BUF_LEN; len += 1 + len / 4) {
+			ref = crc32c_ref(buf + off, len);
+			crc = tst_crc32c(buf + off, len);
+			if (crc != ref) {
+				tst_res(TFAIL, "off=%zu len=%zu: 0x%08x != 0x%08x",
+					off, len, crc, ref);
+				return;
+			}
+		}
+	}
+	tst_res(TPASS, "One-shot checksums match the reference");
+
+	ref = crc32c_ref(buf, BUF_LEN);
+	for (split = 0; split <= BUF_LEN; split += 13) {
+		crc = tst_crc32c_init();
+		crc = tst_crc32c_update(crc, buf, split);
+		crc = tst_crc32c_update(crc, buf + split, BUF_LEN - split);
+		crc = tst_crc32c_final(crc);
+		if (crc != ref) {
+			tst_res(TFAIL, "split=%zu: 0x%08x != 0x%08x",
+				split, crc, ref);
+			return;
+		}
+	}
+	tst_res(TPASS, "Incremental checksums match the reference");
+}
+
+static void setup(void)
+{
+	tst_rand_data_fill(0, 0, buf, BUF_LEN);
+}
+
+static struct tst_test test = {
+	.setup = setup,
+	.test = run,
+	.tcnt = 2,
+	.bufs = (struct tst_buffers []) {
+		{&buf, .size = BUF_LEN},
+		{}
+	},
+};
@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2026 Linux Test Project
+ */
+
+/*
+ * Basic unit test for tst_rand_data_fill() and tst_rand_data_verify().
+ */
+
+#include "tst_test.h"
+#include "tst_rand_data.h"
+
+#define BUF_LEN 65536
+
+static unsigned char *buf, *part;
+
+static void run(void)
+{
+	size_t off, len;
+	ssize_t ret;
+
+	tst_rand_data_fill(1, 0, buf, BUF_LEN);
+
+	for (off = 0; off < 64; off++) {
+		for (len = 0; len < 64; len++) {
+			tst_rand_data_fill(1, off, part, len);
+			if (memcmp(part, buf + off, len)) {
+				tst_res(TFAIL, "slice off=%zu len=%zu differs",
+					off, len);
+				return;
+			}
+		}
+	}
+	tst_res(TPASS, "Slices match the whole stream");
+
+	ret = tst_rand_data_verify(1, 0, buf, BUF_LEN);
+	if (ret != -1)
+		tst_res(TFAIL, "verify returned %zi for valid data", ret);
+	else
+		tst_res(TPASS, "Valid data verified");
+
+	buf[5000] ^= 1;
+	ret = tst_rand_data_verify(1, 0, buf, BUF_LEN);
+	if (ret != 5000)
+		tst_res(TFAIL, "verify returned %zi expected 5000", ret);
+	else
+		tst_res(TPASS, "Corrupted byte detected at 5000");
+	buf[5000] ^= 1;
+
+	ret = tst_rand_data_verify(1, 7, buf + 7, BUF_LEN - 7);
+	if (ret != -1)
+		tst_res(TFAIL, "verify at offset 7 returned %zi", ret);
+	else
+		tst_res(TPASS, "Unaligned range verified");
+
+	tst_rand_data_fill(2, 0, part, BUF_LEN);
+	if (!memcmp(part, buf, BUF_LEN))
+		tst_res(TFAIL, "Different seeds produce the same data");
+	else
+		tst_res(TPASS, "Different seeds produce different data");
+
+	for (off = 4096; off < BUF_LEN; off += 4096) {
+		if (!memcmp(buf, buf + off, 4096)) {
+			tst_res(TFAIL, "Block at %zu repeats the first block", off);
+			return;
+		}
+	}
+	tst_res(TPASS, "Blocks do not repeat");
+}
+
+static struct tst_test test = {
+	.test_all = run,
+	.bufs = (struct tst_buffers []) {
+		{&buf, .size = BUF_LEN},
+		{&part, .size = BUF_LEN},
+		{}
+	},
+};
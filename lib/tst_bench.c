@@ -0,0 +1,420 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) Linux Test Project, 2026
+ */
+
+#define _GNU_SOURCE
+#include <sched.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+
+#define TST_NO_DEFAULT_MAIN
+#include "tst_test.h"
+#include "tst_clocks.h"
+#include "tst_tsc.h"
+#include "tst_safe_stdio.h"
+#include "tst_bench.h"
+
+#define DEFAULT_SAMPLES 1000
+#define DEFAULT_WARMUP 100
+#define DEFAULT_TOLERANCE 10
+/* Minimal duration of a single sample in ns */
+#define BATCH_NS 20000
+#define MAX_BATCH (1 << 20)
+
+static const char *scall;
+static void (*setup)(void);
+static void (*cleanup)(void);
+static void (*bench)(void);
+static struct tst_test *test;
+
+static double *samples;
+static int sample_cnt = DEFAULT_SAMPLES;
+static int warmup_cnt = DEFAULT_WARMUP;
+static int bench_cpu = -1;
+static int tolerance = DEFAULT_TOLERANCE;
+static unsigned int batch;
+static double overhead;
+
+static int use_tsc;
+static double ticks_per_ns = 1;
+
+static char *str_sample_cnt;
+static char *str_warmup_cnt;
+static char *str_cpu;
+static char *str_tolerance;
+static char *use_clock;
+static char *baseline_file;
+static char *store_file;
+static char *file_name;
+
+static inline uint64_t clock_ns(void)
+{
+	struct timespec ts;
+
+	tst_clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline uint64_t start_ticks(void)
+{
+	return use_tsc ? tst_tsc_read_start() : clock_ns();
+}
+
+static inline uint64_t end_ticks(void)
+{
+	return use_tsc ? tst_tsc_read_end() : clock_ns();
+}
+
+static void calibrate_clock(void)
+{
+	struct tst_tsc tsc;
+
+	if (use_clock || tst_tsc_calibrate(&tsc)) {
+		tst_res(TINFO, "Using CLOCK_MONOTONIC_RAW");
+		return;
+	}
+
+	use_tsc = 1;
+	ticks_per_ns = tsc.ticks_per_ns;
+
+	tst_res(TINFO, "Using cycle counter, %.3f ticks/ns, read %.2fns, overhead %.2fns",
+		ticks_per_ns, tsc.read_ns, tsc.overhead_ns);
+}
+
+static void noop(void)
+{
+	__asm__ __volatile__("" ::: "memory");
+}
+
+static double take_sample(void (*fn)(void))
+{
+	unsigned int i;
+	uint64_t start, end;
+
+	start = start_ticks();
+
+	for (i = 0; i < batch; i++)
+		fn();
+
+	end = end_ticks();
+
+	return (end - start) / ticks_per_ns / batch;
+}
+
+/*
+ * Doubles the batch size until a single sample takes at least BATCH_NS, that
+ * keeps the clock read cost and resolution negligible.
+ */
+static void size_batch(void)
+{
+	for (batch = 1; batch < MAX_BATCH; batch *= 2) {
+		if (take_sample(bench) * batch >= BATCH_NS)
+			break;
+	}
+}
+
+/* Avoids linking the library against libm */
+static double sqrtd(double x)
+{
+	double r = x;
+	int i;
+
+	if (x <= 0)
+		return 0;
+
+	for (i = 0; i < 64; i++)
+		r = (r + x / r) / 2;
+
+	return r;
+}
+
+static int cmp(const void *a, const void *b)
+{
+	const double *aa = a, *bb = b;
+
+	if (*aa < *bb)
+		return -1;
+
+	return *aa > *bb;
+}
+
+static double percentile(double p)
+{
+	unsigned int i = p * (sample_cnt - 1) / 100 + 0.5;
+
+	return samples[i];
+}
+
+static void measure_overhead(void)
+{
+	int i, n = MIN(sample_cnt, 100);
+
+	for (i = 0; i < n; i++)
+		samples[i] = take_sample(noop);
+
+	qsort(samples, n, sizeof(samples[0]), cmp);
+	overhead = samples[n / 2];
+}
+
+static void write_to_file(void)
+{
+	int i;
+	FILE *f;
+
+	if (!file_name)
+		return;
+
+	f = fopen(file_name, "w");
+	if (!f) {
+		tst_res(TWARN | TERRNO, "Failed to open '%s'", file_name);
+		return;
+	}
+
+	for (i = 0; i < sample_cnt; i++)
+		fprintf(f, "%.3f\n", samples[i]);
+
+	if (fclose(f))
+		tst_res(TWARN | TERRNO, "Failed to close file '%s'", file_name);
+}
+
+/*
+ * The baseline file has a "name<TAB>median_ns" line per benchmark so that a
+ * single file can be shared by several tests.
+ */
+static int read_baseline(const char *path, double *val)
+{
+	char line[512], name[256];
+	double v;
+	FILE *f;
+	int ret = 0;
+
+	f = fopen(path, "r");
+	if (!f)
+		return 0;
+
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "%255[^\t]\t%lf", name, &v) != 2)
+			continue;
+
+		if (!strcmp(name, scall)) {
+			*val = v;
+			ret = 1;
+		}
+	}
+
+	fclose(f);
+
+	return ret;
+}
+
+static void store_baseline(const char *path, double median)
+{
+	char line[512], tmp_path[PATH_MAX];
+	size_t len = strlen(scall);
+	FILE *in, *out;
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+	out = SAFE_FOPEN(tmp_path, "w");
+	in = fopen(path, "r");
+
+	if (in) {
+		while (fgets(line, sizeof(line), in)) {
+			if (!strncmp(line, scall, len) && line[len] == '\t')
+				continue;
+
+			fputs(line, out);
+		}
+
+		fclose(in);
+	}
+
+	fprintf(out, "%s\t%.3f\n", scall, median);
+	SAFE_FCLOSE(out);
+	SAFE_RENAME(tmp_path, path);
+
+	tst_res(TINFO, "Stored median %.2fns/op into '%s'", median, path);
+}
+
+/*
+ * Samples whose cost is above the third quartile by more than three
+ * interquartile ranges are interrupts, migrations and page faults rather
+ * than the measured operation, these are excluded from mean and deviation.
+ */
+static void report(void)
+{
+	double q1 = percentile(25), q3 = percentile(75);
+	double fence = q3 + 3 * (q3 - q1);
+	double median = percentile(50);
+	double mean = 0, dev = 0, base;
+	int i, kept = 0;
+
+	for (i = 0; i < sample_cnt && samples[i] <= fence; i++) {
+		mean += samples[i];
+		kept++;
+	}
+
+	mean /= kept;
+
+	for (i = 0; i < kept; i++)
+		dev += (samples[i] - mean) * (samples[i] - mean);
+
+	dev = sqrtd(dev / kept);
+
+	tst_res(TINFO,
+		"min %.2fns p50 %.2fns p90 %.2fns p99 %.2fns p99.9 %.2fns max %.2fns",
+		samples[0], median, percentile(90), percentile(99),
+		percentile(99.9), samples[sample_cnt - 1]);
+
+	tst_res(TINFO, "mean %.2fns/op stddev %.2fns (%i outliers rejected)",
+		mean, dev, sample_cnt - kept);
+
+	if (store_file)
+		store_baseline(store_file, median);
+
+	if (!baseline_file) {
+		tst_res(TPASS, "%s costs %.2fns/op", scall, median);
+		return;
+	}
+
+	if (!read_baseline(baseline_file, &base)) {
+		tst_res(TCONF, "No baseline for '%s' in '%s'", scall,
+			baseline_file);
+		return;
+	}
+
+	if (median > base * (100 + tolerance) / 100) {
+		tst_res(TFAIL, "%s %.2fns/op is %.1f%% slower than baseline %.2fns/op",
+			scall, median, 100 * (median - base) / base, base);
+		return;
+	}
+
+	tst_res(TPASS, "%s %.2fns/op is within %i%% of baseline %.2fns/op",
+		scall, median, tolerance, base);
+}
+
+static void do_bench(void)
+{
+	int i;
+
+	for (i = 0; i < warmup_cnt; i++)
+		take_sample(bench);
+
+	for (i = 0; i < sample_cnt; i++) {
+		samples[i] = take_sample(bench) - overhead;
+
+		/* keep the sample just taken, at least one is needed */
+		if (!(i % 100) && !tst_remaining_runtime()) {
+			sample_cnt = i + 1;
+			tst_res(TINFO, "Runtime exhausted after %i samples", sample_cnt);
+			break;
+		}
+	}
+
+	qsort(samples, sample_cnt, sizeof(samples[0]), cmp);
+	write_to_file();
+	report();
+}
+
+static void pin_cpu(void)
+{
+	cpu_set_t mask;
+
+	if (bench_cpu < 0)
+		bench_cpu = sched_getcpu();
+
+	if (bench_cpu < 0) {
+		tst_res(TINFO | TERRNO, "sched_getcpu() failed, not pinned");
+		return;
+	}
+
+	CPU_ZERO(&mask);
+	CPU_SET(bench_cpu, &mask);
+
+	if (sched_setaffinity(0, sizeof(mask), &mask))
+		tst_brk(TBROK | TERRNO, "sched_setaffinity(%i)", bench_cpu);
+}
+
+static void parse_bench_opts(void)
+{
+	if (tst_parse_int(str_sample_cnt, &sample_cnt, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid sample count '%s'", str_sample_cnt);
+
+	if (tst_parse_int(str_warmup_cnt, &warmup_cnt, 0, INT_MAX))
+		tst_brk(TBROK, "Invalid warmup count '%s'", str_warmup_cnt);
+
+	if (tst_parse_int(str_cpu, &bench_cpu, 0, CPU_SETSIZE - 1))
+		tst_brk(TBROK, "Invalid CPU '%s'", str_cpu);
+
+	if (tst_parse_int(str_tolerance, &tolerance, 0, INT_MAX))
+		tst_brk(TBROK, "Invalid tolerance '%s'", str_tolerance);
+}
+
+static void bench_setup(void)
+{
+	parse_bench_opts();
+
+	if (setup)
+		setup();
+
+	pin_cpu();
+	calibrate_clock();
+
+	samples = SAFE_MALLOC(sizeof(double) * MAX(sample_cnt, 100));
+
+	size_batch();
+	measure_overhead();
+
+	tst_res(TINFO, "%s: CPU %i, %i samples of %u ops, %i warmup, loop overhead %.2fns/op",
+		scall, bench_cpu, sample_cnt, batch, warmup_cnt, overhead);
+}
+
+static void bench_cleanup(void)
+{
+	free(samples);
+
+	if (cleanup)
+		cleanup();
+}
+
+static struct tst_option options[] = {
+	{"n:", &str_sample_cnt, "-n uint  Number of samples to take (default 1000)"},
+	{"w:", &str_warmup_cnt, "-w uint  Number of warmup samples (default 100)"},
+	{"c:", &str_cpu, "-c cpu   CPU to run on (default: the current one)"},
+	{"C", &use_clock, "-C       Use CLOCK_MONOTONIC_RAW instead of the cycle counter"},
+	{"b:", &baseline_file, "-b file  Compare the median against the baseline file"},
+	{"B:", &store_file, "-B file  Store the median into the baseline file"},
+	{"T:", &str_tolerance, "-T pct   Allowed slowdown against the baseline (default 10)"},
+	{"f:", &file_name, "-f file  Write measured ns/op samples into a file"},
+	{NULL, NULL, NULL}
+};
+
+struct tst_test *tst_bench_setup(struct tst_test *bench_test)
+{
+	setup = bench_test->setup;
+	cleanup = bench_test->cleanup;
+	scall = bench_test->scall;
+	bench = bench_test->bench;
+
+	if (!scall)
+		scall = "operation";
+
+	bench_test->scall = NULL;
+	bench_test->setup = bench_setup;
+	bench_test->cleanup = bench_cleanup;
+	bench_test->test_all = do_bench;
+	bench_test->bench = NULL;
+	bench_test->options = options;
+
+	if (!bench_test->runtime)
+		bench_test->runtime = 30;
+
+	test = bench_test;
+
+	return bench_test;
+}
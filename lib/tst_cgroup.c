@@ -172,12 +172,14 @@ static const struct cgroup_file cgroup_ctrl_files[] = {
 	{ "cgroup.subtree_control", NULL, 0 },
 	{ "cgroup.clone_children", "cgroup.clone_children", 0 },
 	{ "cgroup.kill", NULL, 0 },
+	{ "cgroup.events", NULL, 0 },
 	{ }
 };
 
 static const struct cgroup_file memory_ctrl_files[] = {
 	{ "memory.current", "memory.usage_in_bytes", CTRL_MEMORY },
 	{ "memory.events", NULL, CTRL_MEMORY },
+	{ "memory.high", NULL, CTRL_MEMORY },
 	{ "memory.low", NULL, CTRL_MEMORY },
 	{ "memory.min", NULL, CTRL_MEMORY },
 	{ "memory.max", "memory.limit_in_bytes", CTRL_MEMORY },
@@ -187,6 +189,10 @@ static const struct cgroup_file memory_ctrl_files[] = {
 	{ "memory.swap.max", "memory.memsw.limit_in_bytes", CTRL_MEMORY },
 	{ "memory.kmem.usage_in_bytes", "memory.kmem.usage_in_bytes", CTRL_MEMORY },
 	{ "memory.kmem.limit_in_bytes", "memory.kmem.limit_in_bytes", CTRL_MEMORY },
+	{ "memory.peak", "memory.max_usage_in_bytes", CTRL_MEMORY },
+	{ "memory.reclaim", NULL, CTRL_MEMORY },
+	/* PSI files are V2 core files, they exist in every V2 group */
+	{ "memory.pressure", NULL, 0 },
 	{ }
 };
 
@@ -199,6 +205,9 @@ static const struct cgroup_file cpu_ctrl_files[] = {
 	 */
 	{ "cpu.max", "cpu.cfs_quota_us", CTRL_CPU },
 	{ "cpu.cfs_period_us", "cpu.cfs_period_us", CTRL_CPU },
+	/* V1 cpu.stat has different content, the V2 one is a core file */
+	{ "cpu.stat", NULL, 0 },
+	{ "cpu.pressure", NULL, 0 },
 	{ }
 };
 
@@ -220,6 +229,7 @@ static const struct cgroup_file dmem_ctrl_files[] = {
 
 static const struct cgroup_file io_ctrl_files[] = {
 	{ "io.stat", NULL, CTRL_IO },
+	{ "io.pressure", NULL, 0 },
 	{ }
 };
 
@@ -696,6 +706,20 @@ void tst_cg_scan(void)
 	} while ((mnt = getmntent(f)));
 }
 
+int tst_cg_ctrl_mounted(const char *const ctrl_name)
+{
+	const struct cgroup_ctrl *const ctrl = cgroup_find_ctrl(ctrl_name, 1);
+
+	if (!ctrl) {
+		tst_brk(TBROK, "'%s' controller is unknown to LTP", ctrl_name);
+		return 0;
+	}
+
+	tst_cg_scan();
+
+	return !!ctrl->ctrl_root;
+}
+
 static void cgroup_mount_v2(void)
 {
 	int ret;
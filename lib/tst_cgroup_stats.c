@@ -0,0 +1,448 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) Linux Test Project, 2026
+ */
+
+/*
+ * Per test resource accounting enabled by LTP_CGROUP_STATS.
+ *
+ * Each fork_testrun() places the test process into a transient CGroup v2
+ * group created directly under the cgroup2 mount root. The statistics of the
+ * group cover all descendant processes of the test, unlike getrusage() on the
+ * main test pid. Processes the test moves into other CGroups (e.g. with
+ * .needs_cgroup_ctrls) are accounted only until they are moved.
+ *
+ * Everything here is best effort, missing files or a missing cgroup2 mount
+ * never affect the test result.
+ */
+
+#define TST_NO_DEFAULT_MAIN
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <mntent.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tst_test.h"
+#include "tst_private.h"
+
+#define STAT_BUF_SIZE 8192
+
+struct stat_desc {
+	const char *file;
+	/*
+	 * "key" matches either "key value" lines or "key=value" tokens,
+	 * the latter are summed over all lines (io.stat devices).
+	 * "line.key" matches "key=value" token on a line starting with
+	 * "line" (pressure files). NULL for single value files.
+	 */
+	const char *key;
+	const char *name;
+	int is_max;
+};
+
+static const struct stat_desc descs[] = {
+	{"cpu.stat", "usage_usec", "cpu.usage_usec", 0},
+	{"cpu.stat", "user_usec", "cpu.user_usec", 0},
+	{"cpu.stat", "system_usec", "cpu.system_usec", 0},
+	{"cpu.stat", "nr_throttled", "cpu.nr_throttled", 0},
+	{"cpu.stat", "throttled_usec", "cpu.throttled_usec", 0},
+	{"memory.peak", NULL, "memory.peak", 1},
+	{"memory.stat", "pgfault", "memory.pgfault", 0},
+	{"memory.stat", "pgmajfault", "memory.pgmajfault", 0},
+	{"memory.stat", "pgscan", "memory.pgscan", 0},
+	{"memory.stat", "pgsteal", "memory.pgsteal", 0},
+	{"memory.stat", "workingset_refault_anon", "memory.workingset_refault_anon", 0},
+	{"memory.stat", "workingset_refault_file", "memory.workingset_refault_file", 0},
+	{"memory.stat", "thp_fault_alloc", "memory.thp_fault_alloc", 0},
+	{"memory.events", "oom_kill", "memory.oom_kill", 0},
+	{"io.stat", "rbytes", "io.rbytes", 0},
+	{"io.stat", "wbytes", "io.wbytes", 0},
+	{"io.stat", "rios", "io.rios", 0},
+	{"io.stat", "wios", "io.wios", 0},
+	{"cpu.pressure", "some.total", "cpu.pressure.some_usec", 0},
+	{"memory.pressure", "some.total", "memory.pressure.some_usec", 0},
+	{"memory.pressure", "full.total", "memory.pressure.full_usec", 0},
+	{"io.pressure", "some.total", "io.pressure.some_usec", 0},
+	{"io.pressure", "full.total", "io.pressure.full_usec", 0},
+};
+
+#define DESC_CNT ARRAY_SIZE(descs)
+
+static const char *const ctrls[] = {"cpu", "memory", "io"};
+
+static char mnt_path[PATH_MAX];
+static char group_path[PATH_MAX + 64];
+static int enabled;
+static int group_created;
+static unsigned int run_cnt;
+
+static uint64_t totals[DESC_CNT];
+static int have_total[DESC_CNT];
+
+static void remove_group(void);
+
+static int find_cgroup2_mnt(void)
+{
+	struct mntent *mnt;
+	FILE *f = setmntent("/proc/self/mounts", "r");
+
+	if (!f)
+		return 0;
+
+	while ((mnt = getmntent(f))) {
+		if (!strcmp(mnt->mnt_type, "cgroup2")) {
+			snprintf(mnt_path, sizeof(mnt_path), "%s", mnt->mnt_dir);
+			endmntent(f);
+			return 1;
+		}
+	}
+
+	endmntent(f);
+	return 0;
+}
+
+static int write_file(const char *dir, const char *file, const char *val)
+{
+	char path[PATH_MAX + 128];
+	ssize_t len = strlen(val), ret;
+	int fd, err;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, file);
+
+	fd = open(path, O_WRONLY);
+	if (fd < 0)
+		return -1;
+
+	ret = write(fd, val, len);
+	err = errno;
+	close(fd);
+	errno = err;
+
+	return ret == len ? 0 : -1;
+}
+
+static ssize_t read_file(const char *dir, const char *file, char *buf,
+			 size_t size)
+{
+	char path[PATH_MAX + 128];
+	ssize_t ret, len = 0;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, file);
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	while ((size_t)len < size - 1) {
+		ret = read(fd, buf + len, size - len - 1);
+		if (ret <= 0)
+			break;
+		len += ret;
+	}
+
+	close(fd);
+	buf[len] = '\0';
+
+	return len;
+}
+
+/*
+ * The root cgroup.subtree_control is shared with everything else on the
+ * system, so it is left alone. Controllers that are not enabled there only
+ * miss their statistics, cpu.stat usage is always available.
+ */
+static void check_ctrls(void)
+{
+	char buf[256], *tok, *save;
+	unsigned int i, found = 0;
+
+	if (read_file(mnt_path, "cgroup.subtree_control", buf, sizeof(buf)) < 0)
+		return;
+
+	for (tok = strtok_r(buf, " \n", &save); tok;
+	     tok = strtok_r(NULL, " \n", &save)) {
+		for (i = 0; i < ARRAY_SIZE(ctrls); i++) {
+			if (!strcmp(tok, ctrls[i]))
+				found |= 1 << i;
+		}
+	}
+
+	buf[0] = '\0';
+	for (i = 0; i < ARRAY_SIZE(ctrls); i++) {
+		if (!(found & (1 << i))) {
+			strcat(buf, " ");
+			strcat(buf, ctrls[i]);
+		}
+	}
+
+	if (buf[0]) {
+		tst_res(TINFO, "LTP_CGROUP_STATS:%s not enabled in %s/cgroup.subtree_control, not collected",
+			buf, mnt_path);
+	}
+}
+
+void tst_cg_stats_init(void)
+{
+	char path[PATH_MAX + 32];
+
+	if (!find_cgroup2_mnt()) {
+		tst_res(TINFO, "LTP_CGROUP_STATS: cgroup2 is not mounted, resource usage not collected");
+		return;
+	}
+
+	snprintf(path, sizeof(path), "%s/cgroup.procs", mnt_path);
+	if (access(path, W_OK)) {
+		tst_res(TINFO | TERRNO, "LTP_CGROUP_STATS: cannot write %s, resource usage not collected",
+			path);
+		return;
+	}
+
+	check_ctrls();
+	enabled = 1;
+
+	tst_res(TINFO, "Collecting resource usage in %s", mnt_path);
+}
+
+void tst_cg_stats_start(void)
+{
+	if (!enabled)
+		return;
+
+	/* The previous run did not reach tst_cg_stats_stop() */
+	if (group_created)
+		remove_group();
+
+	snprintf(group_path, sizeof(group_path), "%s/ltp_stats_%d_%u",
+		 mnt_path, getpid(), run_cnt++);
+
+	if (mkdir(group_path, 0755)) {
+		tst_res(TINFO | TERRNO, "mkdir(%s), resource usage not collected",
+			group_path);
+		return;
+	}
+
+	group_created = 1;
+}
+
+void tst_cg_stats_attach(void)
+{
+	if (!group_created)
+		return;
+
+	if (write_file(group_path, "cgroup.procs", "0")) {
+		tst_res(TINFO | TERRNO, "Failed to move test to %s", group_path);
+		group_created = 0;
+	}
+}
+
+static char *match_token(char *line, const char *key)
+{
+	size_t len = strlen(key);
+	char *tok, *save;
+
+	for (tok = strtok_r(line, " \n", &save); tok;
+	     tok = strtok_r(NULL, " \n", &save)) {
+		if (!strncmp(tok, key, len) && tok[len] == '=')
+			return tok + len + 1;
+	}
+
+	return NULL;
+}
+
+static int parse_stat(char *buf, const char *key, uint64_t *val)
+{
+	const char *dot;
+	char *line, *next, *str;
+	char first[64];
+	int found = 0;
+
+	if (!key)
+		return sscanf(buf, "%" SCNu64, val) == 1;
+
+	dot = strchr(key, '.');
+
+	*val = 0;
+
+	for (line = buf; line && *line; line = next) {
+		uint64_t v;
+
+		next = strchr(line, '\n');
+		if (next)
+			*next++ = '\0';
+
+		if (sscanf(line, "%63s", first) != 1)
+			continue;
+
+		if (dot) {
+			if (strncmp(first, key, dot - key) || first[dot - key])
+				continue;
+
+			str = match_token(line, dot + 1);
+		} else if (!strcmp(first, key)) {
+			str = line + strlen(first);
+		} else {
+			str = match_token(line, key);
+		}
+
+		if (str && sscanf(str, "%" SCNu64, &v) == 1) {
+			*val += v;
+			found = 1;
+		}
+	}
+
+	return found;
+}
+
+static void collect(uint64_t vals[], int have[])
+{
+	char buf[STAT_BUF_SIZE], copy[STAT_BUF_SIZE];
+	const char *loaded = NULL;
+	unsigned int i;
+	ssize_t len = -1;
+
+	for (i = 0; i < DESC_CNT; i++) {
+		if (!loaded || strcmp(loaded, descs[i].file)) {
+			loaded = descs[i].file;
+			len = read_file(group_path, loaded, buf, sizeof(buf));
+		}
+
+		if (len < 0)
+			continue;
+
+		memcpy(copy, buf, len + 1);
+		have[i] = parse_stat(copy, descs[i].key, &vals[i]);
+	}
+}
+
+static void kill_leftovers(void)
+{
+	char buf[STAT_BUF_SIZE], *line, *save;
+	int i;
+
+	if (!write_file(group_path, "cgroup.kill", "1"))
+		return;
+
+	/* cgroup.kill is available since v5.14 */
+	for (i = 0; i < 10; i++) {
+		if (read_file(group_path, "cgroup.procs", buf, sizeof(buf)) <= 0)
+			return;
+
+		for (line = strtok_r(buf, "\n", &save); line;
+		     line = strtok_r(NULL, "\n", &save))
+			kill(atoi(line), SIGKILL);
+
+		usleep(10000);
+	}
+}
+
+static void remove_group(void)
+{
+	int i;
+
+	kill_leftovers();
+
+	group_created = 0;
+
+	for (i = 0; i < 100; i++) {
+		if (!rmdir(group_path))
+			return;
+
+		if (errno != EBUSY)
+			break;
+
+		usleep(10000);
+	}
+
+	tst_res(TINFO | TERRNO, "Failed to remove %s", group_path);
+}
+
+static int find_desc(const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < DESC_CNT; i++) {
+		if (!strcmp(descs[i].name, name))
+			return i;
+	}
+
+	return -1;
+}
+
+void tst_cg_stats_stop(void)
+{
+	uint64_t vals[DESC_CNT] = {};
+	int have[DESC_CNT] = {};
+	int usage = find_desc("cpu.usage_usec");
+	int user = find_desc("cpu.user_usec");
+	int sys = find_desc("cpu.system_usec");
+	int peak = find_desc("memory.peak");
+	unsigned int i;
+
+	if (!group_created)
+		return;
+
+	collect(vals, have);
+	remove_group();
+
+	for (i = 0; i < DESC_CNT; i++) {
+		if (!have[i])
+			continue;
+
+		if (descs[i].is_max)
+			totals[i] = MAX(totals[i], vals[i]);
+		else
+			totals[i] += vals[i];
+
+		have_total[i] = 1;
+	}
+
+	if (!have[usage])
+		return;
+
+	if (have[peak]) {
+		tst_res(TINFO, "Used CPU %.3fs (user %.3fs, system %.3fs), memory peak %" PRIu64 " kB",
+			vals[usage] / 1000000.0, vals[user] / 1000000.0,
+			vals[sys] / 1000000.0, vals[peak] / 1024);
+	} else {
+		tst_res(TINFO, "Used CPU %.3fs (user %.3fs, system %.3fs)",
+			vals[usage] / 1000000.0, vals[user] / 1000000.0,
+			vals[sys] / 1000000.0);
+	}
+}
+
+void tst_cg_stats_print(void)
+{
+	unsigned int i;
+	int printed = 0;
+
+	for (i = 0; i < DESC_CNT; i++) {
+		if (!have_total[i])
+			continue;
+
+		if (!printed) {
+			fprintf(stderr, "\nResource usage:\n");
+			printed = 1;
+		}
+
+		fprintf(stderr, "%-32s %" PRIu64 "\n", descs[i].name, totals[i]);
+	}
+}
+
+void tst_cg_stats_cleanup(void)
+{
+	if (!enabled)
+		return;
+
+	if (group_created)
+		remove_group();
+
+	enabled = 0;
+}
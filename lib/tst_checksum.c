@@ -1,8 +1,18 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 /* Copyright (c) 2018 Oracle and/or its affiliates. All Rights Reserved. */
 
+#include <string.h>
+
+#include "config.h"
 #include "tst_checksum.h"
 
+#if defined(__aarch64__) && defined(HAVE_GETAUXVAL)
+# include <sys/auxv.h>
+# ifndef HWCAP_CRC32
+#  define HWCAP_CRC32 (1 << 7)
+# endif
+#endif
+
 static const uint32_t crc32c_table[] = {
 	0x00000000, 0xf26b8303, 0xe13b70f7, 0x1350f3f4,
 	0xc79a971f, 0x35f1141c, 0x26a1e7e8, 0xd4ca64eb,
@@ -70,12 +80,146 @@ static const uint32_t crc32c_table[] = {
 	0xbe2da0a5, 0x4c4623a6, 0x5f16d052, 0xad7d5351,
 };
 
-uint32_t tst_crc32c(uint8_t *buf, size_t buf_len)
+/* crc32c_table extended for slice-by-8, crc32c_slice[0] == crc32c_table */
+static uint32_t crc32c_slice[8][256];
+
+static uint32_t crc32c_sw(uint32_t crc, const uint8_t *p, size_t len)
+{
+	const uint32_t (*t)[256] = (const uint32_t (*)[256])crc32c_slice;
+
+	while (len >= 8) {
+		crc ^= p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+		crc = t[7][crc & 0xff] ^ t[6][(crc >> 8) & 0xff] ^
+		      t[5][(crc >> 16) & 0xff] ^ t[4][crc >> 24] ^
+		      t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+		p += 8;
+		len -= 8;
+	}
+
+	while (len--)
+		crc = crc32c_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+
+	return crc;
+}
+
+#if defined(__x86_64__)
+
+static uint32_t crc32c_hw(uint32_t crc, const uint8_t *p, size_t len)
+{
+	uint64_t crc64, val;
+
+	for (; len && ((uintptr_t)p & 7); len--, p++)
+		__asm__("crc32b %1, %0" : "+r" (crc) : "rm" (*p));
+
+	crc64 = crc;
+	for (; len >= 8; len -= 8, p += 8) {
+		memcpy(&val, p, sizeof(val));
+		__asm__("crc32q %1, %0" : "+r" (crc64) : "rm" (val));
+	}
+	crc = crc64;
+
+	for (; len; len--, p++)
+		__asm__("crc32b %1, %0" : "+r" (crc) : "rm" (*p));
+
+	return crc;
+}
+
+static int crc32c_hw_supported(void)
+{
+	/* may run before the libgcc constructor that initializes the data */
+	__builtin_cpu_init();
+
+	return __builtin_cpu_supports("sse4.2");
+}
+
+#elif defined(__aarch64__) && defined(HAVE_GETAUXVAL)
+
+static uint32_t crc32c_hw(uint32_t crc, const uint8_t *p, size_t len)
 {
-	uint32_t crc = 0xffffffff;
+	uint64_t val;
 
-	while (buf_len--)
-		crc = crc32c_table[(crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
+	for (; len && ((uintptr_t)p & 7); len--, p++) {
+		__asm__(".arch_extension crc\n\tcrc32cb %w0, %w0, %w1"
+			: "+r" (crc) : "r" ((uint32_t)*p));
+	}
+
+	for (; len >= 8; len -= 8, p += 8) {
+		memcpy(&val, p, sizeof(val));
+		__asm__(".arch_extension crc\n\tcrc32cx %w0, %w0, %x1"
+			: "+r" (crc) : "r" (val));
+	}
+
+	for (; len; len--, p++) {
+		__asm__(".arch_extension crc\n\tcrc32cb %w0, %w0, %w1"
+			: "+r" (crc) : "r" ((uint32_t)*p));
+	}
+
+	return crc;
+}
+
+static int crc32c_hw_supported(void)
+{
+	return !!(getauxval(AT_HWCAP) & HWCAP_CRC32);
+}
 
+#else
+
+# define crc32c_hw crc32c_sw
+
+static int crc32c_hw_supported(void)
+{
+	return 0;
+}
+
+#endif
+
+static uint32_t (*crc32c_update_fn)(uint32_t crc, const uint8_t *p, size_t len);
+
+__attribute__((constructor))
+static void crc32c_setup(void)
+{
+	uint32_t crc;
+	int i, k;
+
+	memcpy(crc32c_slice[0], crc32c_table, sizeof(crc32c_table));
+
+	for (i = 0; i < 256; i++) {
+		crc = crc32c_table[i];
+		for (k = 1; k < 8; k++) {
+			crc = crc32c_table[crc & 0xff] ^ (crc >> 8);
+			crc32c_slice[k][i] = crc;
+		}
+	}
+
+	crc32c_update_fn = crc32c_hw_supported() ? crc32c_hw : crc32c_sw;
+}
+
+int tst_crc32c_use_hw(int enable)
+{
+	int hw = enable && crc32c_hw_supported();
+
+	crc32c_update_fn = hw ? crc32c_hw : crc32c_sw;
+
+	return hw;
+}
+
+uint32_t tst_crc32c_init(void)
+{
+	return 0xffffffff;
+}
+
+uint32_t tst_crc32c_update(uint32_t crc, const void *buf, size_t buf_len)
+{
+	return crc32c_update_fn(crc, buf, buf_len);
+}
+
+uint32_t tst_crc32c_final(uint32_t crc)
+{
 	return ~crc;
 }
+
+uint32_t tst_crc32c(uint8_t *buf, size_t buf_len)
+{
+	return tst_crc32c_final(tst_crc32c_update(tst_crc32c_init(), buf,
+						  buf_len));
+}
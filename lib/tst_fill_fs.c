@@ -16,24 +16,39 @@
 #include "tst_rand_data.h"
 #include "tst_safe_file_at.h"
 
+#define FILL_BUF_LEN (64 * 1024)
+#define FILL_IOV_LEN 4096
+
+/*
+ * The content of fileN is the tst_rand_data_fill() stream with seed + N, the
+ * seed is printed so that the data can be regenerated and verified.
+ */
 static void fill_random(const char *path, int verbose)
 {
-	int i = 0;
+	int i;
 	char file[PATH_MAX];
-	size_t len;
+	char *buf = SAFE_MALLOC(FILL_BUF_LEN);
+	uint64_t seed = random();
+	uint64_t off;
+	size_t len, chunk;
 	ssize_t ret;
 	int fd;
 	struct statvfs fi;
 
 	statvfs(path, &fi);
 
-	for (;;) {
+	tst_res(TINFO, "Filling %s with random data, seed %llu", path,
+		(unsigned long long)seed);
+
+	for (i = 0; ; i++) {
 		len = random() % (1024 * 102400);
 
-		snprintf(file, sizeof(file), "%s/file%i", path, i++);
+		snprintf(file, sizeof(file), "%s/file%i", path, i);
 
-		if (verbose)
-			tst_res(TINFO, "Creating file %s size %zu", file, len);
+		if (verbose) {
+			tst_res(TINFO, "Creating file %s size %zu seed %llu", file,
+				len, (unsigned long long)(seed + i));
+		}
 
 		fd = open(file, O_WRONLY | O_CREAT, 0700);
 		if (fd == -1) {
@@ -41,11 +56,15 @@ static void fill_random(const char *path, int verbose)
 				tst_brk(TBROK | TERRNO, "open()");
 
 			tst_res(TINFO | TERRNO, "open()");
-			return;
+			break;
 		}
 
+		off = 0;
+
 		while (len) {
-			ret = write(fd, tst_rand_data, MIN(len, tst_rand_data_len));
+			chunk = MIN(len, FILL_BUF_LEN);
+			tst_rand_data_fill(seed + i, off, buf, chunk);
+			ret = write(fd, buf, chunk);
 
 			if (ret < 0) {
 				/* retry on ENOSPC to make sure filesystem is really full */
@@ -61,14 +80,18 @@ static void fill_random(const char *path, int verbose)
 					tst_brk(TBROK | TERRNO, "write()");
 
 				tst_res(TINFO | TERRNO, "write()");
+				free(buf);
 				return;
 			}
 
 			len -= ret;
+			off += ret;
 		}
 
 		SAFE_CLOSE(fd);
 	}
+
+	free(buf);
 }
 
 static void fill_flat_vec(const char *path, int verbose)
@@ -77,6 +100,9 @@ static void fill_flat_vec(const char *path, int verbose)
 	struct iovec iov[512];
 	int iovcnt = ARRAY_SIZE(iov);
 	int retries = 3;
+	uint64_t seed = random();
+	uint64_t off = 0;
+	char *buf;
 
 	dir = open(path, O_PATH | O_DIRECTORY);
 	if (dir == -1) {
@@ -99,20 +125,29 @@ static void fill_flat_vec(const char *path, int verbose)
 
 	SAFE_CLOSE(dir);
 
+	buf = SAFE_MALLOC(iovcnt * FILL_IOV_LEN);
+
+	tst_res(TINFO, "Filling %s/AOF with random data, seed %llu", path,
+		(unsigned long long)seed);
+
 	for (int i = 0; i < iovcnt; i++) {
 		iov[i] = (struct iovec) {
-			(void *)tst_rand_data,
-			tst_rand_data_len
+			buf + i * FILL_IOV_LEN,
+			FILL_IOV_LEN
 		};
 	}
 
 	while (retries) {
+		tst_rand_data_fill(seed, off, buf, iovcnt * FILL_IOV_LEN);
+
 		const int ret = writev(fd, iov, iovcnt);
 
 		if (!ret)
 			tst_res(TWARN | TERRNO, "writev returned 0; not sure what this means");
 
 		if (ret > -1) {
+			off += ret;
+
 			if (verbose && retries < 3)
 				tst_res(TINFO, "writev(\"%s/AOF\", iov, %d) = %d", path, iovcnt, ret);
 
@@ -129,6 +164,7 @@ static void fill_flat_vec(const char *path, int verbose)
 		retries--;
 	}
 
+	free(buf);
 	SAFE_CLOSE(fd);
 }
 
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) Linux Test Project, 2026
+ */
+
+#include "tst_hist.h"
+
+uint64_t tst_hist_bucket_min(unsigned int bucket)
+{
+	unsigned int shift = bucket / TST_HIST_SUB;
+
+	if (!shift)
+		return bucket;
+
+	return (uint64_t)(TST_HIST_SUB + bucket % TST_HIST_SUB) << (shift - 1);
+}
+
+uint64_t tst_hist_bucket_max(unsigned int bucket)
+{
+	if (bucket + 1 >= TST_HIST_BUCKETS)
+		return UINT64_MAX;
+
+	return tst_hist_bucket_min(bucket + 1) - 1;
+}
+
+void tst_hist_merge(struct tst_hist *dst, const struct tst_hist *src)
+{
+	uint64_t old;
+	unsigned int i;
+
+	if (!src->samples)
+		return;
+
+	for (i = 0; i < TST_HIST_BUCKETS; i++) {
+		if (src->buckets[i])
+			__atomic_add_fetch(&dst->buckets[i], src->buckets[i],
+					   __ATOMIC_RELAXED);
+	}
+
+	__atomic_add_fetch(&dst->sum, src->sum, __ATOMIC_RELAXED);
+
+	old = __atomic_load_n(&dst->max, __ATOMIC_RELAXED);
+	while (src->max > old &&
+	       !__atomic_compare_exchange_n(&dst->max, &old, src->max, 0,
+					    __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+
+	/*
+	 * The min of an empty dst is 0 as well, but a real 0 min is counted in
+	 * the first bucket, which is updated before the min.
+	 */
+	old = __atomic_load_n(&dst->min, __ATOMIC_RELAXED);
+	while (((!old && !__atomic_load_n(&dst->buckets[0], __ATOMIC_RELAXED)) ||
+		src->min < old) &&
+	       !__atomic_compare_exchange_n(&dst->min, &old, src->min, 0,
+					    __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+
+	__atomic_add_fetch(&dst->samples, src->samples, __ATOMIC_RELAXED);
+}
+
+uint64_t tst_hist_percentile(const struct tst_hist *hist, double pct)
+{
+	uint64_t cnt = 0, want = hist->samples * pct / 100;
+	unsigned int i;
+
+	if (!hist->samples)
+		return 0;
+
+	if (want < 1)
+		want = 1;
+
+	for (i = 0; i < TST_HIST_BUCKETS; i++) {
+		cnt += hist->buckets[i];
+		if (cnt >= want)
+			break;
+	}
+
+	if (i == TST_HIST_BUCKETS || tst_hist_bucket_max(i) > hist->max)
+		return hist->max;
+
+	return tst_hist_bucket_max(i);
+}
@@ -0,0 +1,975 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) Linux Test Project, 2026
+ */
+
+/*
+ * Declarative network topology setup. The topology is described by a list
+ * of commands separated by newlines or semicolons, text after '#' is
+ * ignored:
+ *
+ * netns NAME
+ *	Create network namespace /var/run/netns/NAME (like ip netns add).
+ * veth NAME PEER [ns=NS] [peerns=NS] [mtu=N]
+ *	Create veth pair, the peer may be created directly in another netns.
+ * link NAME KIND [ns=NS] [mtu=N] [dev=IFACE] [id=N] [remote=ADDR]
+ *                [local=ADDR] [dstport=N]
+ *	Create device of given kind (dummy, vxlan, geneve, wireguard, ...).
+ *	id, remote, local and dstport are supported for vxlan and geneve,
+ *	dev is the lower device.
+ * move NAME NS [ns=NS]
+ *	Move device to another network namespace.
+ * up NAME [ns=NS] [mtu=N]
+ *	Set device up.
+ * addr NAME ADDR[/PREFIX] [ns=NS] [nodad] [noprefixroute]
+ *	Add IPv4 or IPv6 address to device.
+ * route DST[/PREFIX]|default [via=ADDR] [dev=IFACE] [ns=NS]
+ *	Add static route to the main table.
+ *
+ * NS is the name of a namespace in /var/run/netns, a PID or a path to
+ * a namespace file. Commands without ns= are executed in the current
+ * namespace.
+ *
+ * Consecutive requests for the same namespace are queued and sent in a single
+ * sendmsg() call, acks are checked once per batch. A batch is flushed early
+ * only when an interface index of a newly created or moved device is needed.
+ */
+
+#define _GNU_SOURCE
+#include <sched.h>
+#include <sys/mount.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/veth.h>
+#include "lapi/if_addr.h"
+#include "lapi/rtnetlink.h"
+
+#define TST_NO_DEFAULT_MAIN
+#include "tst_test.h"
+#include "tst_netlink.h"
+#include "tst_netdevice.h"
+
+#define TOPO_MAX_NS 16
+#define TOPO_MAX_BATCH 256
+#define TOPO_MAX_ARGS 16
+#define TOPO_CMD_LEN 128
+#define NETNS_RUN_DIR "/var/run/netns"
+
+struct topo_ns {
+	char *name;
+	int fd;
+	int sock;
+	uint32_t seq;
+	struct tst_netlink_context *ctx;
+};
+
+struct topo {
+	const char *file;
+	int lineno;
+	int strict;
+	int self_fd;
+
+	struct topo_ns ns[TOPO_MAX_NS];
+	int ns_cnt;
+
+	/* Command being parsed */
+	char cmd[TOPO_CMD_LEN];
+	char *args[TOPO_MAX_ARGS];
+	int argc;
+	int nargs;
+
+	/* Requests queued for sending */
+	struct topo_ns *pending;
+	int pending_links;
+	uint32_t first_seq;
+	char desc[TOPO_MAX_BATCH][TOPO_CMD_LEN];
+	int desc_cnt;
+};
+
+static int topo_flush(struct topo *t)
+{
+	struct topo_ns *ns = t->pending;
+	struct tst_netlink_message *response, *res;
+	const char *desc = NULL;
+	uint32_t idx;
+	int ret;
+
+	if (!ns)
+		return 1;
+
+	t->pending = NULL;
+	t->pending_links = 0;
+	tst_netlink_errno = 0;
+
+	if (tst_netlink_send(t->file, t->lineno, ns->ctx) <= 0)
+		return 0;
+
+	/* tst_netlink_send() terminates multipart batch with NLMSG_DONE */
+	if (t->desc_cnt > 1)
+		ns->seq++;
+
+	tst_netlink_wait(ns->ctx);
+	response = tst_netlink_recv(t->file, t->lineno, ns->ctx);
+
+	if (!response) {
+		tst_brk_(t->file, t->lineno, TBROK,
+			"No response to netlink requests");
+		return 0;
+	}
+
+	ret = tst_netlink_check_acks(t->file, t->lineno, ns->ctx, response);
+
+	if (!ret) {
+		for (res = response; res->header; res++) {
+			if (!res->err || !res->err->error)
+				continue;
+
+			idx = res->err->msg.nlmsg_seq - t->first_seq;
+
+			if (idx < (uint32_t)t->desc_cnt)
+				desc = t->desc[idx];
+
+			break;
+		}
+	}
+
+	tst_netlink_free_message(response);
+
+	if (!ret && t->strict && tst_netlink_errno) {
+		tst_brk_(t->file, t->lineno, TBROK,
+			"Failed to set up '%s': %s", desc ? desc : "topology",
+			tst_strerrno(tst_netlink_errno));
+	}
+
+	return ret;
+}
+
+static struct tst_netlink_context *topo_request(struct topo *t,
+	struct topo_ns *ns, unsigned int type, unsigned int flags,
+	const void *payload, size_t psize, int link_change)
+{
+	struct nlmsghdr header = {
+		.nlmsg_type = type,
+		.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | flags,
+	};
+
+	if (t->pending && (t->pending != ns || t->desc_cnt >= TOPO_MAX_BATCH)) {
+		if (!topo_flush(t))
+			return NULL;
+	}
+
+	if (!t->pending) {
+		t->pending = ns;
+		t->first_seq = ns->seq;
+		t->desc_cnt = 0;
+	}
+
+	if (!tst_netlink_add_message(t->file, t->lineno, ns->ctx, &header,
+		payload, psize))
+		return NULL;
+
+	ns->seq++;
+	strcpy(t->desc[t->desc_cnt++], t->cmd);
+	t->pending_links |= link_change;
+
+	return ns->ctx;
+}
+
+static int topo_ifname_check(struct topo *t, const char *ifname)
+{
+	if (strlen(ifname) < IFNAMSIZ)
+		return 1;
+
+	tst_brk_(t->file, t->lineno, TBROK,
+		"Network device name \"%s\" too long", ifname);
+	return 0;
+}
+
+static int topo_index(struct topo *t, struct topo_ns *ns, const char *ifname)
+{
+	struct ifreq ifr;
+
+	if (!topo_ifname_check(t, ifname))
+		return -1;
+
+	/* The device may be created or moved by a queued request */
+	if (t->pending_links && !topo_flush(t))
+		return -1;
+
+	memset(&ifr, 0, sizeof(ifr));
+	strcpy(ifr.ifr_name, ifname);
+
+	if (ioctl(ns->sock, SIOCGIFINDEX, &ifr)) {
+		tst_brk_(t->file, t->lineno, TBROK | TERRNO,
+			"Interface %s not found", ifname);
+		return -1;
+	}
+
+	return ifr.ifr_ifindex;
+}
+
+static int topo_ns_fd(struct topo *t, struct topo_ns *ns)
+{
+	return ns->fd >= 0 ? ns->fd : t->self_fd;
+}
+
+static struct topo_ns *topo_get_ns(struct topo *t, const char *name)
+{
+	struct topo_ns *ns;
+	char path[PATH_MAX];
+	int i, fd;
+
+	if (!name)
+		return &t->ns[0];
+
+	for (i = 1; i < t->ns_cnt; i++) {
+		if (!strcmp(t->ns[i].name, name))
+			return &t->ns[i];
+	}
+
+	if (t->ns_cnt >= TOPO_MAX_NS) {
+		tst_brk_(t->file, t->lineno, TBROK,
+			"Too many network namespaces in topology");
+		return NULL;
+	}
+
+	if (strchr(name, '/'))
+		snprintf(path, sizeof(path), "%s", name);
+	else if (strspn(name, "0123456789") == strlen(name))
+		snprintf(path, sizeof(path), "/proc/%s/ns/net", name);
+	else
+		snprintf(path, sizeof(path), NETNS_RUN_DIR "/%s", name);
+
+	fd = safe_open(t->file, t->lineno, NULL, path, O_RDONLY | O_CLOEXEC);
+
+	if (fd < 0)
+		return NULL;
+
+	ns = &t->ns[t->ns_cnt];
+	ns->fd = fd;
+	ns->seq = 0;
+
+	/* Sockets stay bound to the namespace they were created in */
+	if (safe_setns(t->file, t->lineno, fd, CLONE_NEWNET)) {
+		safe_close(t->file, t->lineno, NULL, fd);
+		return NULL;
+	}
+
+	ns->sock = safe_socket(t->file, t->lineno, NULL, AF_INET,
+		SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	ns->ctx = tst_netlink_create_context(t->file, t->lineno,
+		NETLINK_ROUTE);
+	safe_setns(t->file, t->lineno, t->self_fd, CLONE_NEWNET);
+
+	if (ns->sock < 0 || !ns->ctx) {
+		if (ns->sock >= 0)
+			safe_close(t->file, t->lineno, NULL, ns->sock);
+
+		tst_netlink_destroy_context(t->file, t->lineno, ns->ctx);
+		safe_close(t->file, t->lineno, NULL, fd);
+		return NULL;
+	}
+
+	ns->name = strdup(name);
+	t->ns_cnt++;
+
+	return ns;
+}
+
+static const char *topo_opt(struct topo *t, const char *key)
+{
+	size_t len = strlen(key);
+	int i;
+
+	for (i = t->nargs; i < t->argc; i++) {
+		if (!strncmp(t->args[i], key, len) && t->args[i][len] == '=')
+			return t->args[i] + len + 1;
+
+		if (!strcmp(t->args[i], key))
+			return t->args[i];
+	}
+
+	return NULL;
+}
+
+/*
+ * Check the command arguments, nargs is the number of positional arguments,
+ * opts is a space separated list of allowed options.
+ */
+static int topo_check_args(struct topo *t, int nargs, const char *opts)
+{
+	const char *opt, *end;
+	size_t len;
+	int i;
+
+	if (t->argc < nargs) {
+		tst_brk_(t->file, t->lineno, TBROK,
+			"Missing argument in '%s'", t->cmd);
+		return 0;
+	}
+
+	t->nargs = nargs;
+
+	for (i = nargs; i < t->argc; i++) {
+		end = strchr(t->args[i], '=');
+		len = end ? (size_t)(end - t->args[i]) : strlen(t->args[i]);
+
+		for (opt = opts; opt && *opt; opt += strcspn(opt, " ")) {
+			opt += strspn(opt, " ");
+
+			if (strcspn(opt, " ") == len &&
+			    !strncmp(opt, t->args[i], len))
+				break;
+		}
+
+		if (!opt || !*opt) {
+			tst_brk_(t->file, t->lineno, TBROK,
+				"Invalid argument '%s' in '%s'", t->args[i],
+				t->cmd);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static int topo_parse_uint(struct topo *t, const char *str, uint32_t *val)
+{
+	char *end;
+	unsigned long ret;
+
+	errno = 0;
+	ret = strtoul(str, &end, 0);
+
+	if (errno || !*str || *end || ret > UINT32_MAX) {
+		tst_brk_(t->file, t->lineno, TBROK, "Invalid number '%s' in '%s'",
+			str, t->cmd);
+		return 0;
+	}
+
+	*val = ret;
+	return 1;
+}
+
+/* Parse optional numeric option, val is left unchanged if not present */
+static int topo_opt_uint(struct topo *t, const char *key, uint32_t *val,
+	uint32_t max)
+{
+	const char *opt = topo_opt(t, key);
+
+	if (!opt)
+		return 1;
+
+	if (!topo_parse_uint(t, opt, val))
+		return 0;
+
+	if (*val > max) {
+		tst_brk_(t->file, t->lineno, TBROK, "Invalid %s in '%s'", key,
+			t->cmd);
+		return 0;
+	}
+
+	return 1;
+}
+
+/* Returns address length, 0 on error */
+static size_t topo_parse_addr(struct topo *t, const char *str,
+	unsigned int *family, void *addr, unsigned int *prefix)
+{
+	char buf[INET6_ADDRSTRLEN + 8], *slash;
+	uint32_t val;
+
+	snprintf(buf, sizeof(buf), "%s", str);
+	slash = strchr(buf, '/');
+
+	if (slash)
+		*slash++ = '\0';
+
+	if (inet_pton(AF_INET, buf, addr) == 1) {
+		*family = AF_INET;
+		val = 32;
+	} else if (inet_pton(AF_INET6, buf, addr) == 1) {
+		*family = AF_INET6;
+		val = 128;
+	} else {
+		tst_brk_(t->file, t->lineno, TBROK,
+			"Invalid address '%s' in '%s'", str, t->cmd);
+		return 0;
+	}
+
+	if (prefix) {
+		if (slash && (!topo_parse_uint(t, slash, prefix) ||
+		    *prefix > val)) {
+			tst_brk_(t->file, t->lineno, TBROK,
+				"Invalid prefix '%s' in '%s'", str, t->cmd);
+			return 0;
+		}
+
+		if (!slash)
+			*prefix = val;
+	} else if (slash) {
+		tst_brk_(t->file, t->lineno, TBROK,
+			"Unexpected prefix '%s' in '%s'", str, t->cmd);
+		return 0;
+	}
+
+	return *family == AF_INET ? 4 : 16;
+}
+
+static int topo_netns(struct topo *t)
+{
+	char path[PATH_MAX];
+	pid_t pid;
+	int status, fd;
+
+	if (!topo_check_args(t, 1, NULL))
+		return 0;
+
+	snprintf(path, sizeof(path), NETNS_RUN_DIR "/%s", t->args[0]);
+
+	if (!access(path, F_OK))
+		return !!topo_get_ns(t, t->args[0]);
+
+	if (mkdir(NETNS_RUN_DIR, 0755) && errno != EEXIST) {
+		tst_brk_(t->file, t->lineno, TBROK | TERRNO,
+			"mkdir(" NETNS_RUN_DIR ") failed");
+		return 0;
+	}
+
+	fd = safe_open(t->file, t->lineno, NULL, path,
+		O_RDONLY | O_CREAT | O_EXCL, 0444);
+
+	if (fd < 0)
+		return 0;
+
+	safe_close(t->file, t->lineno, NULL, fd);
+
+	/* Keep the new namespace alive by bind mounting it, like ip netns add */
+	pid = fork();
+
+	if (pid < 0) {
+		tst_brk_(t->file, t->lineno, TBROK | TERRNO, "fork() failed");
+		return 0;
+	}
+
+	if (!pid) {
+		if (unshare(CLONE_NEWNET) ||
+		    mount("/proc/self/ns/net", path, "none", MS_BIND, NULL))
+			_exit(errno);
+
+		_exit(0);
+	}
+
+	if (waitpid(pid, &status, 0) != pid) {
+		tst_brk_(t->file, t->lineno, TBROK | TERRNO, "waitpid() failed");
+		return 0;
+	}
+
+	if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+		unlink(path);
+		tst_brk_(t->file, t->lineno, TBROK,
+			"Failed to create network namespace %s: %s",
+			t->args[0], tst_strerrno(WEXITSTATUS(status)));
+		return 0;
+	}
+
+	return !!topo_get_ns(t, t->args[0]);
+}
+
+static int topo_veth(struct topo *t)
+{
+	struct ifinfomsg info = { .ifi_family = AF_UNSPEC };
+	struct topo_ns *ns, *peerns;
+	uint32_t mtu = 0;
+	int32_t peerfd;
+
+	if (!topo_check_args(t, 2, "ns peerns mtu") ||
+	    !topo_ifname_check(t, t->args[0]) ||
+	    !topo_ifname_check(t, t->args[1]))
+		return 0;
+
+	ns = topo_get_ns(t, topo_opt(t, "ns"));
+	peerns = topo_get_ns(t, topo_opt(t, "peerns"));
+
+	if (!ns || !peerns)
+		return 0;
+
+	if (!topo_opt_uint(t, "mtu", &mtu, UINT32_MAX))
+		return 0;
+
+	peerfd = topo_ns_fd(t, peerns);
+
+	/* The optional attributes are last, negative length ends the list */
+	struct tst_netlink_attr_list peerinfo[] = {
+		{IFLA_IFNAME, t->args[1], strlen(t->args[1]) + 1, NULL},
+		{IFLA_NET_NS_FD, &peerfd,
+			peerns != ns ? (ssize_t)sizeof(peerfd) : -1, NULL},
+		{0, NULL, -1, NULL}
+	};
+	struct tst_netlink_attr_list peerdata[] = {
+		{VETH_INFO_PEER, &info, sizeof(info), peerinfo},
+		{0, NULL, -1, NULL}
+	};
+	struct tst_netlink_attr_list attrs[] = {
+		{IFLA_IFNAME, t->args[0], strlen(t->args[0]) + 1, NULL},
+		{IFLA_LINKINFO, NULL, 0, (const struct tst_netlink_attr_list[]){
+			{IFLA_INFO_KIND, "veth", 4, NULL},
+			{IFLA_INFO_DATA, NULL, 0, peerdata},
+			{0, NULL, -1, NULL}
+		}},
+		{IFLA_MTU, &mtu, mtu ? (ssize_t)sizeof(mtu) : -1, NULL},
+		{0, NULL, -1, NULL}
+	};
+
+	if (!topo_request(t, ns, RTM_NEWLINK, NLM_F_CREATE | NLM_F_EXCL,
+		&info, sizeof(info), 1))
+		return 0;
+
+	return tst_rtnl_add_attr_list(t->file, t->lineno, ns->ctx, attrs) > 0;
+}
+
+static int topo_link(struct topo *t)
+{
+	struct ifinfomsg info = { .ifi_family = AF_UNSPEC };
+	struct tst_netlink_attr_list data[8], attrs[5];
+	char remote[16], local[16];
+	unsigned int rfamily = 0, lfamily = 0;
+	uint32_t mtu = 0, id = 0, port = 0;
+	uint16_t port_be;
+	int32_t dev = 0;
+	int vxlan, geneve, n = 0, a = 0;
+	struct topo_ns *ns;
+	const char *opt, *kind;
+
+	if (!topo_check_args(t, 2, "ns mtu dev id remote local dstport") ||
+	    !topo_ifname_check(t, t->args[0]))
+		return 0;
+
+	kind = t->args[1];
+	vxlan = !strcmp(kind, "vxlan");
+	geneve = !strcmp(kind, "geneve");
+
+	if (!vxlan && !geneve && (topo_opt(t, "id") || topo_opt(t, "remote") ||
+	    topo_opt(t, "local") || topo_opt(t, "dstport"))) {
+		tst_brk_(t->file, t->lineno, TBROK,
+			"Tunnel options not supported for %s in '%s'", kind,
+			t->cmd);
+		return 0;
+	}
+
+	if (geneve && (topo_opt(t, "local") || topo_opt(t, "dev"))) {
+		tst_brk_(t->file, t->lineno, TBROK,
+			"local and dev not supported for geneve in '%s'",
+			t->cmd);
+		return 0;
+	}
+
+	ns = topo_get_ns(t, topo_opt(t, "ns"));
+
+	if (!ns)
+		return 0;
+
+	if (!topo_opt_uint(t, "mtu", &mtu, UINT32_MAX) ||
+	    !topo_opt_uint(t, "id", &id, UINT32_MAX) ||
+	    !topo_opt_uint(t, "dstport", &port, UINT16_MAX))
+		return 0;
+
+	port_be = htons(port);
+	opt = topo_opt(t, "remote");
+
+	if (opt && !topo_parse_addr(t, opt, &rfamily, remote, NULL))
+		return 0;
+
+	opt = topo_opt(t, "local");
+
+	if (opt && !topo_parse_addr(t, opt, &lfamily, local, NULL))
+		return 0;
+
+	opt = topo_opt(t, "dev");
+
+	if (opt) {
+		dev = topo_index(t, ns, opt);
+
+		if (dev < 0)
+			return 0;
+	}
+
+	if (vxlan) {
+		data[n++] = (struct tst_netlink_attr_list){IFLA_VXLAN_ID, &id,
+			sizeof(id), NULL};
+
+		if (rfamily) {
+			data[n++] = (struct tst_netlink_attr_list){
+				rfamily == AF_INET ? IFLA_VXLAN_GROUP :
+				IFLA_VXLAN_GROUP6, remote,
+				rfamily == AF_INET ? 4 : 16, NULL};
+		}
+
+		if (lfamily) {
+			data[n++] = (struct tst_netlink_attr_list){
+				lfamily == AF_INET ? IFLA_VXLAN_LOCAL :
+				IFLA_VXLAN_LOCAL6, local,
+				lfamily == AF_INET ? 4 : 16, NULL};
+		}
+
+		if (dev) {
+			data[n++] = (struct tst_netlink_attr_list){
+				IFLA_VXLAN_LINK, &dev, sizeof(dev), NULL};
+		}
+
+		if (port) {
+			data[n++] = (struct tst_netlink_attr_list){
+				IFLA_VXLAN_PORT, &port_be, sizeof(port_be),
+				NULL};
+		}
+	} else if (geneve) {
+		data[n++] = (struct tst_netlink_attr_list){IFLA_GENEVE_ID, &id,
+			sizeof(id), NULL};
+
+		if (rfamily) {
+			data[n++] = (struct tst_netlink_attr_list){
+				rfamily == AF_INET ? IFLA_GENEVE_REMOTE :
+				IFLA_GENEVE_REMOTE6, remote,
+				rfamily == AF_INET ? 4 : 16, NULL};
+		}
+
+		if (port) {
+			data[n++] = (struct tst_netlink_attr_list){
+				IFLA_GENEVE_PORT, &port_be, sizeof(port_be),
+				NULL};
+		}
+	}
+
+	data[n] = (struct tst_netlink_attr_list){0, NULL, -1, NULL};
+
+	struct tst_netlink_attr_list linkinfo[] = {
+		{IFLA_INFO_KIND, kind, strlen(kind), NULL},
+		{IFLA_INFO_DATA, NULL, 0, data},
+		{0, NULL, -1, NULL}
+	};
+
+	if (!n)
+		linkinfo[1].len = -1;
+
+	attrs[a++] = (struct tst_netlink_attr_list){IFLA_IFNAME, t->args[0],
+		strlen(t->args[0]) + 1, NULL};
+	attrs[a++] = (struct tst_netlink_attr_list){IFLA_LINKINFO, NULL, 0,
+		linkinfo};
+
+	if (mtu) {
+		attrs[a++] = (struct tst_netlink_attr_list){IFLA_MTU, &mtu,
+			sizeof(mtu), NULL};
+	}
+
+	if (dev && !vxlan) {
+		attrs[a++] = (struct tst_netlink_attr_list){IFLA_LINK, &dev,
+			sizeof(dev), NULL};
+	}
+
+	attrs[a] = (struct tst_netlink_attr_list){0, NULL, -1, NULL};
+
+	if (!topo_request(t, ns, RTM_NEWLINK, NLM_F_CREATE | NLM_F_EXCL,
+		&info, sizeof(info), 1))
+		return 0;
+
+	return tst_rtnl_add_attr_list(t->file, t->lineno, ns->ctx, attrs) > 0;
+}
+
+static int topo_move(struct topo *t)
+{
+	struct ifinfomsg info = { .ifi_family = AF_UNSPEC };
+	struct topo_ns *ns, *target;
+	int32_t fd;
+
+	if (!topo_check_args(t, 2, "ns") || !topo_ifname_check(t, t->args[0]))
+		return 0;
+
+	ns = topo_get_ns(t, topo_opt(t, "ns"));
+	target = topo_get_ns(t, t->args[1]);
+
+	if (!ns || !target)
+		return 0;
+
+	fd = topo_ns_fd(t, target);
+
+	if (!topo_request(t, ns, RTM_NEWLINK, 0, &info, sizeof(info), 1))
+		return 0;
+
+	return tst_rtnl_add_attr_string(t->file, t->lineno, ns->ctx,
+			IFLA_IFNAME, t->args[0]) &&
+		tst_rtnl_add_attr(t->file, t->lineno, ns->ctx, IFLA_NET_NS_FD,
+			&fd, sizeof(fd));
+}
+
+static int topo_up(struct topo *t)
+{
+	struct ifinfomsg info = {
+		.ifi_family = AF_UNSPEC,
+		.ifi_flags = IFF_UP,
+		.ifi_change = IFF_UP,
+	};
+	struct topo_ns *ns;
+	uint32_t mtu = 0;
+
+	if (!topo_check_args(t, 1, "ns mtu") ||
+	    !topo_ifname_check(t, t->args[0]))
+		return 0;
+
+	ns = topo_get_ns(t, topo_opt(t, "ns"));
+
+	if (!ns)
+		return 0;
+
+	if (!topo_opt_uint(t, "mtu", &mtu, UINT32_MAX))
+		return 0;
+
+	if (!topo_request(t, ns, RTM_NEWLINK, 0, &info, sizeof(info), 0))
+		return 0;
+
+	if (!tst_rtnl_add_attr_string(t->file, t->lineno, ns->ctx, IFLA_IFNAME,
+		t->args[0]))
+		return 0;
+
+	return !mtu || tst_rtnl_add_attr(t->file, t->lineno, ns->ctx, IFLA_MTU,
+		&mtu, sizeof(mtu));
+}
+
+static int topo_addr(struct topo *t)
+{
+	struct ifaddrmsg info = { 0 };
+	unsigned int family, prefix;
+	char addr[16];
+	uint32_t flags = 0;
+	struct topo_ns *ns;
+	size_t len;
+	int index;
+
+	if (!topo_check_args(t, 2, "ns nodad noprefixroute"))
+		return 0;
+
+	len = topo_parse_addr(t, t->args[1], &family, addr, &prefix);
+	ns = topo_get_ns(t, topo_opt(t, "ns"));
+
+	if (!len || !ns)
+		return 0;
+
+	index = topo_index(t, ns, t->args[0]);
+
+	if (index < 0)
+		return 0;
+
+	if (topo_opt(t, "nodad"))
+		flags |= IFA_F_NODAD;
+
+	if (topo_opt(t, "noprefixroute"))
+		flags |= IFA_F_NOPREFIXROUTE;
+
+	info.ifa_family = family;
+	info.ifa_prefixlen = prefix;
+	info.ifa_index = index;
+
+	if (!topo_request(t, ns, RTM_NEWADDR, NLM_F_CREATE | NLM_F_EXCL, &info,
+		sizeof(info), 0))
+		return 0;
+
+	return tst_rtnl_add_attr(t->file, t->lineno, ns->ctx, IFA_FLAGS,
+			&flags, sizeof(flags)) &&
+		tst_rtnl_add_attr(t->file, t->lineno, ns->ctx, IFA_LOCAL, addr,
+			len) &&
+		tst_rtnl_add_attr(t->file, t->lineno, ns->ctx, IFA_ADDRESS,
+			addr, len);
+}
+
+static int topo_route(struct topo *t)
+{
+	unsigned int family = 0, gwfamily = 0, prefix = 0;
+	char dst[16], gw[16];
+	size_t dstlen = 0, gwlen = 0;
+	struct topo_ns *ns;
+	const char *opt;
+	int32_t index = 0;
+	struct rtmsg info = {
+		.rtm_table = RT_TABLE_MAIN,
+		.rtm_protocol = RTPROT_STATIC,
+		.rtm_scope = RT_SCOPE_UNIVERSE,
+		.rtm_type = RTN_UNICAST
+	};
+
+	if (!topo_check_args(t, 1, "ns via dev"))
+		return 0;
+
+	if (strcmp(t->args[0], "default")) {
+		dstlen = topo_parse_addr(t, t->args[0], &family, dst, &prefix);
+
+		if (!dstlen)
+			return 0;
+	}
+
+	opt = topo_opt(t, "via");
+
+	if (opt) {
+		gwlen = topo_parse_addr(t, opt, &gwfamily, gw, NULL);
+
+		if (!gwlen)
+			return 0;
+
+		if (family && family != gwfamily) {
+			tst_brk_(t->file, t->lineno, TBROK,
+				"Address family mismatch in '%s'", t->cmd);
+			return 0;
+		}
+
+		family = gwfamily;
+	}
+
+	if (!opt && !topo_opt(t, "dev")) {
+		tst_brk_(t->file, t->lineno, TBROK,
+			"Interface name or gateway address required in '%s'",
+			t->cmd);
+		return 0;
+	}
+
+	ns = topo_get_ns(t, topo_opt(t, "ns"));
+
+	if (!ns)
+		return 0;
+
+	opt = topo_opt(t, "dev");
+
+	if (opt) {
+		index = topo_index(t, ns, opt);
+
+		if (index < 0)
+			return 0;
+	}
+
+	info.rtm_family = family ? family : AF_INET;
+	info.rtm_dst_len = prefix;
+
+	if (!topo_request(t, ns, RTM_NEWROUTE, NLM_F_CREATE | NLM_F_EXCL, &info,
+		sizeof(info), 0))
+		return 0;
+
+	if (prefix && !tst_rtnl_add_attr(t->file, t->lineno, ns->ctx, RTA_DST,
+		dst, dstlen))
+		return 0;
+
+	if (gwlen && !tst_rtnl_add_attr(t->file, t->lineno, ns->ctx,
+		RTA_GATEWAY, gw, gwlen))
+		return 0;
+
+	return !index || tst_rtnl_add_attr(t->file, t->lineno, ns->ctx,
+		RTA_OIF, &index, sizeof(index));
+}
+
+static const struct {
+	const char *name;
+	int (*func)(struct topo *t);
+} topo_cmds[] = {
+	{"netns", topo_netns},
+	{"veth", topo_veth},
+	{"link", topo_link},
+	{"move", topo_move},
+	{"up", topo_up},
+	{"addr", topo_addr},
+	{"route", topo_route},
+	{NULL, NULL}
+};
+
+static int topo_run(struct topo *t, char *spec)
+{
+	char *cmd, *save, *tok, *tsave;
+	int i, ret = 1;
+
+	for (cmd = strtok_r(spec, ";\n", &save); cmd && ret;
+	     cmd = strtok_r(NULL, ";\n", &save)) {
+		cmd[strcspn(cmd, "#")] = '\0';
+		cmd += strspn(cmd, " \t");
+
+		if (!*cmd)
+			continue;
+
+		/* Keep the original command for error messages */
+		snprintf(t->cmd, sizeof(t->cmd), "%s", cmd);
+		tok = strtok_r(cmd, " \t", &tsave);
+
+		for (t->argc = 0; t->argc < TOPO_MAX_ARGS; t->argc++) {
+			t->args[t->argc] = strtok_r(NULL, " \t", &tsave);
+
+			if (!t->args[t->argc])
+				break;
+		}
+
+		for (i = 0; topo_cmds[i].name; i++) {
+			if (!strcmp(topo_cmds[i].name, tok))
+				break;
+		}
+
+		if (!topo_cmds[i].name) {
+			tst_brk_(t->file, t->lineno, TBROK,
+				"Unknown topology command '%s'", t->cmd);
+			ret = 0;
+			continue;
+		}
+
+		ret = topo_cmds[i].func(t);
+	}
+
+	if (ret)
+		ret = topo_flush(t);
+
+	return ret;
+}
+
+int tst_netdev_setup_topology(const char *file, const int lineno, int strict,
+	const char *spec)
+{
+	struct topo t = {
+		.file = file,
+		.lineno = lineno,
+		.strict = strict,
+		.ns_cnt = 1,
+	};
+	char *buf;
+	int i, ret;
+
+	buf = strdup(spec);
+
+	if (!buf) {
+		tst_brk_(file, lineno, TBROK | TERRNO, "strdup() failed");
+		return 0;
+	}
+
+	t.self_fd = safe_open(file, lineno, NULL, "/proc/self/ns/net",
+		O_RDONLY | O_CLOEXEC);
+
+	if (t.self_fd < 0) {
+		free(buf);
+		return 0;
+	}
+
+	t.ns[0].fd = -1;
+	t.ns[0].sock = safe_socket(file, lineno, NULL, AF_INET,
+		SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	t.ns[0].ctx = tst_netlink_create_context(file, lineno, NETLINK_ROUTE);
+
+	ret = t.ns[0].sock >= 0 && t.ns[0].ctx && topo_run(&t, buf);
+
+	for (i = 0; i < t.ns_cnt; i++) {
+		if (t.ns[i].sock >= 0)
+			safe_close(file, lineno, NULL, t.ns[i].sock);
+
+		if (t.ns[i].fd >= 0)
+			safe_close(file, lineno, NULL, t.ns[i].fd);
+
+		tst_netlink_destroy_context(file, lineno, t.ns[i].ctx);
+		free(t.ns[i].name);
+	}
+
+	safe_close(file, lineno, NULL, t.self_fd);
+	free(buf);
+
+	return ret;
+}
@@ -1,5 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#include <string.h>
+
 #include "tst_rand_data.h"
 
 const size_t tst_rand_data_len = 4096;
@@ -209,3 +211,72 @@ const char *const tst_rand_data =
 "\x8f\x8e\xe5\xa7\xc3\x26\x50\xf2\x76\xcd\xbc\x7d\x15\x42\x1f\x7a\x4c\x22\xce\x49"
 "\x5b\xb9\xc4\xe1\xb0\xfa\xfa\x9f\x4c\xd7\x99\x19\x6b\xc9\xde\x32\x05\x27\x19\x33"
 "\xf9\x47\x49\x2a\xf0\x29\x7d\x98\xb1\xf7\x81\x78\x36\x9a\x9b";
+
+/*
+ * Counter based generator, each 64bit word of the stream is the splitmix64
+ * finalizer applied to the word index mixed with the seed. The words are
+ * independent so the loops below are free to be vectorised.
+ */
+static inline uint64_t rand_mix(uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+	return z ^ (z >> 31);
+}
+
+static inline uint64_t rand_word(uint64_t key, uint64_t idx)
+{
+	return rand_mix(key + idx * 0x9e3779b97f4a7c15ULL);
+}
+
+void tst_rand_data_fill(uint64_t seed, uint64_t off, void *buf, size_t len)
+{
+	unsigned char *p = buf;
+	uint64_t key = rand_mix(seed);
+	uint64_t idx = off / sizeof(uint64_t);
+	size_t head = off % sizeof(uint64_t);
+	size_t n;
+	uint64_t w;
+
+	if (head && len) {
+		w = rand_word(key, idx++);
+		n = sizeof(w) - head < len ? sizeof(w) - head : len;
+		memcpy(p, (unsigned char *)&w + head, n);
+		p += n;
+		len -= n;
+	}
+
+	for (; len >= sizeof(w); len -= sizeof(w), p += sizeof(w)) {
+		w = rand_word(key, idx++);
+		memcpy(p, &w, sizeof(w));
+	}
+
+	if (len) {
+		w = rand_word(key, idx);
+		memcpy(p, &w, len);
+	}
+}
+
+ssize_t tst_rand_data_verify(uint64_t seed, uint64_t off, const void *buf,
+			     size_t len)
+{
+	const unsigned char *p = buf;
+	unsigned char tmp[4096];
+	size_t pos = 0, n, i;
+
+	while (pos < len) {
+		n = len - pos < sizeof(tmp) ? len - pos : sizeof(tmp);
+		tst_rand_data_fill(seed, off + pos, tmp, n);
+
+		if (memcmp(tmp, p + pos, n)) {
+			for (i = 0; tmp[i] == p[pos + i]; i++)
+				;
+			return pos + i;
+		}
+
+		pos += n;
+	}
+
+	return -1;
+}
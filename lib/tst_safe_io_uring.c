@@ -3,6 +3,9 @@
  * Copyright (c) 2021 SUSE LLC <mdoucha@suse.cz>
  */
 
+#include <poll.h>
+#include <time.h>
+
 #define TST_NO_DEFAULT_MAIN
 #include "tst_test.h"
 #include "tst_safe_io_uring.h"
@@ -18,6 +21,11 @@ int safe_io_uring_init(const char *file, const int lineno,
 		if (errno == EOPNOTSUPP)
 			tst_brk(TCONF, "CONFIG_IO_URING is not enabled");
 
+		if (errno == EPERM && (params->flags & IORING_SETUP_SQPOLL)) {
+			tst_brk_(file, lineno, TCONF,
+				"IORING_SETUP_SQPOLL not permitted");
+		}
+
 		tst_brk_(file, lineno, TBROK | TERRNO,
 			"io_uring_setup() failed");
 		return uring->fd;
@@ -69,6 +77,9 @@ int safe_io_uring_init(const char *file, const int lineno,
 	uring->cqr_mask = uring->cqr_base + params->cq_off.ring_mask;
 	uring->cqr_overflow = uring->cqr_base + params->cq_off.overflow;
 	uring->cqr_entries = uring->cqr_base + params->cq_off.cqes;
+
+	uring->setup_flags = params->flags;
+	uring->sqe_tail = *uring->sqr_tail;
 	return uring->fd;
 }
 
@@ -109,3 +120,138 @@ int safe_io_uring_enter(const char *file, const int lineno, int strict,
 
 	return ret;
 }
+
+int safe_io_uring_register(const char *file, const int lineno,
+	struct tst_io_uring *uring, unsigned int opcode, void *arg,
+	unsigned int nr_args)
+{
+	int ret;
+
+	errno = 0;
+	ret = io_uring_register(uring->fd, opcode, arg, nr_args);
+
+	if (ret == -1) {
+		tst_brk_(file, lineno, TBROK | TERRNO,
+			"io_uring_register(%u) failed", opcode);
+	} else if (ret < 0) {
+		tst_brk_(file, lineno, TBROK | TERRNO,
+			"Invalid io_uring_register(%u) return value %d",
+			opcode, ret);
+	}
+
+	return ret;
+}
+
+struct io_uring_sqe *tst_io_uring_get_sqe(struct tst_io_uring *uring)
+{
+	struct io_uring_sqe *sqe;
+	uint32_t head, idx;
+
+	__atomic_load(uring->sqr_head, &head, __ATOMIC_ACQUIRE);
+
+	if (uring->sqe_tail - head >= uring->sqr_size)
+		return NULL;
+
+	idx = uring->sqe_tail & *uring->sqr_mask;
+	uring->sqr_array[idx] = idx;
+	uring->sqe_tail++;
+	sqe = &uring->sqr_entries[idx];
+	memset(sqe, 0, sizeof(*sqe));
+
+	return sqe;
+}
+
+int safe_io_uring_submit(const char *file, const int lineno,
+	struct tst_io_uring *uring, unsigned int wait_nr)
+{
+	unsigned int to_submit = uring->sqe_tail - *uring->sqr_tail;
+	unsigned int flags = 0;
+	int ret;
+
+	__atomic_store(uring->sqr_tail, &uring->sqe_tail, __ATOMIC_RELEASE);
+
+	if (uring->setup_flags & IORING_SETUP_SQPOLL) {
+		/* Order the tail store against the flags load */
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+		if (__atomic_load_n(uring->sqr_flags, __ATOMIC_RELAXED) &
+			IORING_SQ_NEED_WAKEUP)
+			flags |= IORING_ENTER_SQ_WAKEUP;
+		else if (!wait_nr)
+			return to_submit;
+	} else if (!to_submit && !wait_nr) {
+		return 0;
+	}
+
+	if (wait_nr)
+		flags |= IORING_ENTER_GETEVENTS;
+
+	ret = safe_io_uring_enter(file, lineno, 0, uring->fd, to_submit,
+		wait_nr, flags, NULL);
+
+	if (ret < 0)
+		return ret;
+
+	if (!(uring->setup_flags & IORING_SETUP_SQPOLL) &&
+		(unsigned int)ret != to_submit) {
+		tst_brk_(file, lineno, TBROK,
+			"io_uring_enter() submitted %d items (expected %u)",
+			ret, to_submit);
+	}
+
+	return to_submit;
+}
+
+const struct io_uring_cqe *tst_io_uring_peek_cqe(struct tst_io_uring *uring)
+{
+	uint32_t tail, head = *uring->cqr_head;
+
+	__atomic_load(uring->cqr_tail, &tail, __ATOMIC_ACQUIRE);
+
+	if (head == tail)
+		return NULL;
+
+	return uring->cqr_entries + (head & *uring->cqr_mask);
+}
+
+void tst_io_uring_cqe_seen(struct tst_io_uring *uring)
+{
+	uint32_t head = *uring->cqr_head + 1;
+
+	__atomic_store(uring->cqr_head, &head, __ATOMIC_RELEASE);
+}
+
+const struct io_uring_cqe *safe_io_uring_wait_cqe(const char *file,
+	const int lineno, struct tst_io_uring *uring, int timeout_ms)
+{
+	const struct io_uring_cqe *cqe;
+	struct pollfd pfd = { .fd = uring->fd, .events = POLLIN };
+	struct timespec start, now;
+	int ret, wait = timeout_ms;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	while (!(cqe = tst_io_uring_peek_cqe(uring))) {
+		if (timeout_ms >= 0) {
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			wait = timeout_ms - (now.tv_sec - start.tv_sec) * 1000 -
+				(now.tv_nsec - start.tv_nsec) / 1000000;
+
+			if (wait < 0)
+				return NULL;
+		}
+
+		ret = poll(&pfd, 1, wait);
+
+		if (ret < 0 && errno != EINTR) {
+			tst_brk_(file, lineno, TBROK | TERRNO,
+				"poll() on io_uring failed");
+			return NULL;
+		}
+
+		if (!ret)
+			return tst_io_uring_peek_cqe(uring);
+	}
+
+	return cqe;
+}
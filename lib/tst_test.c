@@ -17,6 +17,8 @@
 #include <sys/types.h>
 #include <sys/utsname.h>
 #include <sys/wait.h>
+#include <sched.h>
+#include <poll.h>
 #include <math.h>
 
 #define TST_NO_DEFAULT_MAIN
@@ -28,6 +30,7 @@
 #include "tst_ansi_color.h"
 #include "tst_safe_stdio.h"
 #include "tst_timer_test.h"
+#include "tst_bench.h"
 #include "tst_clocks.h"
 #include "tst_timer.h"
 #include "tst_wallclock.h"
@@ -113,6 +116,14 @@ static char ipc_path[1064];
 
 static char shm_path[1024];
 
+/*
+ * Set in the .parallel_tcases worker processes (and inherited by their
+ * children), the worker plays the role of the main test process for the
+ * test case it runs.
+ */
+static pid_t worker_pid;
+static tst_atomic_t *tcase_reported;
+
 int TST_ERR;
 int TST_PASS;
 long TST_RET;
@@ -284,7 +295,12 @@ static void update_results(int ttype)
 	case TBROK:
 		tst_atomic_inc(&results->broken);
 	break;
+	default:
+		return;
 	}
+
+	if (tcase_reported)
+		tst_atomic_inc(tcase_reported);
 }
 
 static void print_result(const char *file, const int lineno, int ttype,
@@ -474,7 +490,12 @@ void tst_vbrk_(const char *file, const int lineno, int ttype, const char *fmt,
 		 * the main test process. That in turn triggers the code that
 		 * kills leftover children once the main test process did exit.
 		 */
-		if (context->main_pid && tst_getpid() != context->main_pid) {
+		if (worker_pid) {
+			if (tst_getpid() != worker_pid) {
+				tst_res(TINFO, "Child process reported TBROK killing the worker");
+				kill(worker_pid, SIGKILL);
+			}
+		} else if (context->main_pid && tst_getpid() != context->main_pid) {
 			tst_res(TINFO, "Child process reported TBROK killing the test");
 			kill(context->main_pid, SIGKILL);
 		}
@@ -672,12 +693,14 @@ static void print_help(void)
 	fprintf(stderr, "KCONFIG_PATH             Specify kernel config file\n");
 	fprintf(stderr, "KCONFIG_SKIP_CHECK       Skip kernel config check if variable set (not set by default)\n");
 	fprintf(stderr, "LTPROOT                  Prefix for installed LTP (default: /opt/ltp)\n");
+	fprintf(stderr, "LTP_CGROUP_STATS         Values 1 or y record per test CGroup v2 resource usage\n");
 	fprintf(stderr, "LTP_COLORIZE_OUTPUT      Force colorized output behaviour (y/1 always, n/0: never)\n");
 	fprintf(stderr, "LTP_DEV                  Path to the block device to be used (for .needs_device)\n");
 	fprintf(stderr, "LTP_DEV_FS_TYPE          Filesystem used for testing (default: %s)\n", DEFAULT_FS_TYPE);
 	fprintf(stderr, "LTP_ENABLE_DEBUG         Print debug messages (set 1(y) or 2)\n");
 	fprintf(stderr, "LTP_REPRODUCIBLE_OUTPUT  Values 1 or y discard the actual content of the messages printed by the test\n");
 	fprintf(stderr, "LTP_QUIET                Values 1 or y will suppress printing TCONF, TWARN, TINFO, and TDEBUG messages\n");
+	fprintf(stderr, "LTP_TCASE_WORKERS        Number of worker processes for .parallel_tcases (default: number of CPUs)\n");
 	fprintf(stderr, "LTP_SINGLE_FS_TYPE       Specifies filesystem instead all supported (for .all_filesystems)\n");
 	fprintf(stderr, "LTP_FORCE_SINGLE_FS_TYPE Testing only. The same as LTP_SINGLE_FS_TYPE but ignores test skiplist.\n");
 	fprintf(stderr, "LTP_TIMEOUT_MUL          Timeout multiplier (must be a number >=1)\n");
@@ -1048,6 +1071,8 @@ static void do_exit(int ret)
 				print_failure_hints();
 		}
 
+		tst_cg_stats_print();
+
 		fprintf(stderr, "\nSummary:\n");
 		fprintf(stderr, "passed   %d\n", results->passed);
 		fprintf(stderr, "failed   %d\n", results->failed);
@@ -1173,6 +1198,9 @@ static void assert_test_fn(void)
 
 	if (!tst_test->test && tst_test->tcnt)
 		tst_brk(TBROK, "You can define tcnt only for test()");
+
+	if (tst_test->parallel_tcases && !tst_test->test)
+		tst_brk(TBROK, "parallel_tcases can be used only with test()");
 }
 
 static int prepare_and_mount_ro_fs(const char *dev, const char *mntpoint,
@@ -1403,6 +1431,7 @@ static void do_setup(int argc, char *argv[])
 	char *tdebug_env = getenv("LTP_ENABLE_DEBUG");
 	char *reproducible_env = getenv("LTP_REPRODUCIBLE_OUTPUT");
 	char *quiet_env = getenv("LTP_QUIET");
+	char *cg_stats_env = getenv("LTP_CGROUP_STATS");
 
 	if (!tst_test)
 		tst_brk(TBROK, "No tests to run");
@@ -1424,11 +1453,17 @@ static void do_setup(int argc, char *argv[])
 	if (tst_test->sample)
 		tst_test = tst_timer_test_setup(tst_test);
 
+	if (tst_test->bench)
+		tst_test = tst_bench_setup(tst_test);
+
 	if (tst_test->runs_script) {
 		tst_test->child_needs_reinit = 1;
 		tst_test->forks_child = 1;
 	}
 
+	if (tst_test->parallel_tcases)
+		tst_test->forks_child = 1;
+
 	if (reproducible_env &&
 	    (!strcmp(reproducible_env, "1") || !strcmp(reproducible_env, "y")))
 		reproducible_output = 1;
@@ -1626,6 +1661,10 @@ static void do_setup(int argc, char *argv[])
 		do_cgroup_requires();
 	else if (tst_test->needs_cgroup_ver)
 		tst_brk(TBROK, "tst_test->needs_cgroup_ctrls must be set");
+
+	if (cg_stats_env &&
+	    (!strcmp(cg_stats_env, "1") || !strcmp(cg_stats_env, "y")))
+		tst_cg_stats_init();
 }
 
 static void do_test_setup(void)
@@ -1659,6 +1698,8 @@ static void do_test_setup(void)
 
 static void do_cleanup(void)
 {
+	tst_cg_stats_cleanup();
+
 	if (tst_test->needs_cgroup_ctrls)
 		tst_cg_cleanup();
 
@@ -1703,6 +1744,251 @@ static void heartbeat(void)
 	kill(getppid(), SIGUSR1);
 }
 
+struct tcase_queue {
+	tst_atomic_t next;
+	tst_atomic_t stop;
+	tst_atomic_t counters[];
+};
+
+struct tcase_pool {
+	/* Shared with the workers */
+	struct tcase_queue *queue;
+	/* Test case currently executed by each worker, -1 when idle */
+	tst_atomic_t *cur;
+	/* Number of results reported by each test case */
+	tst_atomic_t *reported;
+	/* Test cases finished, used only by the main test process */
+	char *done;
+	unsigned int flushed;
+	char dir[PATH_MAX];
+};
+
+static unsigned int tcase_workers(cpu_set_t *cpus)
+{
+	const char *env = getenv("LTP_TCASE_WORKERS");
+	int n;
+
+	if (sched_getaffinity(0, sizeof(*cpus), cpus)) {
+		tst_res(TWARN | TERRNO, "sched_getaffinity() failed");
+		return 1;
+	}
+
+	n = CPU_COUNT(cpus);
+
+	if (env && tst_parse_int(env, &n, 0, INT_MAX)) {
+		tst_res(TWARN, "Invalid LTP_TCASE_WORKERS value: %s", env);
+		n = CPU_COUNT(cpus);
+	}
+
+	return MIN((unsigned int)n, tst_test->tcnt);
+}
+
+static void pin_worker(cpu_set_t *cpus, unsigned int w)
+{
+	cpu_set_t mask;
+	int cpu, n = -1;
+
+	w %= CPU_COUNT(cpus);
+
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (CPU_ISSET(cpu, cpus) && ++n == (int)w)
+			break;
+	}
+
+	CPU_ZERO(&mask);
+	CPU_SET(cpu, &mask);
+
+	if (sched_setaffinity(0, sizeof(mask), &mask))
+		tst_res(TWARN | TERRNO, "sched_setaffinity(%i) failed", cpu);
+}
+
+static void tcase_path(struct tcase_pool *pool, unsigned int i, char *path)
+{
+	snprintf(path, PATH_MAX + 32, "%s/tcase_%u", pool->dir, i);
+}
+
+/*
+ * Runs test cases from the shared queue, the output of each test case is
+ * redirected into a file so that it can be printed in test case order.
+ */
+static void tcase_worker(struct tcase_pool *pool, cpu_set_t *cpus,
+			 unsigned int w, int fd_notify)
+{
+	char path[PATH_MAX + 32];
+	int fd, saved_out, saved_err;
+	unsigned int i;
+
+	worker_pid = getpid();
+	pin_worker(cpus, w);
+
+	saved_out = SAFE_DUP(STDOUT_FILENO);
+	saved_err = SAFE_DUP(STDERR_FILENO);
+
+	for (;;) {
+		if (tst_atomic_load(&pool->queue->stop) ||
+		    tst_atomic_load(&context->abort_flag))
+			break;
+
+		i = tst_atomic_inc(&pool->queue->next) - 1;
+		if (i >= tst_test->tcnt)
+			break;
+
+		tst_atomic_store(i, &pool->cur[w]);
+
+		tcase_path(pool, i, path);
+		fd = SAFE_OPEN(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+		fflush(stdout);
+		SAFE_DUP2(fd, STDOUT_FILENO);
+		SAFE_DUP2(fd, STDERR_FILENO);
+		SAFE_CLOSE(fd);
+
+		tcase_reported = &pool->reported[i];
+		tst_test->test(i);
+
+		if (tst_getpid() != worker_pid)
+			exit(0);
+
+		tst_reap_children();
+
+		if (!tst_atomic_load(tcase_reported))
+			tst_brk(TBROK, "Test %i haven't reported results!", i);
+
+		tcase_reported = NULL;
+
+		fflush(stdout);
+		SAFE_DUP2(saved_out, STDOUT_FILENO);
+		SAFE_DUP2(saved_err, STDERR_FILENO);
+
+		tst_atomic_store(-1, &pool->cur[w]);
+		SAFE_WRITE(SAFE_WRITE_ALL, fd_notify, &i, sizeof(i));
+	}
+
+	exit(0);
+}
+
+static void flush_tcases(struct tcase_pool *pool)
+{
+	char path[PATH_MAX + 32], buf[4096];
+	ssize_t ret;
+	int fd;
+
+	while (pool->flushed < tst_test->tcnt && pool->done[pool->flushed]) {
+		tcase_path(pool, pool->flushed, path);
+
+		fd = open(path, O_RDONLY);
+		if (fd >= 0) {
+			while ((ret = read(fd, buf, sizeof(buf))) > 0)
+				SAFE_WRITE(SAFE_WRITE_ALL, STDERR_FILENO, buf, ret);
+
+			SAFE_CLOSE(fd);
+			SAFE_UNLINK(path);
+		}
+
+		pool->flushed++;
+	}
+}
+
+static void run_tcases_parallel(unsigned int workers, cpu_set_t *cpus)
+{
+	struct tcase_pool pool = {};
+	unsigned int i, running = workers;
+	pid_t *pids;
+	int fds[2], status, killed_sig = 0, killed_tcase = 0;
+	struct pollfd pfd;
+	size_t size;
+
+	snprintf(pool.dir, sizeof(pool.dir), "%s/ltp_tcases_XXXXXX",
+		 tst_get_tmpdir_root());
+	if (!mkdtemp(pool.dir))
+		tst_brk(TBROK | TERRNO, "mkdtemp(%s) failed", pool.dir);
+
+	size = sizeof(struct tcase_queue) +
+	       (workers + tst_test->tcnt) * sizeof(tst_atomic_t);
+	pool.queue = SAFE_MMAP(NULL, size, PROT_READ | PROT_WRITE,
+			       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	pool.cur = pool.queue->counters;
+	pool.reported = pool.cur + workers;
+	pool.done = SAFE_MALLOC(tst_test->tcnt);
+	memset(pool.done, 0, tst_test->tcnt);
+	pids = SAFE_MALLOC(workers * sizeof(*pids));
+
+	SAFE_PIPE(fds);
+
+	for (i = 0; i < workers; i++) {
+		pool.cur[i] = -1;
+		pids[i] = SAFE_FORK();
+
+		if (!pids[i]) {
+			SAFE_CLOSE(fds[0]);
+			tcase_worker(&pool, cpus, i, fds[1]);
+		}
+	}
+
+	SAFE_CLOSE(fds[1]);
+
+	pfd.fd = fds[0];
+	pfd.events = POLLIN;
+
+	while (running) {
+		if (poll(&pfd, 1, 10) > 0) {
+			if (SAFE_READ(0, fds[0], &i, sizeof(i)) == sizeof(i)) {
+				pool.done[i] = 1;
+				heartbeat();
+			}
+		}
+
+		for (i = 0; i < workers; i++) {
+			int cur;
+
+			if (!pids[i] || waitpid(pids[i], &status, WNOHANG) <= 0)
+				continue;
+
+			pids[i] = 0;
+			running--;
+
+			/* Drain completions written before the worker exited */
+			while (poll(&pfd, 1, 0) > 0 &&
+			       SAFE_READ(0, fds[0], &cur, sizeof(cur)) == sizeof(cur))
+				pool.done[cur] = 1;
+
+			cur = tst_atomic_load(&pool.cur[i]);
+			if (cur < 0)
+				continue;
+
+			pool.done[cur] = 1;
+			tst_atomic_store(1, &pool.queue->stop);
+
+			if (WIFSIGNALED(status) && !killed_sig) {
+				killed_sig = WTERMSIG(status);
+				killed_tcase = cur;
+			}
+		}
+
+		flush_tcases(&pool);
+	}
+
+	SAFE_CLOSE(fds[0]);
+
+	/* Test cases that were never started after the pool was stopped */
+	memset(pool.done, 1, tst_test->tcnt);
+	flush_tcases(&pool);
+
+	SAFE_RMDIR(pool.dir);
+	SAFE_MUNMAP(pool.queue, size);
+	free(pool.done);
+	free(pids);
+
+	if (tst_atomic_load(&context->abort_flag)) {
+		do_test_cleanup();
+		exit(0);
+	}
+
+	if (killed_sig) {
+		tst_brk(TBROK, "Worker running test %i killed by %s",
+			killed_tcase, tst_strsig(killed_sig));
+	}
+}
+
 static void run_tests(void)
 {
 	unsigned int i;
@@ -1724,6 +2010,16 @@ static void run_tests(void)
 		return;
 	}
 
+	if (tst_test->parallel_tcases) {
+		cpu_set_t cpus;
+		unsigned int workers = tcase_workers(&cpus);
+
+		if (workers > 1) {
+			run_tcases_parallel(workers, &cpus);
+			return;
+		}
+	}
+
 	for (i = 0; i < tst_test->tcnt; i++) {
 		saved_results = *results;
 		heartbeat();
@@ -1922,6 +2218,8 @@ static void fork_testrun(void)
 
 	show_failure_hints = 1;
 
+	tst_cg_stats_start();
+
 	test_pid = fork();
 	if (test_pid < 0)
 		tst_brk(TBROK | TERRNO, "fork()");
@@ -1933,6 +2231,7 @@ static void fork_testrun(void)
 		SAFE_SIGNAL(SIGTERM, SIG_DFL);
 		SAFE_SIGNAL(SIGINT, SIG_DFL);
 		SAFE_SETPGID(0, 0);
+		tst_cg_stats_attach();
 		testrun();
 	}
 
@@ -1949,6 +2248,8 @@ static void fork_testrun(void)
 	if (tst_test->forks_child && kill(-test_pid, SIGKILL) == 0)
 		tst_res(TINFO, "Killed the leftover descendant processes");
 
+	tst_cg_stats_stop();
+
 	if (WIFEXITED(status) && WEXITSTATUS(status))
 		tst_brk(TBROK, "Child returned with %i", WEXITSTATUS(status));
 
@@ -60,6 +60,7 @@
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <assert.h>
 #include <errno.h>
 #include <libgen.h>
@@ -72,6 +73,7 @@
 
 #include "test.h"
 #include "tst_buffers.h"
+#include "tst_cpu.h"
 #include "tso_safe_macros.h"
 #include "tst_tmpdir.h"
 #include "tso_priv.h"
@@ -82,6 +84,14 @@
  */
 #define DIR_MODE	(S_IRWXU|S_IRWXG|S_IRWXO)
 
+/*
+ * tst_rmdir() removes trees with at least RMDIR_PARALLEL_MIN entries in the
+ * first RMDIR_SPLIT_DEPTH levels with up to RMDIR_MAX_WORKERS processes.
+ */
+#define RMDIR_SPLIT_DEPTH	2
+#define RMDIR_PARALLEL_MIN	1024
+#define RMDIR_MAX_WORKERS	16
+
 #ifndef PATH_MAX
 #ifdef MAXPATHLEN
 #define PATH_MAX	MAXPATHLEN
@@ -102,6 +112,8 @@ static char test_start_work_dir[PATH_MAX];
 extern futex_t *tst_futexes;
 
 static int rmobjat(int dir_fd, const char *obj, char **errmsg);
+static int rmobjat_type(int dir_fd, const char *obj, unsigned char type,
+			char **errmsg);
 
 int tst_tmpdir_created(void)
 {
@@ -186,7 +198,8 @@ static int purge_dirat(int dir_fd, const char *path, char **errptr)
 			continue;
 
 		/* Recursively remove the current entry */
-		if (rmobjat(subdir_fd, dir_ent->d_name, errptr) != 0)
+		if (rmobjat_type(subdir_fd, dir_ent->d_name, dir_ent->d_type,
+				 errptr) != 0)
 			ret_val = -1;
 	}
 
@@ -194,14 +207,18 @@ static int purge_dirat(int dir_fd, const char *path, char **errptr)
 	return ret_val;
 }
 
-static int rmobjat(int dir_fd, const char *obj, char **errmsg)
+static int rmobjat_type(int dir_fd, const char *obj, unsigned char type,
+			char **errmsg)
 {
 	int ret_val = 0;
 	struct stat statbuf;
 	static char err_msg[PATH_MAX + 1280];
-	int fd;
+	int fd = -1;
+
+	/* d_type spares us probing every file with openat() */
+	if (type == DT_DIR || type == DT_UNKNOWN)
+		fd = openat(dir_fd, obj, O_DIRECTORY | O_NOFOLLOW);
 
-	fd = openat(dir_fd, obj, O_DIRECTORY | O_NOFOLLOW);
 	if (fd >= 0) {
 		close(fd);
 		ret_val = purge_dirat(dir_fd, obj, errmsg);
@@ -238,6 +255,10 @@ static int rmobjat(int dir_fd, const char *obj, char **errmsg)
 		}
 	} else {
 		if (unlinkat(dir_fd, obj, 0) < 0) {
+			/* d_type was stale, try again as unknown type */
+			if (errno == EISDIR && type != DT_UNKNOWN)
+				return rmobjat_type(dir_fd, obj, DT_UNKNOWN, errmsg);
+
 			if (errmsg != NULL) {
 				snprintf(err_msg, sizeof(err_msg),
 					"unlinkat(%s) failed; errno=%d: %s", obj,
@@ -251,6 +272,209 @@ static int rmobjat(int dir_fd, const char *obj, char **errmsg)
 	return 0;
 }
 
+static int rmobjat(int dir_fd, const char *obj, char **errmsg)
+{
+	return rmobjat_type(dir_fd, obj, DT_UNKNOWN, errmsg);
+}
+
+/*
+ * Counts entries in the first RMDIR_SPLIT_DEPTH levels of the tree, stops
+ * once limit is reached.
+ */
+static long count_entriesat(int dir_fd, const char *path, int depth,
+			    long limit)
+{
+	struct dirent *ent;
+	long cnt = 0;
+	DIR *dir;
+	int fd;
+
+	fd = openat(dir_fd, path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+	if (fd < 0)
+		return 0;
+
+	dir = fdopendir(fd);
+	if (!dir) {
+		close(fd);
+		return 0;
+	}
+
+	while (cnt < limit && (ent = readdir(dir))) {
+		if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, ".."))
+			continue;
+
+		cnt++;
+
+		if (ent->d_type == DT_DIR && depth < RMDIR_SPLIT_DEPTH)
+			cnt += count_entriesat(fd, ent->d_name, depth + 1,
+					       limit - cnt);
+	}
+
+	closedir(dir);
+	return cnt;
+}
+
+struct rmdir_jobs {
+	char **paths;
+	unsigned int cnt;
+	unsigned int size;
+};
+
+static void add_job(struct rmdir_jobs *jobs, const char *dir,
+		    const char *name)
+{
+	char **paths;
+	char *path;
+
+	if (jobs->cnt == jobs->size) {
+		paths = realloc(jobs->paths, 2 * (jobs->size + 16) * sizeof(char *));
+		if (!paths)
+			return;
+
+		jobs->paths = paths;
+		jobs->size = 2 * (jobs->size + 16);
+	}
+
+	if (asprintf(&path, "%s%s%s", dir, *dir ? "/" : "", name) < 0)
+		return;
+
+	jobs->paths[jobs->cnt++] = path;
+}
+
+/*
+ * Collects the subdirectories of path, relative to root_fd, as jobs.
+ */
+static void collect_jobsat(int root_fd, const char *path,
+			   struct rmdir_jobs *jobs)
+{
+	struct dirent *ent;
+	DIR *dir;
+	int fd;
+
+	fd = openat(root_fd, *path ? path : ".",
+		    O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+	if (fd < 0)
+		return;
+
+	dir = fdopendir(fd);
+	if (!dir) {
+		close(fd);
+		return;
+	}
+
+	while ((ent = readdir(dir))) {
+		if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, ".."))
+			continue;
+
+		if (ent->d_type == DT_DIR)
+			add_job(jobs, path, ent->d_name);
+	}
+
+	closedir(dir);
+}
+
+static void free_jobs(struct rmdir_jobs *jobs)
+{
+	unsigned int i;
+
+	for (i = 0; i < jobs->cnt; i++)
+		free(jobs->paths[i]);
+
+	free(jobs->paths);
+	memset(jobs, 0, sizeof(*jobs));
+}
+
+/*
+ * Workers take whole subdirectories from a shared counter and remove them
+ * with the serial code, so that no two workers read or modify the same
+ * directory. Subdirectories on a different filesystem, the files in the top
+ * levels and anything a worker failed to remove are left to the serial pass
+ * which also reports the errors.
+ */
+static void purge_worker(int root_fd, dev_t dev, struct rmdir_jobs *jobs,
+			 unsigned int *next)
+{
+	struct stat statbuf;
+	unsigned int i;
+
+	while ((i = __atomic_fetch_add(next, 1, __ATOMIC_RELAXED)) < jobs->cnt) {
+		if (fstatat(root_fd, jobs->paths[i], &statbuf,
+			    AT_SYMLINK_NOFOLLOW) || statbuf.st_dev != dev)
+			continue;
+
+		rmobjat_type(root_fd, jobs->paths[i], DT_DIR, NULL);
+	}
+}
+
+static void purge_parallel(const char *path)
+{
+	struct rmdir_jobs jobs = {}, top = {};
+	pid_t pids[RMDIR_MAX_WORKERS];
+	struct stat statbuf;
+	unsigned int *next;
+	long workers;
+	int i, root_fd;
+	unsigned int j;
+
+	workers = MIN(tst_ncpus_available(), RMDIR_MAX_WORKERS);
+	if (workers < 2)
+		return;
+
+	root_fd = open(path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+	if (root_fd < 0)
+		return;
+
+	if (fstat(root_fd, &statbuf) ||
+	    count_entriesat(root_fd, ".", 0, RMDIR_PARALLEL_MIN) <
+	    RMDIR_PARALLEL_MIN)
+		goto exit;
+
+	/* Split one level deeper when there are too few top level directories */
+	collect_jobsat(root_fd, "", &top);
+	if (top.cnt < 2 * workers) {
+		for (j = 0; j < top.cnt; j++)
+			collect_jobsat(root_fd, top.paths[j], &jobs);
+	}
+
+	if (jobs.cnt < top.cnt || jobs.cnt < 2) {
+		free_jobs(&jobs);
+		jobs = top;
+		memset(&top, 0, sizeof(top));
+	}
+
+	if (jobs.cnt < 2)
+		goto exit;
+
+	next = mmap(NULL, sizeof(*next), PROT_READ | PROT_WRITE,
+		    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (next == MAP_FAILED)
+		goto exit;
+
+	*next = 0;
+	workers = MIN(workers, (long)jobs.cnt);
+
+	for (i = 0; i < workers; i++) {
+		pids[i] = fork();
+
+		if (!pids[i]) {
+			purge_worker(root_fd, statbuf.st_dev, &jobs, next);
+			_exit(0);
+		}
+	}
+
+	/* Jobs of workers which failed to fork are left to the serial pass */
+	for (i = 0; i < workers; i++) {
+		if (pids[i] > 0)
+			waitpid(pids[i], NULL, 0);
+	}
+
+	munmap(next, sizeof(*next));
+exit:
+	free_jobs(&top);
+	free_jobs(&jobs);
+	close(root_fd);
+}
+
 void tst_tmpdir(void)
 {
 	char template[PATH_MAX];
@@ -332,6 +556,13 @@ void tst_rmdir(void)
 		munmap((void *)tst_futexes, getpagesize());
 	}
 
+	/*
+	 * The old library does not expect tst_rmdir() to fork, remove large
+	 * trees in parallel only in tests using the new library.
+	 */
+	if (tst_test)
+		purge_parallel(TESTDIR);
+
 	/*
 	 * Attempt to remove the "TESTDIR" directory, using rmobj().
 	 */
@@ -0,0 +1 @@
+20260130])
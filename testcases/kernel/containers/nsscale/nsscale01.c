@@ -0,0 +1,374 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) Linux Test Project, 2026
+ */
+
+/*\
+ * Namespace creation and teardown scalability benchmark.
+ *
+ * One worker process per CPU creates children in new namespaces with
+ * clone3() in batches. The children of a batch stay alive until the batch is
+ * complete, then the worker lets them exit and reaps them, so that each
+ * worker keeps up to -b sets of namespaces alive at a time. This is repeated
+ * for each namespace type and for the combined set of flags a container
+ * runtime uses.
+ *
+ * The test reports the create and destroy rate of all workers together, the
+ * latency of the clone3() call, which includes copying the namespaces, and
+ * the teardown latency from releasing the batch until the worker reaped each
+ * child.
+ *
+ * The network namespaces are freed asynchronously, the cleanup work keeps
+ * the namespace counted against /proc/sys/user/max_net_namespaces until it
+ * finished. On ENOSPC workers tear down the current batch and retry, the
+ * number of retries shows how much the cleanup lags behind the creation.
+ * A worker gives up after MAX_RETRIES failures in a row.
+ *
+ * With -m the test first creates a private mount namespace with the given
+ * number of bind mounts, so that the cost of copying a large mount table is
+ * measured by the mnt and container cases.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mount.h>
+#include "tst_test.h"
+#include "tst_hist.h"
+#include "tst_safe_clocks.h"
+#include "lapi/sched.h"
+
+#define MNT_DIR "mnt"
+#define MAX_RETRIES 1000
+
+static char *str_iterations;
+static char *str_workers;
+static char *str_batch;
+static char *str_mounts;
+
+static int iterations = 1000;
+static int nworkers;
+static int batch = 16;
+static int nmounts;
+static long long case_runtime_ns;
+
+struct worker_stats {
+	unsigned long created;
+	unsigned long retries;
+	int err;
+	struct tst_hist create_hist;
+	struct tst_hist teardown_hist;
+};
+
+static struct worker_stats *stats;
+
+#define CONTAINER_FLAGS (CLONE_NEWUSER | CLONE_NEWPID | CLONE_NEWNS | \
+			 CLONE_NEWNET | CLONE_NEWUTS | CLONE_NEWIPC | \
+			 CLONE_NEWCGROUP)
+
+static struct tcase {
+	const char *name;
+	uint64_t flags;
+} tcases[] = {
+	{"uts", CLONE_NEWUTS},
+	{"ipc", CLONE_NEWIPC},
+	{"mnt", CLONE_NEWNS},
+	{"net", CLONE_NEWNET},
+	{"pid", CLONE_NEWPID},
+	{"user", CLONE_NEWUSER},
+	{"cgroup", CLONE_NEWCGROUP},
+	{"time", CLONE_NEWTIME},
+	{"container", CONTAINER_FLAGS},
+};
+
+static const struct ns_file {
+	uint64_t flag;
+	const char *path;
+} ns_files[] = {
+	{CLONE_NEWUTS, "/proc/self/ns/uts"},
+	{CLONE_NEWIPC, "/proc/self/ns/ipc"},
+	{CLONE_NEWNS, "/proc/self/ns/mnt"},
+	{CLONE_NEWNET, "/proc/self/ns/net"},
+	{CLONE_NEWPID, "/proc/self/ns/pid"},
+	{CLONE_NEWUSER, "/proc/self/ns/user"},
+	{CLONE_NEWCGROUP, "/proc/self/ns/cgroup"},
+	{CLONE_NEWTIME, "/proc/self/ns/time"},
+};
+
+/* closing the pipe lets all children of the batch exit */
+static void release_batch(struct worker_stats *st, const pid_t *pids, int cnt,
+			  int *wfd)
+{
+	unsigned long long start, done;
+	int i;
+
+	start = tst_hist_now_ns();
+	SAFE_CLOSE(*wfd);
+
+	for (i = 0; i < cnt; i++) {
+		SAFE_WAITPID(pids[i], NULL, 0);
+		done = tst_hist_now_ns();
+		tst_hist_add(&st->teardown_hist, done - start);
+	}
+
+	st->created += cnt;
+}
+
+static void worker(struct worker_stats *st, uint64_t flags,
+		   unsigned long long deadline)
+{
+	const struct tst_clone_args args = {
+		.flags = flags,
+		.exit_signal = SIGCHLD,
+	};
+	unsigned long long start, end;
+	pid_t pid, *pids = SAFE_MALLOC(sizeof(*pids) * batch);
+	int fds[2], cnt, retries = 0, stop = 0;
+	char c;
+
+	TST_CHECKPOINT_WAIT(0);
+
+	while (!stop && st->created < (unsigned long)iterations) {
+		SAFE_PIPE(fds);
+		cnt = 0;
+
+		while (cnt < batch && st->created + cnt < (unsigned long)iterations) {
+			start = tst_hist_now_ns();
+			if (start > deadline) {
+				stop = 1;
+				break;
+			}
+
+			pid = tst_clone(&args);
+			end = tst_hist_now_ns();
+
+			if (pid < 0) {
+				if (errno != ENOSPC) {
+					st->err = errno;
+					stop = 1;
+					break;
+				}
+
+				st->retries++;
+
+				if (++retries > MAX_RETRIES) {
+					st->err = ENOSPC;
+					stop = 1;
+					break;
+				}
+
+				/* tear down the batch so that its namespaces can be freed */
+				if (cnt)
+					break;
+
+				usleep(1000);
+				continue;
+			}
+
+			if (!pid) {
+				close(fds[1]);
+				/* stay alive until the worker releases the batch */
+				if (read(fds[0], &c, 1) < 0)
+					_exit(1);
+				_exit(0);
+			}
+
+			pids[cnt++] = pid;
+			retries = 0;
+			tst_hist_add(&st->create_hist, end - start);
+		}
+
+		SAFE_CLOSE(fds[0]);
+		release_batch(st, pids, cnt, &fds[1]);
+	}
+
+	free(pids);
+	exit(0);
+}
+
+static int ns_supported(uint64_t flags)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(ns_files); i++) {
+		if ((flags & ns_files[i].flag) && access(ns_files[i].path, F_OK)) {
+			tst_res(TCONF, "%s is not supported", ns_files[i].path);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static void report(const char *what, struct tcase *tc, int teardown)
+{
+	struct tst_hist hist = {};
+	int w;
+
+	for (w = 0; w < nworkers; w++) {
+		tst_hist_merge(&hist, teardown ? &stats[w].teardown_hist :
+						 &stats[w].create_hist);
+	}
+
+	if (!hist.samples)
+		return;
+
+	tst_res(TINFO, "%s: %-8s p50 %8.1f us, p99 %8.1f us, max %8.1f us",
+		tc->name, what, tst_hist_percentile(&hist, 50) / 1000.0,
+		tst_hist_percentile(&hist, 99) / 1000.0, hist.max / 1000.0);
+}
+
+static void run(unsigned int n)
+{
+	struct tcase *tc = &tcases[n];
+	const struct tst_clone_args args = {
+		.flags = tc->flags,
+		.exit_signal = SIGCHLD,
+	};
+	unsigned long long start, end, deadline;
+	unsigned long created = 0, retries = 0;
+	int w, err = 0;
+	pid_t pid;
+
+	if (!ns_supported(tc->flags))
+		return;
+
+	pid = tst_clone(&args);
+	if (pid < 0) {
+		if (errno == EINVAL || errno == ENOSPC || errno == EPERM) {
+			tst_res(TCONF | TERRNO, "%s: clone3() not possible",
+				tc->name);
+			return;
+		}
+
+		tst_brk(TBROK | TERRNO, "%s: clone3()", tc->name);
+	}
+
+	if (!pid)
+		_exit(0);
+
+	SAFE_WAITPID(pid, NULL, 0);
+
+	memset(stats, 0, sizeof(*stats) * nworkers);
+	deadline = tst_hist_now_ns() + case_runtime_ns;
+
+	for (w = 0; w < nworkers; w++) {
+		if (!SAFE_FORK())
+			worker(&stats[w], tc->flags, deadline);
+	}
+
+	start = tst_hist_now_ns();
+	TST_CHECKPOINT_WAKE2(0, nworkers);
+	tst_reap_children();
+	end = tst_hist_now_ns();
+
+	for (w = 0; w < nworkers; w++) {
+		created += stats[w].created;
+		retries += stats[w].retries;
+
+		if (stats[w].err)
+			err = stats[w].err;
+	}
+
+	tst_res(TINFO, "%s: %lu namespace sets in %.2f s, %.0f/s, ENOSPC retries %lu",
+		tc->name, created, (end - start) / 1e9,
+		created * 1e9 / (end - start), retries);
+
+	report("create", tc, 0);
+	report("teardown", tc, 1);
+
+	if (err == ENOSPC) {
+		tst_res(TFAIL, "%s: clone3() failed with ENOSPC %i times in a row",
+			tc->name, MAX_RETRIES + 1);
+		return;
+	}
+
+	if (err) {
+		tst_res(TFAIL, "%s: clone3() failed: %s", tc->name,
+			tst_strerrno(err));
+		return;
+	}
+
+	tst_res(TPASS, "%s: created and destroyed %lu namespace sets",
+		tc->name, created);
+}
+
+static void setup_mounts(void)
+{
+	char path[64];
+	int i;
+
+	/* keep the mounts out of the namespace the test was started in */
+	SAFE_UNSHARE(CLONE_NEWNS);
+	SAFE_MOUNT("none", "/", NULL, MS_REC | MS_PRIVATE, NULL);
+
+	SAFE_MKDIR(MNT_DIR, 0755);
+	SAFE_MOUNT("nsscale", MNT_DIR, "tmpfs", 0, NULL);
+	SAFE_MKDIR(MNT_DIR "/src", 0755);
+
+	for (i = 0; i < nmounts; i++) {
+		snprintf(path, sizeof(path), MNT_DIR "/%i", i);
+		SAFE_MKDIR(path, 0755);
+
+		/* SAFE_MOUNT() would print a line for each mount */
+		if (mount(MNT_DIR "/src", path, NULL, MS_BIND, NULL))
+			tst_brk(TBROK | TERRNO, "mount(%s)", path);
+	}
+
+	tst_res(TINFO, "Created %i bind mounts", nmounts);
+}
+
+static void setup(void)
+{
+	if (tst_parse_int(str_iterations, &iterations, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid number of iterations '%s'", str_iterations);
+
+	nworkers = tst_ncpus_available();
+	if (tst_parse_int(str_workers, &nworkers, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid number of workers '%s'", str_workers);
+
+	if (tst_parse_int(str_batch, &batch, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid batch size '%s'", str_batch);
+
+	if (tst_parse_int(str_mounts, &nmounts, 0, INT_MAX))
+		tst_brk(TBROK, "Invalid number of mounts '%s'", str_mounts);
+
+	stats = SAFE_MMAP(NULL, sizeof(*stats) * nworkers,
+			  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+			  -1, 0);
+
+	case_runtime_ns = tst_remaining_runtime() * 1000000000LL /
+			  ARRAY_SIZE(tcases);
+
+	if (nmounts)
+		setup_mounts();
+
+	tst_res(TINFO, "%i workers, %i iterations per worker in batches of %i",
+		nworkers, iterations, batch);
+}
+
+static void cleanup(void)
+{
+	if (stats)
+		SAFE_MUNMAP(stats, sizeof(*stats) * nworkers);
+}
+
+static struct tst_test test = {
+	.setup = setup,
+	.cleanup = cleanup,
+	.test = run,
+	.tcnt = ARRAY_SIZE(tcases),
+	.needs_root = 1,
+	.needs_tmpdir = 1,
+	.forks_child = 1,
+	.needs_checkpoints = 1,
+	.runtime = 180,
+	.options = (struct tst_option[]) {
+		{"c:", &str_iterations, "Namespace sets created per worker (default 1000)"},
+		{"n:", &str_workers, "Number of workers (default number of CPUs)"},
+		{"b:", &str_batch, "Namespace sets kept alive per worker before teardown (default 16)"},
+		{"m:", &str_mounts, "Number of bind mounts to copy with the mount namespace"},
+		{}
+	},
+};
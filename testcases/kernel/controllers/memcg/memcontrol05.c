@@ -0,0 +1,329 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) Linux Test Project, 2026
+ */
+
+/*\
+ * Measure how fast memory is reclaimed from a memory cgroup.
+ *
+ * A child in a new group allocates a mix of anonymous memory, shmem and
+ * page cache, in the ratio given by -r, and the parent then forces the group
+ * to give back half of the reclaimable memory by:
+ *
+ * - lowering memory.high
+ * - lowering memory.max
+ * - writing to memory.reclaim
+ *
+ * The test reports the time until memory.current dropped under the target,
+ * the reclaim throughput, how much of each memory type was reclaimed and the
+ * memory and full stall time from memory.pressure (PSI). The test fails if
+ * the target is not reached within 10 seconds.
+ *
+ * The page cache is written back before the measurement, so that the reclaim
+ * does not wait for the writeback. On tmpfs the file is shmem as well.
+ * Anonymous memory and shmem count as reclaimable only when there is enough
+ * free swap. The test fails as well when the child is OOM killed instead of
+ * the memory being reclaimed.
+ */
+
+#define _GNU_SOURCE
+#include "memcontrol_common.h"
+#include "tst_safe_clocks.h"
+#include "tst_timer.h"
+
+#define TEST_FILE "file"
+#define RECLAIM_TIMEOUT_US 10000000
+
+static char *str_size_mb;
+static char *str_ratio;
+
+static int size_mb = 192;
+static unsigned int ratio[3] = {1, 1, 1};
+static size_t anon_sz, shmem_sz, file_sz;
+static size_t page_size;
+static int has_swap;
+
+static struct tst_cg_group *cg_child;
+
+static struct tcase {
+	const char *name;
+	const char *file;
+} tcases[] = {
+	{"memory.high", "memory.high"},
+	{"memory.max", "memory.max"},
+	{"memory.reclaim", "memory.reclaim"},
+};
+
+struct memcg_state {
+	ssize_t current;
+	ssize_t anon;
+	ssize_t file;
+	ssize_t shmem;
+	unsigned long long psi_some;
+	unsigned long long psi_full;
+};
+
+static long long now_us(void)
+{
+	struct timespec ts;
+
+	SAFE_CLOCK_GETTIME(CLOCK_MONOTONIC, &ts);
+
+	return tst_timespec_to_us(ts);
+}
+
+static void state_read(struct memcg_state *st)
+{
+	SAFE_CG_SCANF(cg_child, "memory.current", "%zd", &st->current);
+	SAFE_CG_LINES_SCANF(cg_child, "memory.stat", "anon %zd", &st->anon);
+	SAFE_CG_LINES_SCANF(cg_child, "memory.stat", "file %zd", &st->file);
+	SAFE_CG_LINES_SCANF(cg_child, "memory.stat", "shmem %zd", &st->shmem);
+
+	st->psi_some = st->psi_full = 0;
+
+	if (!SAFE_CG_HAS(cg_child, "memory.pressure"))
+		return;
+
+	SAFE_CG_LINES_SCANF(cg_child, "memory.pressure",
+			    "some avg10=%*f avg60=%*f avg300=%*f total=%llu",
+			    &st->psi_some);
+	SAFE_CG_LINES_SCANF(cg_child, "memory.pressure",
+			    "full avg10=%*f avg60=%*f avg300=%*f total=%llu",
+			    &st->psi_full);
+}
+
+static void touch(char *buf, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size; i += page_size)
+		buf[i] = 1;
+}
+
+static void fill_group(void)
+{
+	int fd;
+
+	SAFE_CG_PRINTF(cg_child, "cgroup.procs", "%d", getpid());
+
+	if (anon_sz) {
+		touch(SAFE_MMAP(NULL, anon_sz, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0), anon_sz);
+	}
+
+	if (shmem_sz) {
+		touch(SAFE_MMAP(NULL, shmem_sz, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_ANONYMOUS, -1, 0), shmem_sz);
+	}
+
+	fd = SAFE_OPEN(TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	alloc_pagecache(fd, file_sz);
+	SAFE_FSYNC(fd);
+	SAFE_CLOSE(fd);
+
+	/* keep the memory until the parent is done */
+	TST_CHECKPOINT_WAKE_AND_WAIT(0);
+
+	exit(0);
+}
+
+static int write_reclaim(size_t bytes)
+{
+	char buf[32];
+	int fd, ret;
+
+	SAFE_CG_OPEN(cg_child, "memory.reclaim", O_WRONLY, &fd);
+
+	snprintf(buf, sizeof(buf), "%zu", bytes);
+	ret = write(fd, buf, strlen(buf));
+
+	if (ret < 0 && errno != EAGAIN)
+		tst_brk(TBROK | TERRNO, "write(memory.reclaim, %s)", buf);
+
+	SAFE_CLOSE(fd);
+
+	return ret < 0;
+}
+
+static size_t reclaimable(const struct memcg_state *st)
+{
+	size_t ret = st->file - st->shmem;
+
+	if (has_swap)
+		ret += st->anon + st->shmem;
+
+	return ret;
+}
+
+static void run(unsigned int n)
+{
+	struct tcase *tc = &tcases[n];
+	struct memcg_state before, after;
+	ssize_t goal, target, current;
+	long long start, end;
+	double reclaimed_mb;
+	int failed = 0, status;
+	pid_t pid;
+
+	cg_child = tst_cg_group_mk(tst_cg, "reclaim");
+
+	pid = SAFE_FORK();
+	if (!pid)
+		fill_group();
+
+	/* don't wait forever when the child is killed while filling the group */
+	while (tst_checkpoint_wait(0, 100)) {
+		if (errno != ETIMEDOUT)
+			tst_brk(TBROK | TERRNO, "tst_checkpoint_wait(0)");
+
+		if (SAFE_WAITPID(pid, &status, WNOHANG)) {
+			tst_brk(TBROK, "%s: child %s while filling the group",
+				tc->name, tst_strstatus(status));
+		}
+	}
+
+	state_read(&before);
+
+	tst_res(TINFO, "%s: memory.current %zd MB, anon %zd MB, file %zd MB, shmem %zd MB",
+		tc->name, before.current / TST_MB, before.anon / TST_MB,
+		(before.file - before.shmem) / TST_MB, before.shmem / TST_MB);
+
+	goal = reclaimable(&before) / 2;
+	if (goal < MB(1)) {
+		TST_CHECKPOINT_WAKE(0);
+		SAFE_WAITPID(pid, NULL, 0);
+		cg_child = tst_cg_group_rm(cg_child);
+		tst_res(TCONF, "Nothing to reclaim, %s", has_swap ?
+			"the group is empty" : "there is no swap for anon and shmem");
+		return;
+	}
+
+	target = before.current - goal;
+
+	start = now_us();
+
+	if (!strcmp(tc->file, "memory.reclaim"))
+		failed = write_reclaim(goal);
+	else
+		SAFE_CG_PRINTF(cg_child, tc->file, "%zd", target);
+
+	for (;;) {
+		SAFE_CG_SCANF(cg_child, "memory.current", "%zd", &current);
+		end = now_us();
+
+		if (current <= target || failed ||
+		    end - start > RECLAIM_TIMEOUT_US)
+			break;
+
+		usleep(1000);
+	}
+
+	state_read(&after);
+
+	if (strcmp(tc->file, "memory.reclaim"))
+		SAFE_CG_PRINT(cg_child, tc->file, "max");
+
+	if (SAFE_WAITPID(pid, &status, WNOHANG)) {
+		cg_child = tst_cg_group_rm(cg_child);
+		SAFE_UNLINK(TEST_FILE);
+		tst_res(TFAIL, "%s: child %s instead of memory being reclaimed",
+			tc->name, tst_strstatus(status));
+		return;
+	}
+
+	TST_CHECKPOINT_WAKE(0);
+	SAFE_WAITPID(pid, NULL, 0);
+	cg_child = tst_cg_group_rm(cg_child);
+	SAFE_UNLINK(TEST_FILE);
+
+	reclaimed_mb = (double)(before.current - after.current) / TST_MB;
+
+	tst_res(TINFO, "%s: reclaimed %.1f MB in %.2f ms, %.1f MB/s",
+		tc->name, reclaimed_mb, (end - start) / 1000.0,
+		reclaimed_mb * 1000000 / MAX(end - start, 1));
+
+	tst_res(TINFO, "%s: reclaimed anon %zd MB, file %zd MB, shmem %zd MB",
+		tc->name, (before.anon - after.anon) / TST_MB,
+		(before.file - before.shmem - after.file + after.shmem) / TST_MB,
+		(before.shmem - after.shmem) / TST_MB);
+
+	tst_res(TINFO, "%s: PSI memory stall some %llu us, full %llu us",
+		tc->name, after.psi_some - before.psi_some,
+		after.psi_full - before.psi_full);
+
+	if (failed) {
+		tst_res(TFAIL, "%s: could not reclaim %zd MB", tc->name,
+			goal / TST_MB);
+		return;
+	}
+
+	if (current > target) {
+		tst_res(TFAIL, "%s: memory.current %zd MB over %zd MB after %i s",
+			tc->name, current / TST_MB, target / TST_MB,
+			RECLAIM_TIMEOUT_US / 1000000);
+		return;
+	}
+
+	tst_res(TPASS, "%s: memory.current under %zd MB after %.2f ms",
+		tc->name, target / TST_MB, (end - start) / 1000.0);
+}
+
+static void setup(void)
+{
+	unsigned int sum;
+	size_t total;
+
+	if (tst_parse_int(str_size_mb, &size_mb, 1, INT_MAX / 2))
+		tst_brk(TBROK, "Invalid size '%s'", str_size_mb);
+
+	if (str_ratio && sscanf(str_ratio, "%u:%u:%u",
+				&ratio[0], &ratio[1], &ratio[2]) != 3)
+		tst_brk(TBROK, "Invalid ratio '%s'", str_ratio);
+
+	sum = ratio[0] + ratio[1] + ratio[2];
+	if (!sum)
+		tst_brk(TBROK, "Invalid ratio '%s'", str_ratio);
+
+	page_size = SAFE_SYSCONF(_SC_PAGESIZE);
+	total = (size_t)size_mb * TST_MB;
+
+	anon_sz = total / sum * ratio[0];
+	file_sz = total / sum * ratio[1];
+	shmem_sz = total / sum * ratio[2];
+
+	if ((long)(total / 1024) > SAFE_READ_MEMINFO("MemAvailable:") / 2)
+		tst_brk(TCONF, "Not enough free memory for %i MB", size_mb);
+
+	if (!tst_fs_has_free(".", file_sz, TST_BYTES))
+		tst_brk(TCONF, "Not enough space for %zu MB file", file_sz / TST_MB);
+
+	has_swap = SAFE_READ_MEMINFO("SwapFree:") > (long)(total / 1024);
+
+	tst_res(TINFO, "%i MB in anon:file:shmem ratio %u:%u:%u, %s",
+		size_mb, ratio[0], ratio[1], ratio[2],
+		has_swap ? "swap available" : "no swap, file only is reclaimable");
+}
+
+static void cleanup(void)
+{
+	if (cg_child)
+		cg_child = tst_cg_group_rm(cg_child);
+}
+
+static struct tst_test test = {
+	.setup = setup,
+	.cleanup = cleanup,
+	.test = run,
+	.tcnt = ARRAY_SIZE(tcases),
+	.needs_tmpdir = 1,
+	.forks_child = 1,
+	.needs_root = 1,
+	.needs_checkpoints = 1,
+	.needs_cgroup_ver = TST_CG_V2,
+	.needs_cgroup_ctrls = (const char *const[]){ "memory", NULL },
+	.options = (struct tst_option[]) {
+		{"m:", &str_size_mb, "Memory in the group in MB (default 192)"},
+		{"r:", &str_ratio, "anon:file:shmem ratio (default 1:1:1)"},
+		{}
+	},
+};
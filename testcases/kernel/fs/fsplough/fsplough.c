@@ -6,69 +6,115 @@
 /*\
  * Write data into a test file using various methods and verify that file
  * contents match what was written.
+ *
+ * Multiple threads may plough separate regions of the test file in parallel.
+ * Throughput and latency of each I/O method is reported at the end.
  */
 
 #define _GNU_SOURCE
 #include <fcntl.h>
+#include <pthread.h>
+#include <stddef.h>
 #include <sys/statvfs.h>
 #include "tst_test.h"
 #include "tst_safe_prw.h"
+#include "tst_safe_pthread.h"
+#include "tst_safe_io_uring.h"
 
 #define MAX_VEC 8
+#define MAX_THREADS 64
 #define TEST_FILENAME "fsplough.dat"
 
-typedef void (*io_func)(void *buf, size_t offset, size_t size);
+struct io_stat {
+	unsigned long long count;
+	unsigned long long bytes;
+	unsigned long long time_ns;
+	unsigned long long max_ns;
+};
+
+struct plough;
+
+typedef void (*io_func)(struct plough *p, void *buf, size_t offset,
+	size_t size);
+
+struct io_method {
+	const char *name;
+	io_func func;
+	int uring;
+};
+
+static struct plough {
+	pthread_t thread;
+	int read_fd, write_fd;
+	char *writebuf, *filedata;
+	/* Offset of the thread's region in the test file */
+	size_t base;
+	unsigned int seed;
+	struct tst_io_uring uring;
+	struct io_stat write_stats[5], read_stats[5];
+	int loops, fails;
+} *ploughs;
 
 static char *workdir_arg;
 static char *directwr_flag;
 static char *directrd_flag;
 static char *loop_arg;
+static char *threads_arg;
+static char *uring_flag;
 static int loop_count;
+static int thread_count = 1;
+static int write_method_count, read_method_count;
 
-static int read_fd = -1, write_fd = -1;
-static char *writebuf, *filedata;
 static size_t blocksize, bufsize, filesize;
 
 static struct tst_test test;
-static void do_write(void *buf, size_t offset, size_t size);
-static void do_pwrite(void *buf, size_t offset, size_t size);
-static void do_writev(void *buf, size_t offset, size_t size);
-static void do_pwritev(void *buf, size_t offset, size_t size);
-static void do_read(void *buf, size_t offset, size_t size);
-static void do_pread(void *buf, size_t offset, size_t size);
-static void do_readv(void *buf, size_t offset, size_t size);
-static void do_preadv(void *buf, size_t offset, size_t size);
-
-static const io_func write_funcs[] = {
-	do_write,
-	do_pwrite,
-	do_writev,
-	do_pwritev
+static void do_write(struct plough *p, void *buf, size_t offset, size_t size);
+static void do_pwrite(struct plough *p, void *buf, size_t offset, size_t size);
+static void do_writev(struct plough *p, void *buf, size_t offset, size_t size);
+static void do_pwritev(struct plough *p, void *buf, size_t offset,
+	size_t size);
+static void do_uring_writev(struct plough *p, void *buf, size_t offset,
+	size_t size);
+static void do_read(struct plough *p, void *buf, size_t offset, size_t size);
+static void do_pread(struct plough *p, void *buf, size_t offset, size_t size);
+static void do_readv(struct plough *p, void *buf, size_t offset, size_t size);
+static void do_preadv(struct plough *p, void *buf, size_t offset, size_t size);
+static void do_uring_readv(struct plough *p, void *buf, size_t offset,
+	size_t size);
+
+/* io_uring methods must be at the end, they are used only with -U */
+static const struct io_method write_funcs[] = {
+	{"write", do_write, 0},
+	{"pwrite", do_pwrite, 0},
+	{"writev", do_writev, 0},
+	{"pwritev", do_pwritev, 0},
+	{"io_uring writev", do_uring_writev, 1},
 };
 
-static const io_func read_funcs[] = {
-	do_read,
-	do_pread,
-	do_readv,
-	do_preadv
+static const struct io_method read_funcs[] = {
+	{"read", do_read, 0},
+	{"pread", do_pread, 0},
+	{"readv", do_readv, 0},
+	{"preadv", do_preadv, 0},
+	{"io_uring readv", do_uring_readv, 1},
 };
 
-static size_t fill_buffer(char *buf, size_t size)
+static size_t fill_buffer(struct plough *p, char *buf, size_t size)
 {
-	size_t i, ret = MAX_VEC + 1 + rand() % (size - MAX_VEC);
+	size_t i, ret = MAX_VEC + 1 + rand_r(&p->seed) % (size - MAX_VEC);
 
 	/* Align buffer size to block size */
 	if (directwr_flag || directrd_flag)
 		ret = MAX(LTP_ALIGN(ret, blocksize), MAX_VEC * blocksize);
 
 	for (i = 0; i < ret; i++)
-		buf[i] = rand();
+		buf[i] = rand_r(&p->seed);
 
 	return ret;
 }
 
-static void vectorize_buffer(struct iovec *vec, size_t vec_size, char *buf,
-	size_t buf_size, int align)
+static void vectorize_buffer(struct plough *p, struct iovec *vec,
+	size_t vec_size, char *buf, size_t buf_size, int align)
 {
 	size_t i, len, chunk = align ? blocksize : 1;
 
@@ -76,7 +122,7 @@ static void vectorize_buffer(struct iovec *vec, size_t vec_size, char *buf,
 	buf_size /= chunk;
 
 	for (i = 0; buf_size && i < vec_size; i++) {
-		len = 1 + rand() % (buf_size + i + 1 - vec_size);
+		len = 1 + rand_r(&p->seed) % (buf_size + i + 1 - vec_size);
 		vec[i].iov_base = buf;
 		vec[i].iov_len = len * chunk;
 		buf += vec[i].iov_len;
@@ -86,65 +132,143 @@ static void vectorize_buffer(struct iovec *vec, size_t vec_size, char *buf,
 	vec[vec_size - 1].iov_len += buf_size * chunk;
 }
 
-static void update_filedata(const void *buf, size_t offset, size_t size)
+static void update_filedata(struct plough *p, const void *buf, size_t offset,
+	size_t size)
 {
-	memcpy(filedata + offset, buf, size * sizeof(char));
+	memcpy(p->filedata + offset, buf, size * sizeof(char));
 }
 
-static void do_write(void *buf, size_t offset, size_t size)
+static void uring_rw(struct plough *p, int opcode, int fd, struct iovec *vec,
+	unsigned int vec_size, size_t offset, size_t size)
 {
-	SAFE_LSEEK(write_fd, offset, SEEK_SET);
-	SAFE_WRITE(1, write_fd, buf, size);
+	struct tst_io_uring *uring = &p->uring;
+	struct io_uring_sqe *sqe = tst_io_uring_get_sqe(uring);
+	const struct io_uring_cqe *cqe;
+	int res;
+
+	if (!sqe)
+		tst_brk(TBROK, "io_uring submission queue is full");
+
+	tst_io_uring_prep_rw(sqe, opcode, fd, vec, vec_size, offset);
+	SAFE_IO_URING_SUBMIT(uring, 1);
+	cqe = tst_io_uring_peek_cqe(uring);
+
+	if (!cqe)
+		tst_brk(TBROK, "io_uring_enter() returned without completion");
+
+	res = cqe->res;
+	tst_io_uring_cqe_seen(uring);
+
+	if (res < 0) {
+		tst_brk(TBROK, "io_uring %s failed: %s",
+			opcode == IORING_OP_WRITEV ? "writev" : "readv",
+			tst_strerrno(-res));
+	}
+
+	if ((size_t)res != size) {
+		tst_brk(TBROK, "io_uring %s transferred %d bytes (expected %zu)",
+			opcode == IORING_OP_WRITEV ? "writev" : "readv",
+			res, size);
+	}
+}
+
+static void do_write(struct plough *p, void *buf, size_t offset, size_t size)
+{
+	SAFE_LSEEK(p->write_fd, p->base + offset, SEEK_SET);
+	SAFE_WRITE(1, p->write_fd, buf, size);
 }
 
-static void do_pwrite(void *buf, size_t offset, size_t size)
+static void do_pwrite(struct plough *p, void *buf, size_t offset, size_t size)
 {
-	SAFE_PWRITE(1, write_fd, buf, size, offset);
+	SAFE_PWRITE(1, p->write_fd, buf, size, p->base + offset);
+}
+
+static void do_writev(struct plough *p, void *buf, size_t offset, size_t size)
+{
+	struct iovec vec[MAX_VEC] = {};
+
+	vectorize_buffer(p, vec, MAX_VEC, buf, size, !!directwr_flag);
+	SAFE_LSEEK(p->write_fd, p->base + offset, SEEK_SET);
+	SAFE_WRITEV(1, p->write_fd, vec, MAX_VEC);
 }
 
-static void do_writev(void *buf, size_t offset, size_t size)
+static void do_pwritev(struct plough *p, void *buf, size_t offset, size_t size)
 {
 	struct iovec vec[MAX_VEC] = {};
 
-	vectorize_buffer(vec, MAX_VEC, buf, size, !!directwr_flag);
-	SAFE_LSEEK(write_fd, offset, SEEK_SET);
-	SAFE_WRITEV(1, write_fd, vec, MAX_VEC);
+	vectorize_buffer(p, vec, MAX_VEC, buf, size, !!directwr_flag);
+	SAFE_PWRITEV(1, p->write_fd, vec, MAX_VEC, p->base + offset);
 }
 
-static void do_pwritev(void *buf, size_t offset, size_t size)
+static void do_uring_writev(struct plough *p, void *buf, size_t offset,
+	size_t size)
 {
 	struct iovec vec[MAX_VEC] = {};
 
-	vectorize_buffer(vec, MAX_VEC, buf, size, !!directwr_flag);
-	SAFE_PWRITEV(1, write_fd, vec, MAX_VEC, offset);
+	vectorize_buffer(p, vec, MAX_VEC, buf, size, !!directwr_flag);
+	uring_rw(p, IORING_OP_WRITEV, p->write_fd, vec, MAX_VEC,
+		p->base + offset, size);
+}
+
+static void do_read(struct plough *p, void *buf, size_t offset, size_t size)
+{
+	SAFE_LSEEK(p->read_fd, p->base + offset, SEEK_SET);
+	SAFE_READ(1, p->read_fd, buf, size);
 }
 
-static void do_read(void *buf, size_t offset, size_t size)
+static void do_pread(struct plough *p, void *buf, size_t offset, size_t size)
 {
-	SAFE_LSEEK(read_fd, offset, SEEK_SET);
-	SAFE_READ(1, read_fd, buf, size);
+	SAFE_PREAD(1, p->read_fd, buf, size, p->base + offset);
 }
 
-static void do_pread(void *buf, size_t offset, size_t size)
+static void do_readv(struct plough *p, void *buf, size_t offset, size_t size)
 {
-	SAFE_PREAD(1, read_fd, buf, size, offset);
+	struct iovec vec[MAX_VEC] = {};
+
+	vectorize_buffer(p, vec, MAX_VEC, buf, size, !!directrd_flag);
+	SAFE_LSEEK(p->read_fd, p->base + offset, SEEK_SET);
+	SAFE_READV(1, p->read_fd, vec, MAX_VEC);
 }
 
-static void do_readv(void *buf, size_t offset, size_t size)
+static void do_preadv(struct plough *p, void *buf, size_t offset, size_t size)
 {
 	struct iovec vec[MAX_VEC] = {};
 
-	vectorize_buffer(vec, MAX_VEC, buf, size, !!directrd_flag);
-	SAFE_LSEEK(read_fd, offset, SEEK_SET);
-	SAFE_READV(1, read_fd, vec, MAX_VEC);
+	vectorize_buffer(p, vec, MAX_VEC, buf, size, !!directrd_flag);
+	SAFE_PREADV(1, p->read_fd, vec, MAX_VEC, p->base + offset);
 }
 
-static void do_preadv(void *buf, size_t offset, size_t size)
+static void do_uring_readv(struct plough *p, void *buf, size_t offset,
+	size_t size)
 {
 	struct iovec vec[MAX_VEC] = {};
 
-	vectorize_buffer(vec, MAX_VEC, buf, size, !!directrd_flag);
-	SAFE_PREADV(1, read_fd, vec, MAX_VEC, offset);
+	vectorize_buffer(p, vec, MAX_VEC, buf, size, !!directrd_flag);
+	uring_rw(p, IORING_OP_READV, p->read_fd, vec, MAX_VEC,
+		p->base + offset, size);
+}
+
+static long long diff_ns(struct timespec *end, struct timespec *start)
+{
+	return (end->tv_sec - start->tv_sec) * 1000000000LL +
+		end->tv_nsec - start->tv_nsec;
+}
+
+static void timed_io(struct plough *p, const struct io_method *method,
+	struct io_stat *stat, void *buf, size_t offset, size_t size)
+{
+	struct timespec start, end;
+	unsigned long long diff;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	method->func(p, buf, offset, size);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	diff = diff_ns(&end, &start);
+	stat->count++;
+	stat->bytes += size;
+	stat->time_ns += diff;
+	stat->max_ns = MAX(stat->max_ns, diff);
 }
 
 static int open_testfile(int flags)
@@ -161,8 +285,9 @@ static int open_testfile(int flags)
 static void setup(void)
 {
 	struct statvfs statbuf;
+	struct io_uring_params params;
 	size_t pagesize;
-	int runtime;
+	int i, runtime;
 
 	srand(time(0));
 	pagesize = SAFE_SYSCONF(_SC_PAGESIZE);
@@ -173,9 +298,27 @@ static void setup(void)
 	if (tst_parse_int(loop_arg, &loop_count, 0, INT_MAX))
 		tst_brk(TBROK, "Invalid write loop count: %s", loop_arg);
 
-	write_fd = open_testfile(O_WRONLY | O_CREAT | O_TRUNC);
-	read_fd = open_testfile(O_RDONLY);
-	TEST(fstatvfs(write_fd, &statbuf));
+	if (tst_parse_int(threads_arg, &thread_count, 1, MAX_THREADS))
+		tst_brk(TBROK, "Invalid thread count: %s", threads_arg);
+
+	write_method_count = ARRAY_SIZE(write_funcs);
+	read_method_count = ARRAY_SIZE(read_funcs);
+
+	if (!uring_flag) {
+		write_method_count--;
+		read_method_count--;
+	}
+
+	ploughs = SAFE_MALLOC(thread_count * sizeof(*ploughs));
+	memset(ploughs, 0, thread_count * sizeof(*ploughs));
+
+	for (i = 0; i < thread_count; i++) {
+		ploughs[i].read_fd = ploughs[i].write_fd = -1;
+		ploughs[i].uring.fd = -1;
+	}
+
+	ploughs[0].write_fd = open_testfile(O_WRONLY | O_CREAT | O_TRUNC);
+	TEST(fstatvfs(ploughs[0].write_fd, &statbuf));
 
 	if (TST_RET == -1)
 		tst_brk(TBROK | TTERRNO, "fstatvfs() failed");
@@ -186,9 +329,25 @@ static void setup(void)
 	tst_res(TINFO, "Block size: %zu", blocksize);
 	bufsize = 4 * MAX_VEC * MAX(pagesize, blocksize);
 	filesize = 1024 * MAX(pagesize, blocksize);
-	writebuf = SAFE_MMAP(NULL, bufsize, PROT_READ | PROT_WRITE,
-		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-	filedata = SAFE_MALLOC(filesize);
+
+	for (i = 0; i < thread_count; i++) {
+		struct plough *p = &ploughs[i];
+
+		if (i)
+			p->write_fd = open_testfile(O_WRONLY);
+
+		p->read_fd = open_testfile(O_RDONLY);
+		p->base = i * filesize;
+		p->seed = rand();
+		p->writebuf = SAFE_MMAP(NULL, bufsize, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		p->filedata = SAFE_MALLOC(filesize);
+
+		if (uring_flag) {
+			memset(&params, 0, sizeof(params));
+			SAFE_IO_URING_INIT(2, &params, &p->uring);
+		}
+	}
 
 	if (loop_arg) {
 		/*
@@ -203,74 +362,164 @@ static void setup(void)
 	}
 }
 
-static void run(void)
+static void *plough_thread(void *arg)
 {
+	struct plough *p = arg;
 	size_t start, length;
-	int i, f, fails = 0;
+	int i, f;
 
 	/* Test data consistency between random writes */
 	for (i = 0; !loop_arg || i < loop_count; i++) {
 		if (!tst_remaining_runtime())
 			break;
 
-		length = fill_buffer(writebuf, bufsize);
-		start = rand() % (filesize + 1 - length);
+		length = fill_buffer(p, p->writebuf, bufsize);
+		start = rand_r(&p->seed) % (filesize + 1 - length);
 
 		/* Align offset to blocksize if needed */
 		if (directrd_flag || directwr_flag)
 			start = (start + blocksize / 2) & ~(blocksize - 1);
 
-		update_filedata(writebuf, start, length);
-		f = rand() % ARRAY_SIZE(write_funcs);
-		write_funcs[f](writebuf, start, length);
+		update_filedata(p, p->writebuf, start, length);
+		f = rand_r(&p->seed) % write_method_count;
+		timed_io(p, &write_funcs[f], &p->write_stats[f], p->writebuf,
+			start, length);
 
-		memset(writebuf, 0, length);
-		f = rand() % ARRAY_SIZE(read_funcs);
-		read_funcs[f](writebuf, start, length);
+		memset(p->writebuf, 0, length);
+		f = rand_r(&p->seed) % read_method_count;
+		timed_io(p, &read_funcs[f], &p->read_stats[f], p->writebuf,
+			start, length);
 
-		if (memcmp(writebuf, filedata + start, length)) {
+		if (memcmp(p->writebuf, p->filedata + start, length)) {
 			tst_res(TFAIL, "Partial data mismatch at [%zu:%zu]",
-				start, start + length);
-			fails++;
+				p->base + start, p->base + start + length);
+			p->fails++;
 		}
 	}
 
-	if (i < loop_count / 2) {
+	p->loops = i;
+	return arg;
+}
+
+static void report_stats(const struct io_method *methods, int method_count,
+	size_t stats_offset)
+{
+	struct io_stat sum;
+	int i, j;
+
+	for (i = 0; i < method_count; i++) {
+		memset(&sum, 0, sizeof(sum));
+
+		for (j = 0; j < thread_count; j++) {
+			struct io_stat *stat = (void *)&ploughs[j] +
+				stats_offset;
+
+			sum.count += stat[i].count;
+			sum.bytes += stat[i].bytes;
+			sum.time_ns += stat[i].time_ns;
+			sum.max_ns = MAX(sum.max_ns, stat[i].max_ns);
+		}
+
+		if (!sum.count || !sum.time_ns)
+			continue;
+
+		tst_res(TINFO, "%-16s %8llu calls %10.2f MB/s avg %8.2f us max %8.2f us",
+			methods[i].name, sum.count,
+			1e9 * sum.bytes / sum.time_ns / (1024 * 1024),
+			sum.time_ns / 1e3 / sum.count, sum.max_ns / 1e3);
+	}
+}
+
+static void run(void)
+{
+	struct timespec start_time, end_time;
+	unsigned long long bytes = 0;
+	long long elapsed;
+	size_t start, length;
+	int i, j, loops = 0, fails = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+	for (i = 0; i < thread_count; i++)
+		SAFE_PTHREAD_CREATE(&ploughs[i].thread, NULL, plough_thread,
+			&ploughs[i]);
+
+	for (i = 0; i < thread_count; i++) {
+		SAFE_PTHREAD_JOIN(ploughs[i].thread, NULL);
+		loops = MIN(i ? loops : ploughs[i].loops, ploughs[i].loops);
+		fails += ploughs[i].fails;
+
+		for (j = 0; j < write_method_count; j++) {
+			bytes += ploughs[i].write_stats[j].bytes;
+			bytes += ploughs[i].read_stats[j].bytes;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end_time);
+	elapsed = diff_ns(&end_time, &start_time);
+
+	if (loops < loop_count / 2) {
 		tst_res(TWARN, "Runtime expired, exiting early after %d loops",
-			i);
+			loops);
 		tst_res(TINFO, "If you are running on slow machine, "
 			"try exporting LTP_TIMEOUT_MUL > 1");
-	} else if (i < loop_count) {
+	} else if (loops < loop_count) {
 		tst_res(TINFO, "Runtime expired, exiting early after %d loops",
-			i);
-	} else if (!loop_arg && i < 10) {
-		tst_res(TWARN, "Slow system: test performed only %d loops!", i);
+			loops);
+	} else if (!loop_arg && loops < 10) {
+		tst_res(TWARN, "Slow system: test performed only %d loops!",
+			loops);
 	} else {
-		tst_res(TPASS, "Exiting after %d loops", i);
+		tst_res(TPASS, "Exiting after %d loops", loops);
 	}
 
 	if (!fails)
 		tst_res(TPASS, "Partial data are consistent");
 
+	report_stats(write_funcs, write_method_count,
+		offsetof(struct plough, write_stats));
+	report_stats(read_funcs, read_method_count,
+		offsetof(struct plough, read_stats));
+
+	if (elapsed > 0) {
+		tst_res(TINFO, "Total %.2f MB/s with %d thread(s)",
+			1e9 * bytes / elapsed / (1024 * 1024), thread_count);
+	}
+
 	/* Ensure that the testfile has the expected size */
-	do_write(writebuf, filesize - blocksize, blocksize);
-	update_filedata(writebuf, filesize - blocksize, blocksize);
+	for (i = 0; i < thread_count; i++) {
+		struct plough *p = &ploughs[i];
+
+		do_pwrite(p, p->writebuf, filesize - blocksize, blocksize);
+		update_filedata(p, p->writebuf, filesize - blocksize,
+			blocksize);
+	}
 
 	/* Sync the testfile and clear cache */
-	SAFE_CLOSE(read_fd);
-	SAFE_FSYNC(write_fd);
+	SAFE_FSYNC(ploughs[0].write_fd);
+
+	for (i = 0; i < thread_count; i++)
+		SAFE_CLOSE(ploughs[i].read_fd);
+
 	SAFE_FILE_PRINTF("/proc/sys/vm/drop_caches", "1");
-	read_fd = open_testfile(O_RDONLY);
+
+	for (i = 0; i < thread_count; i++)
+		ploughs[i].read_fd = open_testfile(O_RDONLY);
 
 	/* Check final file contents */
-	for (start = 0; start < filesize; start += bufsize) {
-		length = MIN(bufsize, filesize - start);
-		SAFE_READ(1, read_fd, writebuf, length);
-
-		if (memcmp(writebuf, filedata + start, length)) {
-			tst_res(TFAIL, "Final data mismatch at [%zu:%zu]",
-				start, start + length);
-			return;
+	for (i = 0; i < thread_count; i++) {
+		struct plough *p = &ploughs[i];
+
+		for (start = 0; start < filesize; start += bufsize) {
+			length = MIN(bufsize, filesize - start);
+			SAFE_READ(1, ploughs[0].read_fd, p->writebuf, length);
+
+			if (memcmp(p->writebuf, p->filedata + start, length)) {
+				tst_res(TFAIL, "Final data mismatch at [%zu:%zu]",
+					p->base + start,
+					p->base + start + length);
+				return;
+			}
 		}
 	}
 
@@ -279,15 +528,27 @@ static void run(void)
 
 static void cleanup(void)
 {
-	SAFE_MUNMAP(writebuf, bufsize);
-	free(filedata);
+	int i;
 
-	if (read_fd >= 0)
-		SAFE_CLOSE(read_fd);
+	for (i = 0; ploughs && i < thread_count; i++) {
+		struct plough *p = &ploughs[i];
 
-	if (write_fd >= 0)
-		SAFE_CLOSE(write_fd);
+		if (p->writebuf)
+			SAFE_MUNMAP(p->writebuf, bufsize);
+
+		free(p->filedata);
+
+		if (p->uring.fd >= 0)
+			SAFE_IO_URING_CLOSE(&p->uring);
+
+		if (p->read_fd >= 0)
+			SAFE_CLOSE(p->read_fd);
+
+		if (p->write_fd >= 0)
+			SAFE_CLOSE(p->write_fd);
+	}
 
+	free(ploughs);
 	SAFE_UNLINK(TEST_FILENAME);
 }
 
@@ -303,6 +564,9 @@ static struct tst_test test = {
 		{"d:", &workdir_arg, "Path to working directory"},
 		{"W", &directwr_flag, "Use direct I/O for writing"},
 		{"R", &directrd_flag, "Use direct I/O for reading"},
+		{"t:", &threads_arg,
+			"Number of threads ploughing the file (default: 1)"},
+		{"U", &uring_flag, "Use io_uring for reading and writing too"},
 		{}
 	}
 };
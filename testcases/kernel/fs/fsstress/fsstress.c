@@ -38,6 +38,7 @@
 # include <sys/prctl.h>
 #endif
 #include <limits.h>
+#include <stdint.h>
 
 #define XFS_ERRTAG_MAX		17
 
@@ -109,6 +110,35 @@ typedef struct pathname {
 	char *path;
 } pathname_t;
 
+/*
+ * Operation journal, one file per process named <journal>.<procid>.
+ *
+ * Each record stores the operation, the argument passed to the operation
+ * function and the seed of the random stream the operation consumes
+ * internally, so that the sequence can be re-executed regardless of how
+ * many random numbers the individual operations have drawn.
+ */
+#define	JOURNAL_MAGIC	0x4a535346	/* "FSSJ" */
+#define	JOURNAL_VERSION	1
+
+typedef struct jhdr {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t nops;
+	uint32_t procid;
+	uint32_t namerand;
+	uint64_t seed;
+} jhdr_t;
+
+typedef struct jrec {
+	uint32_t r;
+	uint32_t opseed;
+	uint16_t op;
+	uint16_t pad;
+} jrec_t;
+
+#define	RSTATE_SIZE	128
+
 #define	FT_DIR	0
 #define	FT_DIRm	(1 << FT_DIR)
 #define	FT_REG	1
@@ -227,6 +257,12 @@ int operations = 1;
 int procid;
 int rtpct;
 unsigned long seed = 0;
+char *journal;
+int replay;
+int replay_serial;
+long replay_limit = -1;
+char master_state[RSTATE_SIZE];
+char op_state[RSTATE_SIZE];
 ino_t top_ino;
 int verbose = 0;
 #ifndef NO_XFS
@@ -252,12 +288,19 @@ void dcache_purge(int);
 void del_from_flist(int, int);
 int dirid_to_name(char *, int);
 void doproc(void);
+void doproc_replay(void);
 void fent_to_name(pathname_t *, flist_t *, fent_t *);
 void fix_parent(int, int);
 void free_pathname(pathname_t *);
 int generate_fname(fent_t *, int, pathname_t *, int *, int *);
 int get_fname(int, long, pathname_t *, flist_t **, fent_t **, int *);
 void init_pathname(pathname_t *);
+int journal_bisect(char *, char *);
+int run_argv(char *const[]);
+int journal_count(void);
+long journal_len(int);
+void journal_name(char *, size_t, int);
+int journal_open(int, jhdr_t *);
 int lchown_path(pathname_t *, uid_t, gid_t);
 int link_path(pathname_t *, pathname_t *);
 int lstat64_path(pathname_t *, struct stat64 *);
@@ -311,14 +354,20 @@ int main(int argc, char **argv)
 	xfs_error_injection_t err_inj;
 #endif
 	struct sigaction action;
+	char *bisect_cmd = NULL;
+	char *jpath;
+	pid_t pid;
 
 	errrange = errtag = 0;
 	umask(0);
 	nops = ARRAY_SIZE(ops);
 	ops_end = &ops[nops];
 	myprog = argv[0];
-	while ((c = getopt(argc, argv, "cd:e:f:i:l:n:p:rs:vwzHSX")) != -1) {
+	while ((c = getopt(argc, argv, "B:cd:e:f:i:j:J:l:n:N:Op:rs:vwzHSX")) != -1) {
 		switch (c) {
+		case 'B':
+			bisect_cmd = optarg;
+			break;
 		case 'c':
 			/*Don't cleanup */
 			cleanup = 1;
@@ -347,12 +396,26 @@ int main(int argc, char **argv)
 			ilist = realloc(ilist, ++ilistlen * sizeof(*ilist));
 			ilist[ilistlen - 1] = strtol(optarg, &p, 16);
 			break;
+		case 'j':
+			journal = optarg;
+			replay = 0;
+			break;
+		case 'J':
+			journal = optarg;
+			replay = 1;
+			break;
 		case 'l':
 			loops = atoi(optarg);
 			break;
 		case 'n':
 			operations = atoi(optarg);
 			break;
+		case 'N':
+			replay_limit = atol(optarg);
+			break;
+		case 'O':
+			replay_serial = 1;
+			break;
 		case 'p':
 			nproc = atoi(optarg);
 			break;
@@ -401,6 +464,42 @@ int main(int argc, char **argv)
 		}
 	}
 
+	if (journal) {
+		if (loops != 1) {
+			fprintf(stderr, "journal works only with a single loop\n");
+			exit(1);
+		}
+		if (journal[0] != '/') {
+			p = getcwd(NULL, 0);
+			if (!p || asprintf(&jpath, "%s/%s", p, journal) < 0) {
+				perror("getcwd");
+				exit(1);
+			}
+			free(p);
+			journal = jpath;
+		}
+	}
+
+	if ((bisect_cmd || replay_serial || replay_limit >= 0) && !replay) {
+		fprintf(stderr, "-B, -N and -O require a journal to replay (-J)\n");
+		exit(1);
+	}
+
+	if (replay) {
+		nproc = journal_count();
+		if (!nproc) {
+			fprintf(stderr, "no journal found at %s.0\n", journal);
+			exit(1);
+		}
+		if (bisect_cmd) {
+			if (!dirname) {
+				usage();
+				exit(1);
+			}
+			exit(journal_bisect(dirname, bisect_cmd));
+		}
+	}
+
 	make_freq_table();
 
 	while (((loopcntr <= loops) || (loops == 0)) && !should_stop) {
@@ -424,7 +523,7 @@ int main(int argc, char **argv)
 			maxfsize = (off64_t) MAXFSIZE;
 		dcache_init();
 		setlinebuf(stdout);
-		if (!seed) {
+		if (!seed && !replay) {
 			gettimeofday(&t, NULL);
 			seed = (int)t.tv_sec ^ (int)t.tv_usec;
 			printf("seed = %ld\n", seed);
@@ -483,7 +582,10 @@ int main(int argc, char **argv)
 
 		if (nproc == 1) {
 			procid = 0;
-			doproc();
+			if (replay)
+				doproc_replay();
+			else
+				doproc();
 		} else {
 			setpgid(0, 0);
 			action.sa_handler = sg_handler;
@@ -495,7 +597,8 @@ int main(int argc, char **argv)
 			}
 
 			for (i = 0; i < nproc; i++) {
-				if (fork() == 0) {
+				pid = fork();
+				if (pid == 0) {
 
 					action.sa_handler = SIG_DFL;
 					sigemptyset(&action.sa_mask);
@@ -507,9 +610,14 @@ int main(int argc, char **argv)
 						return 0;
 #endif
 					procid = i;
-					doproc();
+					if (replay)
+						doproc_replay();
+					else
+						doproc();
 					return 0;
 				}
+				if (replay_serial && pid > 0)
+					waitpid(pid, &stat, 0);
 			}
 			while (wait(&stat) > 0 && !should_stop) {
 				continue;
@@ -752,9 +860,15 @@ void doproc(void)
 {
 	struct stat64 statbuf;
 	char buf[10];
+	char jname[PATH_MAX];
 	int opno;
 	int rval;
+	int jfd = -1;
 	opdesc_t *p;
+	jhdr_t hdr;
+	jrec_t rec;
+	long r;
+	unsigned int opseed;
 
 	sprintf(buf, "p%x", procid);
 	(void)mkdir(buf, 0777);
@@ -765,15 +879,58 @@ void doproc(void)
 	top_ino = statbuf.st_ino;
 	homedir = getcwd(NULL, -1);
 	seed += procid;
-	srandom(seed);
+	/*
+	 * Without a journal keep the original random stream so that the
+	 * recorded -s seeds of earlier runs still reproduce.
+	 */
+	if (journal)
+		initstate(seed, master_state, sizeof(master_state));
+	else
+		srandom(seed);
 	if (namerand)
 		namerand = random();
+	if (journal) {
+		journal_name(jname, sizeof(jname), procid);
+		jfd = open(jname, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+		memset(&hdr, 0, sizeof(hdr));
+		hdr.magic = JOURNAL_MAGIC;
+		hdr.version = JOURNAL_VERSION;
+		hdr.nops = nops;
+		hdr.procid = procid;
+		hdr.namerand = namerand;
+		hdr.seed = seed;
+		if (jfd < 0 || write(jfd, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+			perror(jname);
+			_exit(1);
+		}
+	}
 	for (opno = 0; opno < operations; opno++) {
 		p = &ops[freq_table[random() % freq_table_size]];
 		if ((unsigned long)p->func < 4096)
 			abort();
 
-		p->func(opno, random());
+		r = random();
+		if (jfd < 0) {
+			p->func(opno, r);
+		} else {
+			opseed = random();
+			memset(&rec, 0, sizeof(rec));
+			rec.r = r;
+			rec.opseed = opseed;
+			rec.op = p->op;
+			if (write(jfd, &rec, sizeof(rec)) != sizeof(rec)) {
+				perror(jname);
+				_exit(1);
+			}
+			/*
+			 * Operations draw from their own stream so that the
+			 * main stream, and hence the journal, does not depend
+			 * on the outcome of the previous operations.
+			 */
+			initstate(opseed, op_state, sizeof(op_state));
+			p->func(opno, r);
+			setstate(master_state);
+		}
 		/*
 		 * test for forced shutdown by stat'ing the test
 		 * directory.  If this stat returns EIO, assume
@@ -783,10 +940,55 @@ void doproc(void)
 			rval = stat64(".", &statbuf);
 			if (rval == EIO) {
 				fprintf(stderr, "Detected EIO\n");
-				return;
+				break;
 			}
 		}
 	}
+	if (jfd >= 0)
+		close(jfd);
+}
+
+void doproc_replay(void)
+{
+	struct stat64 statbuf;
+	char buf[10];
+	opdesc_t *optab[OP_LAST] = { NULL };
+	opdesc_t *p;
+	jhdr_t hdr;
+	jrec_t rec;
+	int opno;
+	int jfd;
+
+	for (p = ops; p < ops_end; p++)
+		optab[p->op] = p;
+
+	jfd = journal_open(procid, &hdr);
+	if (jfd < 0)
+		_exit(1);
+
+	sprintf(buf, "p%x", procid);
+	(void)mkdir(buf, 0777);
+	if (chdir(buf) < 0 || stat64(".", &statbuf) < 0) {
+		perror(buf);
+		_exit(1);
+	}
+	top_ino = statbuf.st_ino;
+	homedir = getcwd(NULL, -1);
+	seed = hdr.seed;
+	namerand = hdr.namerand;
+	for (opno = 0; replay_limit < 0 || opno < replay_limit; opno++) {
+		if (read(jfd, &rec, sizeof(rec)) != sizeof(rec))
+			break;
+		if (rec.op >= OP_LAST || !optab[rec.op]) {
+			fprintf(stderr, "%d/%d: invalid operation %u in journal\n",
+				procid, opno, rec.op);
+			_exit(1);
+		}
+		p = optab[rec.op];
+		initstate(rec.opseed, op_state, sizeof(op_state));
+		p->func(opno, rec.r);
+	}
+	close(jfd);
 }
 
 void fent_to_name(pathname_t * name, flist_t * flp, fent_t * fep)
@@ -918,6 +1120,158 @@ void init_pathname(pathname_t * name)
 	name->path = NULL;
 }
 
+/*
+ * Runs argv and returns its exit status, -1 if it could not be run. The
+ * arguments are passed as they are, so there is no shell quoting involved.
+ */
+int run_argv(char *const argv[])
+{
+	pid_t pid;
+	int status;
+
+	fflush(stdout);
+	fflush(stderr);
+
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		return -1;
+	}
+	if (pid == 0) {
+		execvp(argv[0], argv);
+		perror(argv[0]);
+		_exit(127);
+	}
+	if (waitpid(pid, &status, 0) < 0) {
+		perror("waitpid");
+		return -1;
+	}
+	if (WIFEXITED(status))
+		return WEXITSTATUS(status);
+	return 128 + WTERMSIG(status);
+}
+
+/*
+ * Replays increasingly long prefixes of the journal in dir and runs cmd after
+ * each of them, looking for the shortest prefix for which cmd fails.
+ */
+int journal_bisect(char *dir, char *cmd)
+{
+	char nbuf[32];
+	char *replay_argv[] = {
+		myprog, "-c", "-d", dir, "-J", journal, "-N", nbuf,
+		NULL, NULL, NULL
+	};
+	char *check_argv[] = { "/bin/sh", "-c", cmd, NULL };
+	/* dir is passed as $1 and never parsed by the shell */
+	char *clean_argv[] = {
+		"/bin/sh", "-c", "rm -rf -- \"$1\"/*", "sh", dir, NULL
+	};
+	long lo = 0, hi = 0, mid, len;
+	int i, ret, argc = 8;
+
+	if (replay_serial)
+		replay_argv[argc++] = "-O";
+	if (verbose)
+		replay_argv[argc++] = "-v";
+
+	for (i = 0; i < nproc; i++) {
+		len = journal_len(i);
+		if (len < 0)
+			return 1;
+		hi = MAX(hi, len);
+	}
+
+	for (mid = hi; lo < hi; mid = lo + (hi - lo) / 2) {
+		snprintf(nbuf, sizeof(nbuf), "%ld", mid);
+		if (run_argv(replay_argv) < 0)
+			return 1;
+
+		ret = run_argv(check_argv);
+		if (ret < 0)
+			return 1;
+		printf("prefix %ld: %s\n", mid, ret ? "fails" : "passes");
+
+		if (run_argv(clean_argv)) {
+			fprintf(stderr, "failed to clean %s\n", dir);
+			return 1;
+		}
+
+		if (ret) {
+			hi = mid;
+		} else {
+			if (mid == hi) {
+				printf("check passes with the whole journal\n");
+				return 1;
+			}
+			lo = mid + 1;
+		}
+	}
+
+	printf("minimal failing prefix: %ld operations\n", hi);
+	return 0;
+}
+
+int journal_count(void)
+{
+	char name[PATH_MAX];
+	int i;
+
+	for (i = 0;; i++) {
+		journal_name(name, sizeof(name), i);
+		if (access(name, R_OK))
+			return i;
+	}
+}
+
+long journal_len(int id)
+{
+	struct stat64 statbuf;
+	char name[PATH_MAX];
+
+	journal_name(name, sizeof(name), id);
+	if (stat64(name, &statbuf) < 0) {
+		perror(name);
+		return -1;
+	}
+
+	return (statbuf.st_size - sizeof(jhdr_t)) / sizeof(jrec_t);
+}
+
+void journal_name(char *buf, size_t size, int id)
+{
+	snprintf(buf, size, "%s.%d", journal, id);
+}
+
+int journal_open(int id, jhdr_t *hdr)
+{
+	char name[PATH_MAX];
+	int fd;
+
+	journal_name(name, sizeof(name), id);
+	fd = open(name, O_RDONLY);
+	if (fd < 0) {
+		perror(name);
+		return -1;
+	}
+
+	if (read(fd, hdr, sizeof(*hdr)) != sizeof(*hdr) ||
+	    hdr->magic != JOURNAL_MAGIC || hdr->version != JOURNAL_VERSION) {
+		fprintf(stderr, "%s: not a fsstress journal\n", name);
+		close(fd);
+		return -1;
+	}
+
+	if (hdr->nops != nops) {
+		fprintf(stderr,
+			"%s: recorded with a different operation table\n", name);
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
 int lchown_path(pathname_t * name, uid_t owner, gid_t group)
 {
 	char buf[MAXNAMELEN];
@@ -1367,6 +1721,7 @@ void usage(void)
 	    ("       %s [-c][-d dir][-e errtg][-f op_name=freq][-l loops][-n nops]\n",
 	     myprog);
 	printf("          [-p nproc][-r len][-s seed][-v][-w][-z][-S]\n");
+	printf("          [-j journal | -J journal [-N nops][-O][-B cmd]]\n");
 	printf("where\n");
 	printf
 	    ("   -c               specifies not to remove files(cleanup) after execution\n");
@@ -1396,6 +1751,16 @@ void usage(void)
 	printf("   -H               prints usage and exits\n");
 	printf
 	    ("   -X               don't do anything XFS specific (default with -DNO_XFS)\n");
+	printf
+	    ("   -j journal       records operations of each process to journal.<procid>\n");
+	printf
+	    ("   -J journal       replays operations recorded with -j, one process per file\n");
+	printf
+	    ("   -N nops          replays only the first nops operations of each process\n");
+	printf
+	    ("   -O               replays the processes one after another\n");
+	printf
+	    ("   -B cmd           finds the shortest replayed prefix after which cmd fails\n");
 }
 
 void write_freq(void)
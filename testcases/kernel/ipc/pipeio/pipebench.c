@@ -0,0 +1,651 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) Linux Test Project, 2026
+ */
+
+/*\
+ * Throughput and latency matrix of the local IPC primitives.
+ *
+ * For each transport, message size and placement of the reader and the
+ * writer on the CPUs the test measures:
+ *
+ * - the throughput of a writer streaming messages to a reader
+ * - the round trip time of a message sent back and forth (ping-pong)
+ *
+ * The transports are a pipe, a pipe in packet mode (O_DIRECT), stream and
+ * datagram socketpairs, a pipe written by vmsplice(), a pipe read by splice()
+ * into /dev/null and an eventfd. The eventfd carries no data, only the round
+ * trip time of the handoff is measured for it. The vmsplice() writer reuses
+ * its buffer right away, which is fine for the benchmark but not for real
+ * data.
+ *
+ * The reader and the writer are pinned to:
+ *
+ * - same: the same CPU
+ * - smt: SMT siblings of a core
+ * - llc: CPUs sharing the last level cache that are not SMT siblings
+ * - node: CPUs on different NUMA nodes
+ *
+ * Placements not possible on the machine are skipped.
+ */
+
+#define _GNU_SOURCE
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include "tst_test.h"
+#include "tst_hist.h"
+#include "tst_safe_net.h"
+#include "lapi/fcntl.h"
+#include "lapi/splice.h"
+#include "lapi/vmsplice.h"
+
+#define CPU_PATH "/sys/devices/system/cpu"
+#define NODE_PATH "/sys/devices/system/node"
+#define MAX_SIZES 16
+#define MAX_ROUND_TRIPS 100000
+#define DGRAM_MAX_SIZE 65536
+
+static char *str_sizes;
+static char *str_placements;
+
+static size_t sizes[MAX_SIZES];
+static unsigned int nsizes;
+static long long measure_ns;
+static cpu_set_t orig_mask;
+static char *buf;
+static size_t buf_size;
+static int devnull = -1;
+
+struct chan {
+	int rfd;
+	int wfd;
+};
+
+struct transport {
+	const char *name;
+	void (*open)(struct chan *c);
+	ssize_t (*send)(int fd, const char *buf, size_t size);
+	ssize_t (*recv)(int fd, char *buf, size_t size);
+	/* maximal message size, 0 means unlimited */
+	size_t max_size;
+	/* fixed message size */
+	size_t fixed_size;
+};
+
+struct shared {
+	unsigned long long bytes;
+	struct tst_hist hist;
+};
+
+static struct shared *shared;
+
+static void open_pipe(struct chan *c)
+{
+	int fds[2];
+
+	SAFE_PIPE(fds);
+	c->rfd = fds[0];
+	c->wfd = fds[1];
+}
+
+static void open_pipe_direct(struct chan *c)
+{
+	int fds[2];
+
+	SAFE_PIPE2(fds, O_DIRECT);
+	c->rfd = fds[0];
+	c->wfd = fds[1];
+}
+
+static void open_socketpair(struct chan *c, int type)
+{
+	int sv[2];
+
+	SAFE_SOCKETPAIR(AF_UNIX, type, 0, sv);
+	c->rfd = sv[0];
+	c->wfd = sv[1];
+}
+
+static void open_stream(struct chan *c)
+{
+	open_socketpair(c, SOCK_STREAM);
+}
+
+static void open_dgram(struct chan *c)
+{
+	open_socketpair(c, SOCK_DGRAM);
+}
+
+static void open_eventfd(struct chan *c)
+{
+	c->rfd = c->wfd = eventfd(0, 0);
+
+	if (c->rfd < 0)
+		tst_brk(TBROK | TERRNO, "eventfd()");
+}
+
+static ssize_t send_write(int fd, const char *data, size_t size)
+{
+	return write(fd, data, size);
+}
+
+static ssize_t send_vmsplice(int fd, const char *data, size_t size)
+{
+	struct iovec iov = {
+		.iov_base = (void *)data,
+		.iov_len = size,
+	};
+
+	return vmsplice(fd, &iov, 1, 0);
+}
+
+static ssize_t send_eventfd(int fd, const char *data LTP_ATTRIBUTE_UNUSED,
+			    size_t size LTP_ATTRIBUTE_UNUSED)
+{
+	uint64_t val = 1;
+
+	return write(fd, &val, sizeof(val));
+}
+
+static ssize_t recv_read(int fd, char *data, size_t size)
+{
+	return read(fd, data, size);
+}
+
+static ssize_t recv_splice(int fd, char *data LTP_ATTRIBUTE_UNUSED,
+			   size_t size)
+{
+	return splice(fd, NULL, devnull, NULL, size, SPLICE_F_MOVE);
+}
+
+static struct transport transports[] = {
+	{"pipe", open_pipe, send_write, recv_read, 0, 0},
+	{"pipe O_DIRECT", open_pipe_direct, send_write, recv_read, PIPE_BUF, 0},
+	{"socketpair stream", open_stream, send_write, recv_read, 0, 0},
+	{"socketpair dgram", open_dgram, send_write, recv_read, DGRAM_MAX_SIZE, 0},
+	{"vmsplice", open_pipe, send_vmsplice, recv_read, 0, 0},
+	{"splice", open_pipe, send_write, recv_splice, 0, 0},
+	{"eventfd", open_eventfd, send_eventfd, recv_read, 0, sizeof(uint64_t)},
+};
+
+enum placement {
+	PLACE_SAME,
+	PLACE_SMT,
+	PLACE_LLC,
+	PLACE_NODE,
+	PLACE_CNT,
+};
+
+static const char *const placement_names[] = {"same", "smt", "llc", "node"};
+
+static struct placement_cpus {
+	int enabled;
+	int cpu_a;
+	int cpu_b;
+} placements[PLACE_CNT];
+
+/* Parses a cpulist such as "0-3,8" from sysfs, returns -1 if it is missing */
+static int read_cpulist(const char *path, cpu_set_t *set)
+{
+	char list[1024], *p = list;
+	long a, b;
+
+	CPU_ZERO(set);
+
+	if (access(path, R_OK))
+		return -1;
+
+	/* the list is empty e.g. for memory only NUMA nodes */
+	if (FILE_SCANF(path, "%1023s", list))
+		return 0;
+
+	while (*p) {
+		a = b = strtol(p, &p, 10);
+
+		if (*p == '-')
+			b = strtol(p + 1, &p, 10);
+
+		for (; a <= b && a < CPU_SETSIZE; a++)
+			CPU_SET(a, set);
+
+		if (*p != ',')
+			break;
+
+		p++;
+	}
+
+	return 0;
+}
+
+static void cpu_siblings(int cpu, cpu_set_t *set)
+{
+	char path[256];
+
+	snprintf(path, sizeof(path), CPU_PATH "/cpu%i/topology/thread_siblings_list",
+		 cpu);
+
+	if (read_cpulist(path, set)) {
+		CPU_ZERO(set);
+		CPU_SET(cpu, set);
+	}
+}
+
+/* CPUs sharing the highest level cache with the cpu */
+static void cpu_llc(int cpu, cpu_set_t *set)
+{
+	char path[256];
+	int i, level, max_level = 0;
+
+	CPU_ZERO(set);
+	CPU_SET(cpu, set);
+
+	for (i = 0; ; i++) {
+		snprintf(path, sizeof(path), CPU_PATH "/cpu%i/cache/index%i/level",
+			 cpu, i);
+
+		if (access(path, R_OK))
+			break;
+
+		SAFE_FILE_SCANF(path, "%i", &level);
+		if (level < max_level)
+			continue;
+
+		max_level = level;
+		snprintf(path, sizeof(path),
+			 CPU_PATH "/cpu%i/cache/index%i/shared_cpu_list", cpu, i);
+		read_cpulist(path, set);
+	}
+}
+
+static void cpu_node(int cpu, cpu_set_t *set)
+{
+	char path[256];
+	struct dirent *ent;
+	DIR *dir;
+	int i, node;
+
+	/* the node ids do not have to be contiguous */
+	dir = opendir(NODE_PATH);
+
+	while (dir && (ent = SAFE_READDIR(dir))) {
+		if (sscanf(ent->d_name, "node%d", &node) != 1)
+			continue;
+
+		snprintf(path, sizeof(path), NODE_PATH "/node%i/cpulist", node);
+
+		if (!read_cpulist(path, set) && CPU_ISSET(cpu, set)) {
+			SAFE_CLOSEDIR(dir);
+			return;
+		}
+	}
+
+	if (dir)
+		SAFE_CLOSEDIR(dir);
+
+	/* no NUMA, all CPUs are on one node */
+	CPU_ZERO(set);
+	for (i = 0; i < CPU_SETSIZE; i++)
+		CPU_SET(i, set);
+}
+
+static int find_pair(enum placement p, int *cpu_a, int *cpu_b)
+{
+	cpu_set_t siblings, llc, node;
+	int a, b, match;
+
+	for (a = 0; a < CPU_SETSIZE; a++) {
+		if (!CPU_ISSET(a, &orig_mask))
+			continue;
+
+		if (p == PLACE_SAME) {
+			*cpu_a = *cpu_b = a;
+			return 1;
+		}
+
+		cpu_siblings(a, &siblings);
+		cpu_llc(a, &llc);
+		cpu_node(a, &node);
+
+		for (b = 0; b < CPU_SETSIZE; b++) {
+			if (b == a || !CPU_ISSET(b, &orig_mask))
+				continue;
+
+			switch (p) {
+			case PLACE_SMT:
+				match = CPU_ISSET(b, &siblings);
+				break;
+			case PLACE_LLC:
+				match = CPU_ISSET(b, &llc) &&
+					!CPU_ISSET(b, &siblings);
+				break;
+			case PLACE_NODE:
+				match = !CPU_ISSET(b, &node);
+				break;
+			default:
+				match = 0;
+			}
+
+			if (match) {
+				*cpu_a = a;
+				*cpu_b = b;
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static void pin(int cpu)
+{
+	cpu_set_t mask;
+
+	CPU_ZERO(&mask);
+	CPU_SET(cpu, &mask);
+
+	if (sched_setaffinity(0, sizeof(mask), &mask))
+		tst_brk(TBROK | TERRNO, "sched_setaffinity(%i)", cpu);
+}
+
+static void send_full(struct transport *t, int fd, size_t size)
+{
+	size_t off = 0;
+	ssize_t ret;
+
+	while (off < size) {
+		ret = t->send(fd, buf + off, size - off);
+		if (ret <= 0)
+			tst_brk(TBROK | TERRNO, "%s: send", t->name);
+
+		off += ret;
+	}
+}
+
+static void recv_full(struct transport *t, int fd, size_t size)
+{
+	size_t off = 0;
+	ssize_t ret;
+
+	while (off < size) {
+		ret = t->recv(fd, buf + off, size - off);
+		if (ret <= 0)
+			tst_brk(TBROK | TERRNO, "%s: recv", t->name);
+
+		off += ret;
+	}
+}
+
+static void close_chan(struct chan *c)
+{
+	if (c->wfd != c->rfd)
+		SAFE_CLOSE(c->wfd);
+
+	SAFE_CLOSE(c->rfd);
+}
+
+static void stop_child(pid_t pid)
+{
+	SAFE_KILL(pid, SIGKILL);
+	SAFE_WAITPID(pid, NULL, 0);
+}
+
+/* Returns bytes per second streamed from cpu_a to cpu_b */
+static double measure_bandwidth(struct transport *t, size_t size,
+				struct placement_cpus *pc)
+{
+	unsigned long long start, end, deadline;
+	struct chan c;
+	ssize_t ret;
+	pid_t pid;
+
+	t->open(&c);
+	shared->bytes = 0;
+
+	pid = SAFE_FORK();
+	if (!pid) {
+		pin(pc->cpu_b);
+		TST_CHECKPOINT_WAKE(0);
+
+		for (;;) {
+			ret = t->recv(c.rfd, buf, size);
+			if (ret <= 0)
+				tst_brk(TBROK | TERRNO, "%s: recv", t->name);
+
+			shared->bytes += ret;
+		}
+	}
+
+	pin(pc->cpu_a);
+	TST_CHECKPOINT_WAIT(0);
+
+	start = tst_hist_now_ns();
+	deadline = start + measure_ns;
+
+	do {
+		send_full(t, c.wfd, size);
+		end = tst_hist_now_ns();
+	} while (end < deadline);
+
+	stop_child(pid);
+	close_chan(&c);
+
+	return shared->bytes * 1e9 / (end - start);
+}
+
+/* Fills shared->hist with the round trip times */
+static void measure_latency(struct transport *t, size_t size,
+			    struct placement_cpus *pc)
+{
+	unsigned long long start, end, deadline;
+	struct chan ping, pong;
+	unsigned long i;
+	pid_t pid;
+
+	t->open(&ping);
+	t->open(&pong);
+
+	pid = SAFE_FORK();
+	if (!pid) {
+		pin(pc->cpu_b);
+		TST_CHECKPOINT_WAKE(0);
+
+		for (;;) {
+			recv_full(t, ping.rfd, size);
+			send_full(t, pong.wfd, size);
+		}
+	}
+
+	pin(pc->cpu_a);
+	TST_CHECKPOINT_WAIT(0);
+
+	memset(&shared->hist, 0, sizeof(shared->hist));
+	deadline = tst_hist_now_ns() + measure_ns;
+
+	for (i = 0; i < MAX_ROUND_TRIPS; i++) {
+		start = tst_hist_now_ns();
+		send_full(t, ping.wfd, size);
+		recv_full(t, pong.rfd, size);
+		end = tst_hist_now_ns();
+
+		tst_hist_add(&shared->hist, end - start);
+
+		if (end > deadline)
+			break;
+	}
+
+	stop_child(pid);
+	close_chan(&ping);
+	close_chan(&pong);
+}
+
+static void run(unsigned int n)
+{
+	struct transport *t = &transports[n];
+	unsigned int s, p;
+	char bw_str[32];
+	double bw;
+	size_t size;
+
+	for (s = 0; s < nsizes; s++) {
+		size = t->fixed_size ? t->fixed_size : sizes[s];
+
+		if (t->max_size && size > t->max_size) {
+			tst_res(TINFO, "%s: %zu B is over the maximal message size %zu B",
+				t->name, size, t->max_size);
+			continue;
+		}
+
+		for (p = 0; p < PLACE_CNT; p++) {
+			struct placement_cpus *pc = &placements[p];
+
+			if (!pc->enabled)
+				continue;
+
+			measure_latency(t, size, pc);
+
+			/* the eventfd counter carries no data */
+			if (t->fixed_size) {
+				strcpy(bw_str, "n/a");
+			} else {
+				bw = measure_bandwidth(t, size, pc);
+				snprintf(bw_str, sizeof(bw_str), "%.3f GB/s", bw / 1e9);
+			}
+
+			tst_res(TINFO, "%-17s %7zu B %-4s: %12s, rtt p50 %7.1f us, p99 %7.1f us, p99.9 %7.1f us",
+				t->name, size, placement_names[p], bw_str,
+				tst_hist_percentile(&shared->hist, 50) / 1000.0,
+				tst_hist_percentile(&shared->hist, 99) / 1000.0,
+				tst_hist_percentile(&shared->hist, 99.9) / 1000.0);
+		}
+
+		if (t->fixed_size)
+			break;
+	}
+
+	if (sched_setaffinity(0, sizeof(orig_mask), &orig_mask))
+		tst_brk(TBROK | TERRNO, "sched_setaffinity()");
+
+	tst_res(TPASS, "%s: measurements finished", t->name);
+}
+
+static void parse_sizes(void)
+{
+	char *str, *tok, *save = NULL;
+	int size;
+
+	if (!str_sizes) {
+		sizes[nsizes++] = 64;
+		sizes[nsizes++] = 4096;
+		sizes[nsizes++] = 65536;
+		return;
+	}
+
+	str = strdup(str_sizes);
+	if (!str)
+		tst_brk(TBROK | TERRNO, "strdup()");
+
+	for (tok = strtok_r(str, ",", &save); tok;
+	     tok = strtok_r(NULL, ",", &save)) {
+		if (nsizes >= MAX_SIZES)
+			tst_brk(TBROK, "Too many message sizes, max %i", MAX_SIZES);
+
+		if (tst_parse_int(tok, &size, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid message size '%s'", tok);
+
+		sizes[nsizes++] = size;
+	}
+
+	free(str);
+}
+
+static unsigned int parse_placements(void)
+{
+	unsigned int p, requested = 0, enabled = 0;
+
+	for (p = 0; p < PLACE_CNT; p++) {
+		struct placement_cpus *pc = &placements[p];
+
+		if (str_placements && !strstr(str_placements, placement_names[p]))
+			continue;
+
+		requested++;
+
+		if (!find_pair(p, &pc->cpu_a, &pc->cpu_b)) {
+			tst_res(TINFO, "No CPUs for the %s placement",
+				placement_names[p]);
+			continue;
+		}
+
+		pc->enabled = 1;
+		enabled++;
+		tst_res(TINFO, "Placement %s: CPU %i and CPU %i",
+			placement_names[p], pc->cpu_a, pc->cpu_b);
+	}
+
+	if (!requested)
+		tst_brk(TBROK, "Invalid placements '%s'", str_placements);
+
+	if (!enabled)
+		tst_brk(TCONF, "None of the placements is possible on this machine");
+
+	return enabled;
+}
+
+static void setup(void)
+{
+	unsigned int i, nplacements;
+
+	if (sched_getaffinity(0, sizeof(orig_mask), &orig_mask))
+		tst_brk(TBROK | TERRNO, "sched_getaffinity()");
+
+	parse_sizes();
+	nplacements = parse_placements();
+
+	for (i = 0; i < nsizes; i++)
+		buf_size = MAX(buf_size, sizes[i]);
+
+	buf = SAFE_MMAP(NULL, buf_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	memset(buf, 'a', buf_size);
+
+	shared = SAFE_MMAP(NULL, sizeof(*shared), PROT_READ | PROT_WRITE,
+			   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+	devnull = SAFE_OPEN("/dev/null", O_WRONLY);
+
+	/* latency and bandwidth for each combination */
+	measure_ns = tst_remaining_runtime() * 1000000000LL /
+		     (ARRAY_SIZE(transports) * nsizes * nplacements * 2);
+}
+
+static void cleanup(void)
+{
+	if (devnull != -1)
+		SAFE_CLOSE(devnull);
+
+	if (shared)
+		SAFE_MUNMAP(shared, sizeof(*shared));
+
+	if (buf)
+		SAFE_MUNMAP(buf, buf_size);
+}
+
+static struct tst_test test = {
+	.setup = setup,
+	.cleanup = cleanup,
+	.test = run,
+	.tcnt = ARRAY_SIZE(transports),
+	.forks_child = 1,
+	.needs_checkpoints = 1,
+	.runtime = 120,
+	.options = (struct tst_option[]) {
+		{"s:", &str_sizes, "Comma separated message sizes in bytes (default 64,4096,65536)"},
+		{"p:", &str_placements, "Comma separated placements same,smt,llc,node (default all)"},
+		{}
+	},
+};
@@ -0,0 +1,318 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) Linux Test Project, 2026
+ */
+
+/*\
+ * Page fault scalability benchmark.
+ *
+ * N threads of a single process fault pages of private and shared
+ * mappings of anonymous, shmem and file backed memory. Each thread owns a
+ * slice of one mapping, writes to every page of it and zaps the slice with
+ * MADV_DONTNEED, so that the pages are faulted again in the next round. With
+ * -M each thread maps and unmaps its slice instead, which takes the
+ * mmap_lock for writing.
+ *
+ * The test is repeated with 1, 2, 4, ... threads up to the number of CPUs
+ * and reports the pages touched per second, with the speedup over the single
+ * threaded run, and the page faults per second counted by the kernel. These
+ * differ when the kernel maps more than one page per fault, e.g. for large
+ * folios. The per-VMA lock counters from /proc/vmstat
+ * (CONFIG_PER_VMA_LOCK_STATS) show how many faults fell back to the
+ * mmap_lock.
+ *
+ * The test fails if the speedup on all CPUs is less than -s.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include "tst_test.h"
+#include "tst_safe_pthread.h"
+#include "tst_safe_clocks.h"
+#include "tst_timer.h"
+
+#define TEST_FILENAME "faultfile"
+#define DEF_SLICE_MB 16
+
+static char *str_slice_mb;
+static char *str_speedup;
+static char *remap;
+
+static int slice_mb = DEF_SLICE_MB;
+static float min_speedup;
+
+static long page_sz;
+static size_t slice_sz;
+static int max_threads;
+static int steps;
+static long long measure_us;
+static int fd = -1;
+
+static pthread_barrier_t start_barrier;
+static tst_atomic_t stop;
+static char *area;
+
+static struct tcase {
+	const char *name;
+	int flags;
+	int file;
+} tcases[] = {
+	{"anon private", MAP_PRIVATE | MAP_ANONYMOUS, 0},
+	{"shmem shared", MAP_SHARED | MAP_ANONYMOUS, 0},
+	{"file private", MAP_PRIVATE, 1},
+	{"file shared", MAP_SHARED, 1},
+};
+
+struct worker {
+	pthread_t thread;
+	struct tcase *tc;
+	int idx;
+	unsigned long pages;
+};
+
+static const char *const vma_counters[] = {
+	"vma_lock_success",
+	"vma_lock_abort",
+	"vma_lock_retry",
+	"vma_lock_miss",
+};
+
+#define VMA_COUNTERS ARRAY_SIZE(vma_counters)
+
+struct counters {
+	long vma[VMA_COUNTERS];
+	long minflt;
+};
+
+static long vmstat_read(const char *name)
+{
+	char fmt[64];
+	long val;
+
+	snprintf(fmt, sizeof(fmt), "%s %%ld", name);
+
+	if (FILE_LINES_SCANF("/proc/vmstat", fmt, &val))
+		return -1;
+
+	return val;
+}
+
+static void counters_read(struct counters *c)
+{
+	struct rusage ru;
+	unsigned int i;
+
+	for (i = 0; i < VMA_COUNTERS; i++)
+		c->vma[i] = vmstat_read(vma_counters[i]);
+
+	SAFE_GETRUSAGE(RUSAGE_SELF, &ru);
+	c->minflt = ru.ru_minflt;
+}
+
+static long long now_us(void)
+{
+	struct timespec ts;
+
+	SAFE_CLOCK_GETTIME(CLOCK_MONOTONIC, &ts);
+
+	return tst_timespec_to_us(ts);
+}
+
+static void touch(volatile char *p)
+{
+	size_t i;
+
+	for (i = 0; i < slice_sz; i += page_sz)
+		p[i] = 1;
+}
+
+static void *fault_thread(void *arg)
+{
+	struct worker *w = arg;
+	struct tcase *tc = w->tc;
+	off_t off = (off_t)w->idx * slice_sz;
+	unsigned long pages = slice_sz / page_sz;
+	char *p;
+
+	pthread_barrier_wait(&start_barrier);
+
+	while (!tst_atomic_load(&stop)) {
+		if (remap) {
+			p = SAFE_MMAP(NULL, slice_sz, PROT_READ | PROT_WRITE,
+				      tc->flags, tc->file ? fd : -1,
+				      tc->file ? off : 0);
+			touch(p);
+			SAFE_MUNMAP(p, slice_sz);
+		} else {
+			p = area + off;
+			touch(p);
+			if (madvise(p, slice_sz, MADV_DONTNEED))
+				tst_brk(TBROK | TERRNO, "madvise()");
+		}
+
+		w->pages += pages;
+	}
+
+	return NULL;
+}
+
+/* Returns pages touched per second for the given number of threads */
+static double measure(struct tcase *tc, int nthreads)
+{
+	struct worker *workers = SAFE_MALLOC(sizeof(*workers) * nthreads);
+	struct timespec duration = tst_timespec_from_us(measure_us);
+	struct counters before, after;
+	unsigned long pages = 0;
+	long long start, end;
+	double rate;
+	unsigned int i;
+	int t;
+
+	if (!remap) {
+		area = SAFE_MMAP(NULL, slice_sz * nthreads, PROT_READ | PROT_WRITE,
+				 tc->flags, tc->file ? fd : -1, 0);
+	}
+
+	tst_atomic_store(0, &stop);
+	pthread_barrier_init(&start_barrier, NULL, nthreads + 1);
+
+	for (t = 0; t < nthreads; t++) {
+		workers[t].tc = tc;
+		workers[t].idx = t;
+		workers[t].pages = 0;
+		SAFE_PTHREAD_CREATE(&workers[t].thread, NULL, fault_thread,
+				    &workers[t]);
+	}
+
+	counters_read(&before);
+	start = now_us();
+	pthread_barrier_wait(&start_barrier);
+
+	nanosleep(&duration, NULL);
+	tst_atomic_store(1, &stop);
+
+	for (t = 0; t < nthreads; t++) {
+		SAFE_PTHREAD_JOIN(workers[t].thread, NULL);
+		pages += workers[t].pages;
+	}
+
+	end = now_us();
+	counters_read(&after);
+	pthread_barrier_destroy(&start_barrier);
+
+	if (!remap)
+		SAFE_MUNMAP(area, slice_sz * nthreads);
+
+	rate = pages * 1000000.0 / (end - start);
+
+	tst_res(TINFO, "%s, %3i threads: %10.0f pages/s, %10.0f per thread, %10.0f faults/s",
+		tc->name, nthreads, rate, rate / nthreads,
+		(after.minflt - before.minflt) * 1000000.0 / (end - start));
+
+	if (after.vma[0] >= 0) {
+		long success = after.vma[0] - before.vma[0];
+		long total = success;
+
+		for (i = 1; i < VMA_COUNTERS; i++)
+			total += after.vma[i] - before.vma[i];
+
+		tst_res(TINFO, "  per-VMA lock: %.2f%% success, abort %ld, retry %ld, miss %ld",
+			total ? 100.0 * success / total : 0,
+			after.vma[1] - before.vma[1],
+			after.vma[2] - before.vma[2],
+			after.vma[3] - before.vma[3]);
+	}
+
+	free(workers);
+
+	return rate;
+}
+
+static void run(unsigned int n)
+{
+	struct tcase *tc = &tcases[n];
+	double base = 0, rate = 0;
+	int nthreads;
+
+	for (nthreads = 1; ; nthreads = MIN(nthreads * 2, max_threads)) {
+		rate = measure(tc, nthreads);
+
+		if (nthreads == 1)
+			base = rate;
+
+		if (nthreads == max_threads)
+			break;
+	}
+
+	if (max_threads > 1) {
+		tst_res(TINFO, "%s: speedup %.2f on %i threads", tc->name,
+			rate / base, max_threads);
+	}
+
+	if (min_speedup && rate / base < min_speedup) {
+		tst_res(TFAIL, "%s: speedup %.2f on %i threads is less than %.2f",
+			tc->name, rate / base, max_threads, min_speedup);
+		return;
+	}
+
+	tst_res(TPASS, "%s: %.0f pages/s on %i threads", tc->name, rate,
+		max_threads);
+}
+
+static void setup(void)
+{
+	int nthreads;
+
+	if (tst_parse_int(str_slice_mb, &slice_mb, 1, INT_MAX / 2))
+		tst_brk(TBROK, "Invalid slice size '%s'", str_slice_mb);
+
+	if (tst_parse_float(str_speedup, &min_speedup, 0, 1000000))
+		tst_brk(TBROK, "Invalid speedup '%s'", str_speedup);
+
+	page_sz = getpagesize();
+	slice_sz = (size_t)slice_mb * TST_MB;
+	max_threads = tst_ncpus_available();
+
+	/* do not use more than a quarter of the available memory */
+	while (max_threads > 1 && (long)max_threads * slice_mb * 1024 >
+	       SAFE_READ_MEMINFO("MemAvailable:") / 4)
+		max_threads /= 2;
+
+	for (nthreads = 1, steps = 1; nthreads < max_threads; steps++)
+		nthreads = MIN(nthreads * 2, max_threads);
+
+	measure_us = tst_remaining_runtime() * 1000000LL /
+		     (ARRAY_SIZE(tcases) * steps) / 2;
+
+	tst_res(TINFO, "%i MB per thread, up to %i threads, %lli ms per measurement%s",
+		slice_mb, max_threads, measure_us / 1000,
+		remap ? ", remapping on each round" : "");
+
+	if (tst_fill_file(TEST_FILENAME, 0, TST_MB, (size_t)slice_mb * max_threads))
+		tst_brk(TBROK | TERRNO, "Failed to create " TEST_FILENAME);
+
+	fd = SAFE_OPEN(TEST_FILENAME, O_RDWR);
+}
+
+static void cleanup(void)
+{
+	if (fd != -1)
+		SAFE_CLOSE(fd);
+}
+
+static struct tst_test test = {
+	.setup = setup,
+	.cleanup = cleanup,
+	.test = run,
+	.tcnt = ARRAY_SIZE(tcases),
+	.needs_tmpdir = 1,
+	.runtime = 60,
+	.options = (struct tst_option[]) {
+		{"m:", &str_slice_mb, "Memory per thread in MB (default 16)"},
+		{"s:", &str_speedup, "Minimal speedup on all CPUs (default: not checked)"},
+		{"M", &remap, "Map and unmap the memory on each round"},
+		{}
+	},
+};
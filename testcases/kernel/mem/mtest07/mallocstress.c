@@ -5,6 +5,18 @@
  *
  * Stress the VMM and C library by spawning N threads which malloc
  * blocks of increasing size until malloc returns NULL.
+ *
+ * Alternatively (-t) each thread replays an allocation trace. The trace file
+ * contains one "size lifetime" pair per line, the lifetime is the number of
+ * following allocations from the trace after which the block is freed.
+ * Empty lines and lines starting with # are ignored.
+ *
+ * The latency of each malloc() and free() is recorded into per thread
+ * histograms for power of two size classes, the merged percentiles are
+ * reported at the end together with the RSS growth. While the threads run
+ * the main thread samples mallinfo2() every 10ms and reports the peak size
+ * of the malloc heap and the peak number of blocks served by a separate
+ * mmap().
  */
 
 #include <stdio.h>
@@ -17,8 +29,17 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include "config.h"
+#ifdef HAVE_MALLINFO2
+# include <malloc.h>
+#endif
+
 #include "tst_test.h"
+#include "tst_atomic.h"
 #include "tst_safe_pthread.h"
+#include "tst_safe_stdio.h"
+#include "tst_tsc.h"
+#include "tst_hist.h"
 
 /* Number of loops per-thread */
 #define NUM_LOOPS	100
@@ -29,7 +50,40 @@
 /* Define SPEW_SIGNALS to tickle thread_create bug (it fails if interrupted). */
 #define SPEW_SIGNALS
 
+/* Size classes 2^0 .. 2^(SIZE_CLASSES - 1) bytes */
+#define SIZE_CLASSES	48
+
+enum { OP_MALLOC, OP_FREE, OP_CNT };
+
+struct thread_stats {
+	struct tst_hist hist[SIZE_CLASSES][OP_CNT];
+	unsigned long ops[OP_CNT];
+};
+
+struct heap_stats {
+	size_t arena;
+	size_t hblks;
+	size_t hblkhd;
+};
+
+struct trace_entry {
+	size_t size;
+	unsigned int lifetime;
+};
+
 static pthread_t *thread_id;	/* Spawned thread */
+static struct thread_stats *stats;
+static tst_atomic_t threads_done;
+static struct heap_stats heap_peak;
+
+static char *trace_file;
+static struct trace_entry *trace;
+static unsigned int trace_len;
+static unsigned int trace_max_lifetime;
+
+static struct tst_tsc tsc;
+static int use_tsc;
+static long rss_start;
 
 static void my_yield(void)
 {
@@ -48,6 +102,70 @@ static void my_yield(void)
 #endif
 }
 
+static inline uint64_t now_ticks(void)
+{
+	struct timespec ts;
+
+	if (use_tsc)
+		return tst_tsc_read_start();
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline unsigned int size_class(size_t size)
+{
+	unsigned int c = 0;
+
+	while (size > 1 && c < SIZE_CLASSES - 1) {
+		size >>= 1;
+		c++;
+	}
+
+	return c;
+}
+
+static inline void record(struct thread_stats *st, int op, size_t size,
+			  uint64_t start, uint64_t end)
+{
+	uint64_t ns = end - start;
+
+	if (use_tsc)
+		ns = tst_tsc_to_ns(&tsc, ns);
+
+	tst_hist_add(&st->hist[size_class(size)][op], ns);
+	st->ops[op]++;
+}
+
+static void *timed_malloc(struct thread_stats *st, size_t size)
+{
+	uint64_t start, end;
+	void *ptr;
+
+	start = now_ticks();
+	ptr = malloc(size);
+	end = now_ticks();
+
+	if (!ptr)
+		return NULL;
+
+	record(st, OP_MALLOC, size, start, end);
+
+	return ptr;
+}
+
+static void timed_free(struct thread_stats *st, void *ptr, size_t size)
+{
+	uint64_t start, end;
+
+	start = now_ticks();
+	free(ptr);
+	end = now_ticks();
+
+	record(st, OP_FREE, size, start, end);
+}
+
 /*
  * allocate_free() - Allocate and free test called per-thread
  *
@@ -66,11 +184,13 @@ int allocate_free(int scheme, int threadnum)
 {
 	int loop;
 	const int MAXPTRS = 50;	/* only 42 or so get used on 32 bit machine */
+	struct thread_stats *st = &stats[threadnum];
 
 	for (loop = 0; loop < NUM_LOOPS; loop++) {
 		size_t oldsize = 5;
 		size_t size = sizeof(long);
 		long *ptrs[MAXPTRS];
+		size_t sizes[MAXPTRS];
 		int num_alloc;
 		int i;
 
@@ -83,11 +203,12 @@ int allocate_free(int scheme, int threadnum)
 			size_t newsize = 0;
 
 			/* Malloc the next block */
-			ptrs[num_alloc] = malloc(size);
+			ptrs[num_alloc] = timed_malloc(st, size);
 			/* terminate loop if malloc fails */
 			if (!ptrs[num_alloc])
 				break;
 			ptrs[num_alloc][0] = num_alloc;
+			sizes[num_alloc] = size;
 
 			/* Increase size according to one of four schedules. */
 			switch (scheme) {
@@ -122,7 +243,7 @@ int allocate_free(int scheme, int threadnum)
 					getpid());
 				return 1;
 			}
-			free(ptrs[i]);
+			timed_free(st, ptrs[i], sizes[i]);
 			my_yield();
 		}
 
@@ -138,26 +259,174 @@ int allocate_free(int scheme, int threadnum)
 	return 0;
 }
 
+/*
+ * replay_trace() - Replay the allocation trace called per-thread
+ *
+ * The blocks waiting to be freed are kept in a wheel indexed by the number
+ * of allocations done by the thread at which they are freed, linked through
+ * their first bytes so that the bookkeeping does not allocate memory. The
+ * allocation counter keeps running across the passes over the trace, so the
+ * lifetimes carry over from the end of the trace to the next pass.
+ *
+ * Return:
+ *  0: success
+ *  1: failure
+ */
+static int replay_trace(int threadnum)
+{
+	struct thread_stats *st = &stats[threadnum];
+	unsigned int wheel_size = trace_max_lifetime + 1;
+	void **wheel = calloc(wheel_size, sizeof(void *));
+	unsigned long long seq = 0;
+	unsigned int i, slot;
+	void *ptr, *next;
+	int loop, ret = 0;
+
+	if (!wheel) {
+		tst_res(TFAIL | TERRNO, "calloc()");
+		return 1;
+	}
+
+	for (loop = 0; loop < NUM_LOOPS && tst_remaining_runtime(); loop++) {
+		for (i = 0; i < trace_len; i++) {
+			struct trace_entry *e = &trace[i];
+			size_t size = MAX(e->size, sizeof(void *) + sizeof(size_t));
+
+			ptr = timed_malloc(st, size);
+			if (!ptr) {
+				tst_res(TFAIL | TERRNO, "Thread [%d]: malloc(%zu)",
+					threadnum, size);
+				ret = 1;
+				goto out;
+			}
+
+			((size_t *)ptr)[1] = size;
+
+			slot = (seq + e->lifetime) % wheel_size;
+			*(void **)ptr = wheel[slot];
+			wheel[slot] = ptr;
+
+			/* free the blocks whose lifetime ends here */
+			slot = seq++ % wheel_size;
+			for (ptr = wheel[slot]; ptr; ptr = next) {
+				next = *(void **)ptr;
+				timed_free(st, ptr, ((size_t *)ptr)[1]);
+			}
+			wheel[slot] = NULL;
+		}
+
+		my_yield();
+	}
+
+out:
+	for (slot = 0; slot < wheel_size; slot++) {
+		for (ptr = wheel[slot]; ptr; ptr = next) {
+			next = *(void **)ptr;
+			timed_free(st, ptr, ((size_t *)ptr)[1]);
+		}
+	}
+
+	free(wheel);
+
+	return ret;
+}
+
 void *alloc_mem(void *threadnum)
 {
+	int tnum = (uintptr_t)threadnum;
+	struct thread_stats *st = &stats[tnum];
 	int err;
 
 	/* waiting for other threads starting */
 	TST_CHECKPOINT_WAIT(0);
 
-	/* thread N will use growth scheme N mod 4 */
-	err = allocate_free(((uintptr_t)threadnum) % 4, (uintptr_t)threadnum);
+	if (trace) {
+		err = replay_trace(tnum);
+	} else {
+		/* thread N will use growth scheme N mod 4 */
+		err = allocate_free(tnum % 4, tnum);
+	}
+
 	tst_res(TINFO,
-		"Thread [%d]: allocate_free() returned %d, %s.  Thread exiting.\n",
-		(int)(uintptr_t)threadnum, err,
-		(err ? "failed" : "succeeded"));
+		"Thread [%d]: %s, %lu mallocs, %lu frees.  Thread exiting.",
+		tnum, (err ? "failed" : "succeeded"), st->ops[OP_MALLOC],
+		st->ops[OP_FREE]);
+
+	tst_atomic_inc(&threads_done);
+
 	return (void *)(uintptr_t) (err ? -1 : 0);
 }
 
+/*
+ * mallinfo2() locks each arena in turn, sampling it from the main thread is
+ * cheaper and race free compared to tracking the heap in the workers.
+ */
+static void sample_heap(void)
+{
+#ifdef HAVE_MALLINFO2
+	struct mallinfo2 mi = mallinfo2();
+
+	heap_peak.arena = MAX(heap_peak.arena, mi.arena);
+	heap_peak.hblks = MAX(heap_peak.hblks, mi.hblks);
+	heap_peak.hblkhd = MAX(heap_peak.hblkhd, mi.hblkhd);
+#endif
+}
+
+static long read_rss_kb(void)
+{
+	long rss;
+
+	SAFE_FILE_SCANF("/proc/self/statm", "%*s %ld", &rss);
+
+	return rss * (getpagesize() / 1024);
+}
+
+static void print_stats(void)
+{
+	static const char *const op_names[] = {"malloc", "free"};
+	struct tst_hist hist;
+	unsigned int c;
+	int op, t;
+
+	tst_res(TINFO, "Latency in ns per size class (p50/p99/p99.9/max):");
+
+	for (c = 0; c < SIZE_CLASSES; c++) {
+		for (op = 0; op < OP_CNT; op++) {
+			memset(&hist, 0, sizeof(hist));
+
+			for (t = 0; t < NUM_THREADS; t++)
+				tst_hist_merge(&hist, &stats[t].hist[c][op]);
+
+			if (!hist.samples)
+				continue;
+
+			tst_res(TINFO, "  %-6s < 2^%-2u B: %10llu ops %8llu %8llu %8llu %10llu",
+				op_names[op], c + 1,
+				(unsigned long long)hist.samples,
+				(unsigned long long)tst_hist_percentile(&hist, 50),
+				(unsigned long long)tst_hist_percentile(&hist, 99),
+				(unsigned long long)tst_hist_percentile(&hist, 99.9),
+				(unsigned long long)hist.max);
+		}
+	}
+
+#ifdef HAVE_MALLINFO2
+	tst_res(TINFO, "Peak malloc heap %zu kB, mmapped blocks %zu (%zu kB)",
+		heap_peak.arena / 1024, heap_peak.hblks, heap_peak.hblkhd / 1024);
+#endif
+	tst_res(TINFO, "RSS %ld kB at start, %ld kB at end, peak %ld kB",
+		rss_start, read_rss_kb(), SAFE_READ_PROC_STATUS(getpid(), "VmHWM:"));
+}
+
 static void stress_malloc(void)
 {
 	int thread_index;
 
+	memset(stats, 0, sizeof(*stats) * NUM_THREADS);
+	memset(&heap_peak, 0, sizeof(heap_peak));
+	tst_atomic_store(0, &threads_done);
+	rss_start = read_rss_kb();
+
 	for (thread_index = 0; thread_index < NUM_THREADS; thread_index++) {
 		SAFE_PTHREAD_CREATE(&thread_id[thread_index], NULL, alloc_mem,
 				    (void *)(uintptr_t)thread_index);
@@ -166,6 +435,11 @@ static void stress_malloc(void)
 	/* Wake up all threads */
 	TST_CHECKPOINT_WAKE2(0, NUM_THREADS);
 
+	while (tst_atomic_load(&threads_done) < NUM_THREADS) {
+		sample_heap();
+		usleep(10000);
+	}
+
 	/* wait for all threads to finish */
 	for (thread_index = 0; thread_index < NUM_THREADS; thread_index++) {
 		void *status;
@@ -177,12 +451,60 @@ static void stress_malloc(void)
 		}
 	}
 
+	print_stats();
+
 	tst_res(TPASS, "malloc stress test finished successfully");
 }
 
+static void load_trace(void)
+{
+	unsigned int alloc_size = 0, lifetime;
+	char line[256];
+	size_t size;
+	FILE *f;
+
+	f = SAFE_FOPEN(trace_file, "r");
+
+	while (fgets(line, sizeof(line), f)) {
+		line[strcspn(line, "\n")] = 0;
+
+		if (line[0] == '#' || !line[0])
+			continue;
+
+		if (sscanf(line, "%zu %u", &size, &lifetime) != 2) {
+			tst_brk(TBROK, "Invalid line %u in %s: %s",
+				trace_len + 1, trace_file, line);
+		}
+
+		if (trace_len == alloc_size) {
+			alloc_size = alloc_size ? alloc_size * 2 : 1024;
+			trace = SAFE_REALLOC(trace, alloc_size * sizeof(*trace));
+		}
+
+		trace[trace_len].size = size;
+		trace[trace_len].lifetime = lifetime;
+		trace_max_lifetime = MAX(trace_max_lifetime, lifetime);
+		trace_len++;
+	}
+
+	SAFE_FCLOSE(f);
+
+	if (!trace_len)
+		tst_brk(TBROK, "Trace %s is empty", trace_file);
+
+	tst_res(TINFO, "Replaying %u allocations from %s", trace_len, trace_file);
+}
+
 static void setup(void)
 {
 	thread_id = SAFE_MALLOC(sizeof(pthread_t) * NUM_THREADS);
+	stats = SAFE_MALLOC(sizeof(*stats) * NUM_THREADS);
+
+	if (trace_file)
+		load_trace();
+
+	if (!tst_tsc_calibrate(&tsc))
+		use_tsc = 1;
 }
 
 static void cleanup(void)
@@ -191,6 +513,9 @@ static void cleanup(void)
 		free(thread_id);
 		thread_id = NULL;
 	}
+
+	free(stats);
+	free(trace);
 }
 
 static struct tst_test test = {
@@ -199,4 +524,8 @@ static struct tst_test test = {
 	.setup = setup,
 	.cleanup = cleanup,
 	.test_all = stress_malloc,
+	.options = (struct tst_option[]) {
+		{"t:", &trace_file, "Replay allocation trace file with 'size lifetime' lines"},
+		{}
+	},
 };
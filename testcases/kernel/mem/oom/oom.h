@@ -6,9 +6,13 @@
 #ifndef OOM_H_
 #define OOM_H_
 
+#include <limits.h>
 #include <pthread.h>
+#include <time.h>
 #include "config.h"
 #include "numa_helper.h"
+#include "tst_safe_file_ops.h"
+#include "lapi/mmap.h"
 
 #define PATH_KSM        "/sys/kernel/mm/ksm/"
 
@@ -17,6 +21,89 @@
 #define MLOCK			2
 #define KSM			3
 
+#define PATH_THP		"/sys/kernel/mm/transparent_hugepage/"
+
+static char *oom_str_workers;
+static char *oom_str_ramp;
+static char *oom_thp;
+static char *oom_numa;
+
+/*
+ * Pressure generator tuning, the defaults reproduce the original behavior
+ * of one allocating thread per CPU but one.
+ */
+static struct tst_option oom_options[] = {
+	{"w:", &oom_str_workers, "Allocating threads, per NUMA node with -N (default: CPUs, one less in total)"},
+	{"r:", &oom_str_ramp, "Allocation rate per thread in MB/s (default: unlimited)"},
+	{"H", &oom_thp, "Fault the memory in transparent huge pages"},
+	{"N", &oom_numa, "Bind the allocating threads to the CPUs of each NUMA node"},
+	{}
+};
+
+static struct oom_cfg {
+	int workers;
+	long ramp_mb;
+	long thp_size;
+} oom_cfg;
+
+struct oom_worker {
+	pthread_t thread;
+	int testcase;
+	int node;
+};
+
+static void oom_parse_opts(void)
+{
+	static int parsed;
+	char thp_enabled[64];
+
+	if (parsed)
+		return;
+
+	parsed = 1;
+
+	if (tst_parse_int(oom_str_workers, &oom_cfg.workers, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid number of workers '%s'", oom_str_workers);
+
+	if (tst_parse_long(oom_str_ramp, &oom_cfg.ramp_mb, 1, LONG_MAX))
+		tst_brk(TBROK, "Invalid ramp rate '%s'", oom_str_ramp);
+
+	if (oom_thp) {
+		if (access(PATH_THP "hpage_pmd_size", F_OK))
+			tst_brk(TCONF, "Transparent huge pages are not supported");
+
+		SAFE_FILE_SCANF(PATH_THP "enabled", "%63[^\n]", thp_enabled);
+		if (strstr(thp_enabled, "[never]"))
+			tst_brk(TCONF, "Transparent huge pages are disabled");
+
+		SAFE_FILE_SCANF(PATH_THP "hpage_pmd_size", "%ld", &oom_cfg.thp_size);
+		tst_res(TINFO, "Faulting memory in %ld kB huge pages",
+			oom_cfg.thp_size / 1024);
+	}
+
+	if (oom_cfg.ramp_mb)
+		tst_res(TINFO, "Allocating at most %ld MB/s per thread", oom_cfg.ramp_mb);
+}
+
+static inline long long oom_now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/* sleeps so that touching bytes since start does not exceed the ramp rate */
+static void oom_throttle(long long start, size_t bytes)
+{
+	long long want = bytes / oom_cfg.ramp_mb / (TST_MB / 1000000.0);
+	long long elapsed = oom_now_us() - start;
+
+	if (elapsed < want)
+		usleep(want - elapsed);
+}
+
 #ifdef HAVE_NUMA_V2
 static inline void set_global_mempolicy(int mempolicy)
 {
@@ -67,16 +154,24 @@ static int alloc_mem(size_t length, int testcase)
 	char *s;
 	size_t i;
 	long pagesz = getpagesize();
+	long align = oom_thp ? oom_cfg.thp_size : 0;
+	long long start;
 	int loop = 10;
 
 	tst_res(TINFO, "thread (%lx), allocating %zu bytes.",
 		(unsigned long) pthread_self(), length);
 
-	s = mmap(NULL, length, PROT_READ | PROT_WRITE,
+	s = mmap(NULL, length + align, PROT_READ | PROT_WRITE,
 		 MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
 	if (s == MAP_FAILED)
 		return errno;
 
+	if (oom_thp) {
+		s = (char *)LTP_ALIGN((unsigned long)s, (unsigned long)align);
+		if (madvise(s, length, MADV_HUGEPAGE) == -1)
+			return errno;
+	}
+
 	if (testcase == MLOCK) {
 		while (mlock(s, length) == -1 && loop > 0) {
 			if (EAGAIN != errno)
@@ -90,41 +185,151 @@ static int alloc_mem(size_t length, int testcase)
 	if (testcase == KSM && madvise(s, length, MADV_MERGEABLE) == -1)
 		return errno;
 #endif
-	for (i = 0; i < length; i += pagesz)
+	start = oom_now_us();
+
+	/*
+	 * Touch every base page even with -H, the kernel falls back to base
+	 * pages when it cannot allocate a huge page.
+	 */
+	for (i = 0; i < length; i += pagesz) {
 		s[i] = '\a';
 
+		if (oom_cfg.ramp_mb && !(i % TST_MB))
+			oom_throttle(start, i);
+	}
+
 	return 0;
 }
 
+/* runs the calling thread on the CPUs of the node */
+static void oom_bind_node(int node LTP_ATTRIBUTE_UNUSED)
+{
+#ifdef HAVE_NUMA_V2
+	struct bitmask *cpus = numa_allocate_cpumask();
+
+	/* the cpuset may not allow all CPUs of the node, that's fine */
+	if (!numa_node_to_cpus(node, cpus))
+		numa_sched_setaffinity(0, cpus);
+
+	numa_free_cpumask(cpus);
+#endif
+}
+
 static void *child_alloc_thread(void *args)
 {
+	struct oom_worker *w = args;
 	int ret = 0;
 
+	if (w->node >= 0)
+		oom_bind_node(w->node);
+
 	/* keep allocating until there's an error */
 	while (!ret)
-		ret = alloc_mem(LENGTH, (long)args);
+		ret = alloc_mem(LENGTH, w->testcase);
 	exit(ret);
 }
 
-static void child_alloc(int testcase, int lite, int threads)
+/* number of CPUs of the node we are allowed to run on */
+static int oom_node_cpus(int node LTP_ATTRIBUTE_UNUSED)
 {
-	int i;
-	pthread_t *th;
+	int ret = tst_ncpus();
+#ifdef HAVE_NUMA_V2
+	struct bitmask *cpus = numa_allocate_cpumask();
+	struct bitmask *allowed = numa_allocate_cpumask();
+	unsigned int i;
+
+	if (numa_sched_getaffinity(0, allowed) > 0 &&
+	    !numa_node_to_cpus(node, cpus)) {
+		ret = 0;
+		for (i = 0; i < cpus->size; i++) {
+			if (numa_bitmask_isbitset(cpus, i) &&
+			    numa_bitmask_isbitset(allowed, i))
+				ret++;
+		}
+	}
+
+	numa_free_cpumask(allowed);
+	numa_free_cpumask(cpus);
+#endif
+	return ret;
+}
+
+/*
+ * Prepares the allocating threads. With -N and more than one usable node each
+ * node gets its own threads bound to its CPUs, so that the pages are faulted
+ * and reclaimed on all nodes in parallel.
+ */
+static int oom_setup_workers(int testcase, struct oom_worker **workers)
+{
+	int num_nodes = 0, *nodes = NULL;
+	int i, j, cnt, threads = 0;
+
+	if (oom_numa && get_allowed_nodes_arr(NH_MEMS|NH_CPUS, &num_nodes, &nodes))
+		num_nodes = 0;
+
+	if (num_nodes < 2) {
+		threads = oom_cfg.workers ? oom_cfg.workers : MAX(1, tst_ncpus() - 1);
+		num_nodes = 0;
+	} else {
+		for (i = 0; i < num_nodes; i++)
+			threads += oom_cfg.workers ? oom_cfg.workers : MAX(1, oom_node_cpus(nodes[i]));
+	}
+
+	*workers = calloc(threads, sizeof(**workers));
+	if (!*workers) {
+		free(nodes);
+		return 0;
+	}
+
+	if (!num_nodes) {
+		for (i = 0; i < threads; i++) {
+			(*workers)[i].testcase = testcase;
+			(*workers)[i].node = -1;
+		}
+		free(nodes);
+		return threads;
+	}
+
+	threads = 0;
+	for (i = 0; i < num_nodes; i++) {
+		cnt = oom_cfg.workers ? oom_cfg.workers : MAX(1, oom_node_cpus(nodes[i]));
+
+		/* keep one CPU free for the parent */
+		if (!oom_cfg.workers && !i && cnt > 1)
+			cnt--;
+
+		for (j = 0; j < cnt; j++) {
+			(*workers)[threads].testcase = testcase;
+			(*workers)[threads].node = nodes[i];
+			threads++;
+		}
+	}
+
+	tst_res(TINFO, "%d allocating threads on %d nodes", threads, num_nodes);
+
+	free(nodes);
+	return threads;
+}
+
+static void child_alloc(int testcase, int lite)
+{
+	int i, threads;
+	struct oom_worker *workers;
 
 	if (lite) {
 		int ret = alloc_mem((size_t)TESTMEM * 2 + TST_MB, testcase);
 		exit(ret);
 	}
 
-	th = malloc(sizeof(pthread_t) * threads);
-	if (!th) {
+	threads = oom_setup_workers(testcase, &workers);
+	if (!threads) {
 		tst_res(TINFO | TERRNO, "malloc");
 		goto out;
 	}
 
 	for (i = 0; i < threads; i++) {
-		TEST(pthread_create(&th[i], NULL, child_alloc_thread,
-			(void *)((long)testcase)));
+		TEST(pthread_create(&workers[i].thread, NULL, child_alloc_thread,
+			&workers[i]));
 		if (TST_RET) {
 			tst_res(TINFO | TRERRNO, "pthread_create");
 			/*
@@ -143,6 +348,48 @@ out:
 	exit(1);
 }
 
+static long oom_kill_count(void)
+{
+	long cnt;
+
+	/* oom_kill was added to /proc/vmstat in 4.13 */
+	if (FILE_LINES_SCANF("/proc/vmstat", "oom_kill %ld", &cnt))
+		return -1;
+
+	return cnt;
+}
+
+/*
+ * Waits for the victim and reports how long it took until the OOM killer
+ * picked a victim and how long it took the victim to exit after that. The
+ * oom_kill counter is polled, so the times have about 1ms resolution.
+ */
+static void oom_wait_victim(pid_t pid, int *status)
+{
+	long long start = oom_now_us(), kill_time = 0, end;
+	long kills = oom_kill_count(), cnt;
+
+	while (!SAFE_WAITPID(pid, status, WNOHANG)) {
+		if (!kill_time && kills >= 0) {
+			cnt = oom_kill_count();
+			if (cnt > kills)
+				kill_time = oom_now_us();
+		}
+
+		usleep(1000);
+	}
+
+	end = oom_now_us();
+
+	if (kill_time) {
+		tst_res(TINFO, "time to OOM kill %.3fs, kill to victim exit %.1fms",
+			(kill_time - start) / 1000000.0, (end - kill_time) / 1000.0);
+	} else {
+		tst_res(TINFO, "victim ended after %.3fs",
+			(end - start) / 1000000.0);
+	}
+}
+
 /*
  * oom - allocates memory according to specified testcase and checks
  *       desired outcome (e.g. child killed, operation failed with ENOMEM)
@@ -161,21 +408,21 @@ out:
 static inline void oom(int testcase, int lite, int retcode, int allow_sigkill)
 {
 	pid_t pid;
-	int status, threads;
+	int status;
 
+	oom_parse_opts();
 	tst_enable_oom_protection(0);
 
 	switch (pid = SAFE_FORK()) {
 	case 0:
 		tst_disable_oom_protection(0);
-		threads = MAX(1, tst_ncpus() - 1);
-		child_alloc(testcase, lite, threads);
+		child_alloc(testcase, lite);
 	default:
 		break;
 	}
 
 	tst_res(TINFO, "expected victim is %d.", pid);
-	SAFE_WAITPID(-1, &status, 0);
+	oom_wait_victim(pid, &status);
 
 	if (WIFSIGNALED(status)) {
 		if (allow_sigkill && WTERMSIG(status) == SIGKILL) {
@@ -39,6 +39,7 @@ static struct tst_test test = {
 	.forks_child = 1,
 	.timeout = TST_UNLIMITED_TIMEOUT,
 	.test_all = verify_oom,
+	.options = oom_options,
 	.skip_in_compat = 1,
 	.save_restore = (const struct tst_path_val[]) {
 		{OVERCOMMIT_MEMORY, NULL, TST_SR_TBROK},
@@ -47,6 +47,7 @@ static struct tst_test test = {
 	.timeout = TST_UNLIMITED_TIMEOUT,
 	.setup = setup,
 	.test_all = verify_oom,
+	.options = oom_options,
 	.skip_in_compat = 1,
 	.save_restore = (const struct tst_path_val[]) {
 		{"/proc/sys/vm/overcommit_memory", "1", TST_SR_TBROK},
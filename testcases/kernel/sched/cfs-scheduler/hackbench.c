@@ -35,6 +35,18 @@
 /*                                                                            */
 /* Test Assertion:                                                            */
 /*                                                                            */
+/* Options:     -pipe       use pipes instead of socketpairs                  */
+/*              -eventfd    signal messages with eventfd counters             */
+/*              -futex      signal messages with futex counters in shared     */
+/*                          memory                                            */
+/*              -lat        sample per message latency into a histogram,      */
+/*                          print it with per group throughput                */
+/*              -json FILE  write results and latency histogram as JSON       */
+/*                                                                            */
+/*              With -eventfd and -futex the receiver consumes all pending    */
+/*              messages at once and the latency is sampled per wakeup from   */
+/*              the oldest pending message.                                   */
+/*                                                                            */
 /* Author(s):   Rusty Russell <rusty@rustcorp.com.au>,                        */
 /*              Pierre Peiffer <pierre.peiffer@bull.net>,                     */
 /*              Ingo Molnar <mingo@elte.hu>,                                  */
@@ -57,10 +69,18 @@
 #include <sys/wait.h>
 #include <sys/time.h>
 #include <sys/poll.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
 #include <limits.h>
+#include <stdint.h>
+#include <time.h>
+#include "lapi/futex.h"
+#include "tst_hist.h"
 
 #define SAFE_FREE(p) { if (p) { free(p); (p)=NULL; } }
 #define DATASIZE 100
+
 static struct sender_context **snd_ctx_tab;	/*Table for sender context pointers. */
 static struct receiver_context **rev_ctx_tab;	/*Table for receiver context pointers. */
 static int gr_num = 0;		/*For group calculation */
@@ -72,10 +92,46 @@ static unsigned int process_mode = 1;
 
 static int use_pipes = 0;
 
+enum ipc_mode {
+	IPC_SOCKET,
+	IPC_PIPE,
+	IPC_EVENTFD,
+	IPC_FUTEX,
+};
+
+static const char *const ipc_names[] = {
+	[IPC_SOCKET] = "socket",
+	[IPC_PIPE] = "pipe",
+	[IPC_EVENTFD] = "eventfd",
+	[IPC_FUTEX] = "futex",
+};
+
+static enum ipc_mode ipc = IPC_SOCKET;
+static int measure_lat;
+static const char *json_path;
+
+/* Shared with the workers, mapped before they are forked */
+struct group_stats {
+	struct tst_hist hist;
+	uint64_t end_ns;
+};
+
+/* Message counter for -eventfd and -futex */
+struct channel {
+	futex_t pending;
+	int efd;
+	/* Send time of the oldest message not yet seen by the receiver */
+	uint64_t stamp;
+};
+
+static struct group_stats *grp_stats;
+static struct channel *channels;
+
 struct sender_context {
 	unsigned int num_fds;
 	int ready_out;
 	int wakefd;
+	struct channel *chans;
 	int out_fds[0];
 };
 
@@ -84,6 +140,8 @@ struct receiver_context {
 	int in_fds[2];
 	int ready_out;
 	int wakefd;
+	struct channel *chan;
+	struct group_stats *stats;
 };
 
 static void barf(const char *msg)
@@ -95,10 +153,59 @@ static void barf(const char *msg)
 static void print_usage_exit(void)
 {
 	printf
-	    ("Usage: hackbench [-pipe] <num groups> [process|thread] [loops]\n");
+	    ("Usage: hackbench [-pipe|-eventfd|-futex] [-lat] [-json FILE] "
+	     "<num groups> [process|thread] [loops]\n");
 	exit(1);
 }
 
+static void hist_add(struct tst_hist *hist, uint64_t sent_ns)
+{
+	uint64_t now = tst_hist_now_ns();
+
+	tst_hist_add(hist, now > sent_ns ? now - sent_ns : 0);
+}
+
+static void channel_post(struct channel *chan)
+{
+	uint64_t zero = 0, stamp = measure_lat ? tst_hist_now_ns() : 0;
+	uint64_t one = 1;
+
+	if (stamp)
+		__atomic_compare_exchange_n(&chan->stamp, &zero, stamp, 0,
+					    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+
+	if (ipc == IPC_EVENTFD) {
+		if (write(chan->efd, &one, sizeof(one)) != sizeof(one))
+			barf("SENDER: eventfd write");
+		return;
+	}
+
+	if (!__atomic_fetch_add(&chan->pending, 1, __ATOMIC_RELEASE) &&
+	    syscall(SYS_futex, &chan->pending, FUTEX_WAKE, 1, NULL) < 0)
+		barf("SENDER: futex wake");
+}
+
+/* Wait for messages and return how many were consumed */
+static unsigned int channel_wait(struct channel *chan)
+{
+	uint64_t cnt;
+
+	if (ipc == IPC_EVENTFD) {
+		if (read(chan->efd, &cnt, sizeof(cnt)) != sizeof(cnt))
+			barf("SERVER: eventfd read");
+		return cnt;
+	}
+
+	while (!(cnt = __atomic_exchange_n(&chan->pending, 0,
+					   __ATOMIC_ACQUIRE))) {
+		if (syscall(SYS_futex, &chan->pending, FUTEX_WAIT, 0, NULL) &&
+		    errno != EAGAIN && errno != EINTR)
+			barf("SERVER: futex wait");
+	}
+
+	return cnt;
+}
+
 static void fdpair(int fds[2])
 {
 	if (use_pipes) {
@@ -131,6 +238,7 @@ static void *sender(struct sender_context *ctx)
 {
 	char data[DATASIZE];
 	unsigned int i, j;
+	uint64_t stamp;
 
 	ready(ctx->ready_out, ctx->wakefd);
 
@@ -139,6 +247,15 @@ static void *sender(struct sender_context *ctx)
 		for (j = 0; j < ctx->num_fds; j++) {
 			int ret, done = 0;
 
+			if (ctx->chans) {
+				channel_post(&ctx->chans[j]);
+				continue;
+			}
+
+			if (measure_lat) {
+				stamp = tst_hist_now_ns();
+				memcpy(data, &stamp, sizeof(stamp));
+			}
 again:
 			ret =
 			    write(ctx->out_fds[j], data + done,
@@ -157,16 +274,32 @@ again:
 /* One receiver per fd */
 static void *receiver(struct receiver_context *ctx)
 {
-	unsigned int i;
+	struct tst_hist *hist = NULL;
+	unsigned int i, cnt;
+	uint64_t stamp, end;
 
-	if (process_mode)
+	if (process_mode && !ctx->chan)
 		close(ctx->in_fds[1]);
 
+	if (measure_lat) {
+		hist = calloc(1, sizeof(*hist));
+		if (!hist)
+			barf("SERVER: calloc()");
+	}
+
 	/* Wait for start... */
 	ready(ctx->ready_out, ctx->wakefd);
 
 	/* Receive them all */
-	for (i = 0; i < ctx->num_packets; i++) {
+	for (i = 0; ctx->chan && i < ctx->num_packets; i += cnt) {
+		cnt = channel_wait(ctx->chan);
+		stamp = __atomic_exchange_n(&ctx->chan->stamp, 0,
+					    __ATOMIC_RELAXED);
+		if (hist && stamp)
+			hist_add(hist, stamp);
+	}
+
+	for (i = 0; !ctx->chan && i < ctx->num_packets; i++) {
 		char data[DATASIZE];
 		int ret, done = 0;
 
@@ -177,6 +310,23 @@ again:
 		done += ret;
 		if (done < DATASIZE)
 			goto again;
+
+		if (hist) {
+			memcpy(&stamp, data, sizeof(stamp));
+			hist_add(hist, stamp);
+		}
+	}
+
+	end = tst_hist_now_ns();
+	stamp = __atomic_load_n(&ctx->stats->end_ns, __ATOMIC_RELAXED);
+	while (end > stamp &&
+	       !__atomic_compare_exchange_n(&ctx->stats->end_ns, &stamp, end, 0,
+					    __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+
+	if (hist) {
+		tst_hist_merge(&ctx->stats->hist, hist);
+		free(hist);
 	}
 
 	return NULL;
@@ -245,6 +395,10 @@ static unsigned int group(pthread_t * pth,
 	else
 		snd_ctx_tab[gr_num] = snd_ctx;
 
+	snd_ctx->chans = NULL;
+	if (channels)
+		snd_ctx->chans = channels + gr_num * num_fds;
+
 	for (i = 0; i < num_fds; i++) {
 		int fds[2];
 		struct receiver_context *ctx = malloc(sizeof(*ctx));
@@ -254,14 +408,23 @@ static unsigned int group(pthread_t * pth,
 		else
 			rev_ctx_tab[gr_num * num_fds + i] = ctx;
 
+		ctx->num_packets = num_fds * loops;
+		ctx->ready_out = ready_out;
+		ctx->wakefd = wakefd;
+		ctx->stats = grp_stats + gr_num;
+		ctx->chan = NULL;
+
+		if (snd_ctx->chans) {
+			ctx->chan = snd_ctx->chans + i;
+			pth[i] = create_worker(ctx, (void *)(void *)receiver);
+			continue;
+		}
+
 		/* Create the pipe between client and server */
 		fdpair(fds);
 
-		ctx->num_packets = num_fds * loops;
 		ctx->in_fds[0] = fds[0];
 		ctx->in_fds[1] = fds[1];
-		ctx->ready_out = ready_out;
-		ctx->wakefd = wakefd;
 
 		pth[i] = create_worker(ctx, (void *)(void *)receiver);
 
@@ -281,7 +444,7 @@ static unsigned int group(pthread_t * pth,
 	}
 
 	/* Close the fds we have left */
-	if (process_mode)
+	if (process_mode && !snd_ctx->chans)
 		for (i = 0; i < num_fds; i++)
 			close(snd_ctx->out_fds[i]);
 
@@ -290,17 +453,150 @@ static unsigned int group(pthread_t * pth,
 	return num_fds * 2;
 }
 
+static void print_results(unsigned int num_groups, unsigned int num_fds,
+			  uint64_t start_ns)
+{
+	struct tst_hist *total = calloc(1, sizeof(*total));
+	uint64_t msgs = (uint64_t)num_fds * num_fds * loops;
+	double secs;
+	unsigned int i;
+
+	if (!total)
+		barf("calloc()");
+
+	for (i = 0; i < num_groups; i++) {
+		secs = (grp_stats[i].end_ns - start_ns) / 1e9;
+		printf("Group %u: %.3fs %.0f msgs/s\n", i, secs, msgs / secs);
+		tst_hist_merge(total, &grp_stats[i].hist);
+	}
+
+	if (!total->samples) {
+		free(total);
+		return;
+	}
+
+	printf("Latency (us): samples %llu min %.1f avg %.1f p50 %.1f "
+	       "p90 %.1f p99 %.1f p99.9 %.1f max %.1f\n",
+	       (unsigned long long)total->samples, total->min / 1000.0,
+	       total->sum / 1000.0 / total->samples,
+	       tst_hist_percentile(total, 50) / 1000.0,
+	       tst_hist_percentile(total, 90) / 1000.0,
+	       tst_hist_percentile(total, 99) / 1000.0,
+	       tst_hist_percentile(total, 99.9) / 1000.0,
+	       total->max / 1000.0);
+
+	free(total);
+}
+
+static void json_hist(FILE *f, const struct tst_hist *hist, int buckets)
+{
+	unsigned int i;
+	int first = 1;
+
+	fprintf(f, "{\"samples\": %llu, \"min_us\": %.3f, \"avg_us\": %.3f, "
+		"\"p50_us\": %.3f, \"p90_us\": %.3f, \"p99_us\": %.3f, "
+		"\"p99_9_us\": %.3f, \"max_us\": %.3f",
+		(unsigned long long)hist->samples, hist->min / 1000.0,
+		hist->samples ? hist->sum / 1000.0 / hist->samples : 0,
+		tst_hist_percentile(hist, 50) / 1000.0,
+		tst_hist_percentile(hist, 90) / 1000.0,
+		tst_hist_percentile(hist, 99) / 1000.0,
+		tst_hist_percentile(hist, 99.9) / 1000.0,
+		hist->max / 1000.0);
+
+	if (buckets) {
+		/* Only non-empty buckets as [lower bound ns, count] pairs */
+		fprintf(f, ", \"histogram\": [");
+		for (i = 0; i < TST_HIST_BUCKETS; i++) {
+			if (!hist->buckets[i])
+				continue;
+
+			fprintf(f, "%s[%llu, %llu]", first ? "" : ", ",
+				(unsigned long long)tst_hist_bucket_min(i),
+				(unsigned long long)hist->buckets[i]);
+			first = 0;
+		}
+		fprintf(f, "]");
+	}
+
+	fprintf(f, "}");
+}
+
+static void write_json(unsigned int num_groups, unsigned int num_fds,
+		       uint64_t start_ns, uint64_t stop_ns)
+{
+	struct tst_hist *total = calloc(1, sizeof(*total));
+	uint64_t msgs = (uint64_t)num_fds * num_fds * loops;
+	double secs;
+	unsigned int i;
+	FILE *f;
+
+	if (!total)
+		barf("calloc()");
+
+	f = fopen(json_path, "w");
+	if (!f)
+		barf("Opening JSON file");
+
+	fprintf(f, "{\n  \"groups\": %u,\n  \"tasks\": %u,\n"
+		"  \"mode\": \"%s\",\n  \"ipc\": \"%s\",\n  \"loops\": %u,\n"
+		"  \"time_s\": %.6f,\n  \"msgs_per_s\": %.0f,\n"
+		"  \"group_results\": [\n",
+		num_groups, num_groups * num_fds * 2,
+		process_mode ? "process" : "thread", ipc_names[ipc], loops,
+		(stop_ns - start_ns) / 1e9,
+		msgs * num_groups / ((stop_ns - start_ns) / 1e9));
+
+	for (i = 0; i < num_groups; i++) {
+		secs = (grp_stats[i].end_ns - start_ns) / 1e9;
+		fprintf(f, "    {\"group\": %u, \"messages\": %llu, "
+			"\"time_s\": %.6f, \"msgs_per_s\": %.0f, \"latency\": ",
+			i, (unsigned long long)msgs, secs, msgs / secs);
+		json_hist(f, &grp_stats[i].hist, 0);
+		fprintf(f, "}%s\n", i + 1 < num_groups ? "," : "");
+		tst_hist_merge(total, &grp_stats[i].hist);
+	}
+
+	fprintf(f, "  ],\n  \"latency\": ");
+	json_hist(f, total, 1);
+	fprintf(f, "\n}\n");
+
+	if (fclose(f))
+		barf("Writing JSON file");
+
+	free(total);
+}
+
 int main(int argc, char *argv[])
 {
 	unsigned int i, j, num_groups = 10, total_children;
 	struct timeval start, stop, diff;
+	uint64_t start_ns, stop_ns;
 	unsigned int num_fds = 20;
 	int readyfds[2], wakefds[2];
 	char dummy;
 	pthread_t *pth_tab;
+	size_t shm_size;
+
+	while (argv[1] && argv[1][0] == '-') {
+		if (!strcmp(argv[1], "-pipe")) {
+			use_pipes = 1;
+			ipc = IPC_PIPE;
+		} else if (!strcmp(argv[1], "-eventfd")) {
+			ipc = IPC_EVENTFD;
+		} else if (!strcmp(argv[1], "-futex")) {
+			ipc = IPC_FUTEX;
+		} else if (!strcmp(argv[1], "-lat")) {
+			measure_lat = 1;
+		} else if (!strcmp(argv[1], "-json") && argv[2]) {
+			json_path = argv[2];
+			measure_lat = 1;
+			argc--;
+			argv++;
+		} else {
+			print_usage_exit();
+		}
 
-	if (argv[1] && strcmp(argv[1], "-pipe") == 0) {
-		use_pipes = 1;
 		argc--;
 		argv++;
 	}
@@ -331,6 +627,26 @@ int main(int argc, char *argv[])
 	if (!pth_tab || !snd_ctx_tab || !rev_ctx_tab)
 		barf("main:malloc()");
 
+	/* Statistics and channels must be visible in forked workers too */
+	shm_size = num_groups * sizeof(struct group_stats);
+	if (ipc == IPC_EVENTFD || ipc == IPC_FUTEX)
+		shm_size += num_groups * num_fds * sizeof(struct channel);
+
+	grp_stats = mmap(NULL, shm_size, PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (grp_stats == MAP_FAILED)
+		barf("main:mmap()");
+
+	if (ipc == IPC_EVENTFD || ipc == IPC_FUTEX) {
+		channels = (struct channel *)(grp_stats + num_groups);
+
+		for (i = 0; ipc == IPC_EVENTFD && i < num_groups * num_fds; i++) {
+			channels[i].efd = eventfd(0, 0);
+			if (channels[i].efd < 0)
+				barf("Creating eventfd");
+		}
+	}
+
 	fdpair(readyfds);
 	fdpair(wakefds);
 
@@ -346,6 +662,7 @@ int main(int argc, char *argv[])
 			barf("Reading for readyfds");
 
 	gettimeofday(&start, NULL);
+	start_ns = tst_hist_now_ns();
 
 	/* Kick them off */
 	if (write(wakefds[1], &dummy, 1) != 1)
@@ -356,11 +673,23 @@ int main(int argc, char *argv[])
 		reap_worker(pth_tab[i]);
 
 	gettimeofday(&stop, NULL);
+	stop_ns = tst_hist_now_ns();
 
 	/* Print time... */
 	timersub(&stop, &start, &diff);
 	printf("Time: %lu.%03lu\n", diff.tv_sec, diff.tv_usec / 1000);
 
+	if (measure_lat)
+		print_results(num_groups, num_fds, start_ns);
+
+	if (json_path)
+		write_json(num_groups, num_fds, start_ns, stop_ns);
+
+	for (i = 0; ipc == IPC_EVENTFD && i < num_groups * num_fds; i++)
+		close(channels[i].efd);
+
+	munmap(grp_stats, shm_size);
+
 	/* free the memory */
 	for (i = 0; i < num_groups; i++) {
 		for (j = 0; j < num_fds; j++) {
@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) Linux Test Project, 2026
+ */
+
+/*\
+ * Submit a batch of IORING_OP_WRITE_FIXED requests using registered buffers
+ * and a registered file, read the data back with a batch of
+ * IORING_OP_READ_FIXED requests and check that all completions arrived with
+ * the full length and the file content matches.
+ *
+ * The second test variant uses a kernel submission polling thread
+ * (IORING_SETUP_SQPOLL).
+ */
+
+#include <stdlib.h>
+#include "tst_test.h"
+#include "tst_safe_io_uring.h"
+
+#define TEST_FILE "test_file"
+#define QUEUE_DEPTH 16
+#define BLOCK_SZ 4096
+#define WAIT_MS 10000
+
+static struct tst_io_uring uring;
+static char *wbuf, *rbuf;
+static int fd = -1;
+
+static void setup(void)
+{
+	struct io_uring_params params = {};
+	struct iovec iov[2];
+	int i;
+
+	tst_res(TINFO, "Testing %s submission",
+		tst_variant ? "SQPOLL" : "io_uring_enter()");
+
+	if (tst_variant) {
+		params.flags = IORING_SETUP_SQPOLL;
+		params.sq_thread_idle = 1000;
+	}
+
+	SAFE_IO_URING_INIT(QUEUE_DEPTH, &params, &uring);
+
+	wbuf = SAFE_MALLOC(QUEUE_DEPTH * BLOCK_SZ);
+	rbuf = SAFE_MALLOC(QUEUE_DEPTH * BLOCK_SZ);
+
+	for (i = 0; i < QUEUE_DEPTH * BLOCK_SZ; i++)
+		wbuf[i] = 'a' + i % 23;
+
+	iov[0].iov_base = wbuf;
+	iov[0].iov_len = QUEUE_DEPTH * BLOCK_SZ;
+	iov[1].iov_base = rbuf;
+	iov[1].iov_len = QUEUE_DEPTH * BLOCK_SZ;
+	SAFE_IO_URING_REGISTER_BUFFERS(&uring, iov, 2);
+
+	fd = SAFE_OPEN(TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	SAFE_IO_URING_REGISTER_FILES(&uring, &fd, 1);
+}
+
+static int run_batch(int opcode, char *buf, int buf_index)
+{
+	struct io_uring_sqe *sqe;
+	const struct io_uring_cqe *cqe;
+	int i, done = 0, ret = 1;
+	uint64_t seen = 0;
+
+	for (i = 0; i < QUEUE_DEPTH; i++) {
+		sqe = tst_io_uring_get_sqe(&uring);
+
+		if (!sqe)
+			tst_brk(TBROK, "Submission queue full after %d entries", i);
+
+		tst_io_uring_prep_rw(sqe, opcode, 0, buf + i * BLOCK_SZ,
+			BLOCK_SZ, i * BLOCK_SZ);
+		sqe->buf_index = buf_index;
+		sqe->flags = IOSQE_FIXED_FILE;
+		sqe->user_data = i;
+	}
+
+	if (tst_io_uring_get_sqe(&uring)) {
+		tst_res(TFAIL, "Got more than %d entries from the queue",
+			QUEUE_DEPTH);
+		return 0;
+	}
+
+	SAFE_IO_URING_SUBMIT(&uring, 0);
+
+	while (done < QUEUE_DEPTH) {
+		cqe = SAFE_IO_URING_WAIT_CQE(&uring, WAIT_MS);
+
+		if (!cqe) {
+			tst_res(TFAIL, "Only %d of %d requests completed",
+				done, QUEUE_DEPTH);
+			return 0;
+		}
+
+		if (cqe->user_data >= QUEUE_DEPTH ||
+			seen & (1ULL << cqe->user_data)) {
+			tst_res(TFAIL, "Unexpected completion user_data %llu",
+				(unsigned long long)cqe->user_data);
+			ret = 0;
+		} else if (cqe->res != BLOCK_SZ) {
+			tst_res(TFAIL, "Request %llu returned %d (%s)",
+				(unsigned long long)cqe->user_data, cqe->res,
+				cqe->res < 0 ? tst_strerrno(-cqe->res) : "short");
+			ret = 0;
+		}
+
+		seen |= 1ULL << cqe->user_data;
+		tst_io_uring_cqe_seen(&uring);
+		done++;
+	}
+
+	return ret;
+}
+
+static void run(void)
+{
+	memset(rbuf, 0, QUEUE_DEPTH * BLOCK_SZ);
+
+	if (!run_batch(IORING_OP_WRITE_FIXED, wbuf, 0))
+		return;
+
+	if (!run_batch(IORING_OP_READ_FIXED, rbuf, 1))
+		return;
+
+	if (memcmp(wbuf, rbuf, QUEUE_DEPTH * BLOCK_SZ)) {
+		tst_res(TFAIL, "Data read back differ from data written");
+		return;
+	}
+
+	tst_res(TPASS, "%d fixed writes and reads completed", QUEUE_DEPTH);
+}
+
+static void cleanup(void)
+{
+	if (uring.fd > 0)
+		SAFE_IO_URING_CLOSE(&uring);
+
+	if (fd >= 0)
+		SAFE_CLOSE(fd);
+
+	free(wbuf);
+	free(rbuf);
+}
+
+static struct tst_test test = {
+	.test_all = run,
+	.setup = setup,
+	.cleanup = cleanup,
+	.needs_tmpdir = 1,
+	.test_variants = 2,
+	.save_restore = (const struct tst_path_val[]) {
+		{"/proc/sys/kernel/io_uring_disabled", "0",
+			TST_SR_SKIP_MISSING | TST_SR_TCONF_RO},
+		{}
+	}
+};
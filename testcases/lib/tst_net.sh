@@ -62,6 +62,12 @@ LTP_NET_FEATURES_IGNORE_PERFORMANCE_FAILURE=1
 Ignore performance failure and test only the network functionality in tests
 which use tst_netload_compare().
 
+TST_NETLOAD_MAX_RUN_COUNT=15
+TST_NETLOAD_CI_WIDTH=10
+tst_netload() repeats the netstress run (up to TST_NETLOAD_MAX_RUN_COUNT times)
+until the confidence interval of the median time is narrower than
+TST_NETLOAD_CI_WIDTH percent of the median.
+
 OPTIONS
 -------
 EOF
@@ -191,20 +197,18 @@ init_ltp_netspace()
 	local pid
 
 	if [ ! -f /var/run/netns/ltp_ns -a -z "$LTP_NETNS" ]; then
-		tst_require_cmds ip tst_ns_create tst_ns_exec tst_ns_ifmove
+		tst_require_cmds ip tst_ns_create tst_ns_exec tst_net_topology
 		tst_require_root
 
 		if [ -z "$TST_USE_LEGACY_API" ]; then
 			tst_require_drivers veth
 		fi
-		ROD ip link add name ltp_ns_veth1 type veth peer name ltp_ns_veth2
 		pid="$(ROD tst_ns_create net,mnt)"
 		mkdir -p /var/run/netns
 		ROD ln -s /proc/$pid/ns/net /var/run/netns/ltp_ns
 		ROD tst_ns_exec $pid net,mnt mount --make-rprivate /sys
 		ROD tst_ns_exec $pid net,mnt mount -t sysfs none /sys
-		ROD tst_ns_ifmove ltp_ns_veth1 $pid
-		ROD tst_ns_exec $pid net,mnt ip link set lo up
+		ROD tst_net_topology "veth ltp_ns_veth2 ltp_ns_veth1 peerns=$pid; up lo ns=$pid"
 	elif [ -n "$LTP_NETNS" ]; then
 		tst_res_ TINFO "using not default LTP netns: '$LTP_NETNS'"
 	fi
@@ -765,6 +769,8 @@ tst_netload()
 	local cs_opts=
 
 	local run_cnt="$TST_NETLOAD_RUN_COUNT"
+	local max_cnt="$TST_NETLOAD_MAX_RUN_COUNT"
+	local ci_width="$TST_NETLOAD_CI_WIDTH"
 	local c_num="$TST_NETLOAD_CLN_NUMBER"
 	local c_requests="$TST_NETLOAD_CLN_REQUESTS"
 	local c_opts=
@@ -822,6 +828,7 @@ tst_netload()
 		run_cnt=1
 		was_failure=1
 	fi
+	[ "$max_cnt" -lt "$run_cnt" ] && max_cnt=$run_cnt
 
 	s_opts="${cs_opts}${s_opts}-R $s_replies -B $TST_TMPDIR"
 	c_opts="${cs_opts}${c_opts}-a $c_num -r $((c_requests / run_cnt)) -c $PWD/$rfile"
@@ -832,10 +839,12 @@ tst_netload()
 	tst_rhost_run -c "pkill -9 netstress\$"
 	rm -f tst_netload.log
 
-	local results
+	local results width
 	local passed=0
+	local i=0
 
-	for i in $(seq 1 $run_cnt); do
+	while [ $i -lt $run_cnt ]; do
+		i=$((i + 1))
 		tst_rhost_run -c "netstress $s_opts" > tst_netload.log 2>&1
 		if [ $? -ne 0 ]; then
 			cat tst_netload.log
@@ -875,6 +884,15 @@ tst_netload()
 
 		results="$results $(cat $rfile)"
 		passed=$((passed + 1))
+
+		# add runs while the median is not precise enough
+		if [ $i -eq $run_cnt -a $run_cnt -lt $max_cnt -a $passed -ge 3 ]; then
+			width=$(tst_netload_stats -w $results | cut -d' ' -f2)
+			if [ "$width" -gt "$ci_width" ]; then
+				tst_res_ TINFO "median CI width ${width}% > ${ci_width}%, run netstress again"
+				run_cnt=$((run_cnt + 1))
+			fi
+		fi
 	done
 
 	if [ "$ret" -ne 0 ]; then
@@ -885,12 +903,27 @@ tst_netload()
 
 	local median=$(tst_get_median $results)
 	echo "$median" > $rfile
+	echo $results > $rfile.runs
 
 	tst_res_ TPASS "netstress passed, median time $median ms, data:$results"
 
 	return $ret
 }
 
+# Print times of all runs of the last tst_netload call which used RFILE
+# (tst_netload.res by default) as a result file.
+# tst_netload_runs [RFILE]
+tst_netload_runs()
+{
+	local rfile="${1:-tst_netload.res}"
+
+	if [ -f "$rfile.runs" ]; then
+		cat $rfile.runs
+	else
+		cat $rfile
+	fi
+}
+
 # Compares results for netload runs.
 # tst_netload_compare TIME_BASE TIME THRESHOLD_LOW [THRESHOLD_HI]
 # TIME_BASE: time taken to run netstress load test - 100%
@@ -898,23 +931,47 @@ tst_netload()
 # THRESHOD_LOW: lower limit for TFAIL
 # THRESHOD_HIGH: upper limit for TWARN
 #
+# TIME_BASE and TIME can be lists of times of the individual runs
+# (see tst_netload_runs()), then the difference of the medians is checked
+# against the thresholds only if it is statistically significant, i.e. its
+# confidence interval lies outside of the threshold.
+#
 # Slow performance can be ignored with setting environment variable
 # LTP_NET_FEATURES_IGNORE_PERFORMANCE_FAILURE=1
 tst_netload_compare()
 {
-	local base_time=$1
-	local new_time=$2
+	local base_time="$1"
+	local new_time="$2"
 	local threshold_low=$3
 	local threshold_hi=$4
 	local ttype='TFAIL'
-	local msg res
+	local msg res low high
 
 	if [ -z "$base_time" -o -z "$new_time" -o -z "$threshold_low" ]; then
 		tst_brk_ TBROK "tst_netload_compare: invalid argument(s)"
 	fi
 
-	res=$(((base_time - new_time) * 100 / base_time))
-	msg="performance result is ${res}%"
+	if [ $(echo $base_time | wc -w) -gt 1 -a $(echo $new_time | wc -w) -gt 1 ]; then
+		set -- $(tst_netload_stats -t "$base_time" "$new_time")
+		[ $# -eq 4 ] || \
+			tst_brk_ TBROK "tst_netload_compare: invalid argument(s)"
+
+		res=$1
+		low=$2
+		high=$3
+		msg="performance result is ${res}%, 95% CI [${low}:${high}]%, p-value $4"
+
+		if [ "$res" -lt "$threshold_low" -a "$high" -ge "$threshold_low" ]; then
+			tst_res_ TINFO "$msg, difference to threshold ${threshold_low}% is not significant"
+			res=$threshold_low
+		fi
+
+		[ "$threshold_hi" ] && [ "$res" -gt "$threshold_hi" -a "$low" -le "$threshold_hi" ] && \
+			res=$threshold_hi
+	else
+		res=$(((base_time - new_time) * 100 / base_time))
+		msg="performance result is ${res}%"
+	fi
 
 	if [ "$res" -lt "$threshold_low" ]; then
 		if [ "$LTP_NET_FEATURES_IGNORE_PERFORMANCE_FAILURE" = 1 ]; then
@@ -1166,6 +1223,8 @@ export TST_NETLOAD_CLN_REQUESTS="${TST_NETLOAD_CLN_REQUESTS:-10000}"
 export TST_NETLOAD_CLN_NUMBER="${TST_NETLOAD_CLN_NUMBER:-2}"
 export TST_NETLOAD_BINDTODEVICE="${TST_NETLOAD_BINDTODEVICE-1}"
 export TST_NETLOAD_RUN_COUNT="${TST_NETLOAD_RUN_COUNT:-5}"
+export TST_NETLOAD_MAX_RUN_COUNT="${TST_NETLOAD_MAX_RUN_COUNT:-15}"
+export TST_NETLOAD_CI_WIDTH="${TST_NETLOAD_CI_WIDTH:-10}"
 export HTTP_DOWNLOAD_DIR="${HTTP_DOWNLOAD_DIR:-/var/www/html}"
 export FTP_DOWNLOAD_DIR="${FTP_DOWNLOAD_DIR:-/var/ftp}"
 export FTP_UPLOAD_DIR="${FTP_UPLOAD_DIR:-/var/ftp/pub}"
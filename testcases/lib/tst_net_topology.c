@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) Linux Test Project, 2026
+ */
+
+/*\
+ * Sets up network topology with batched rtnetlink requests instead of
+ * running ip for each device, address and route. See
+ * lib/tst_netdev_topology.c for the description syntax.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TST_NO_DEFAULT_MAIN
+#include "tst_test.h"
+#include "tst_netdevice.h"
+
+static void help(const char *fname)
+{
+	printf("usage: %s [SPEC]...\n\n", fname);
+	printf("SPEC is a list of commands separated by ';' or newline,\n");
+	printf("it is read from stdin if not given, e.g.:\n\n");
+	printf("%s 'veth veth0 veth1 peerns=ns1; addr veth0 10.0.0.1/24; up veth0'\n\n",
+	       fname);
+	printf("netns NAME\n");
+	printf("veth NAME PEER [ns=NS] [peerns=NS] [mtu=N]\n");
+	printf("link NAME KIND [ns=NS] [mtu=N] [dev=IFACE] [id=N] [remote=ADDR] [local=ADDR] [dstport=N]\n");
+	printf("move NAME NS [ns=NS]\n");
+	printf("up NAME [ns=NS] [mtu=N]\n");
+	printf("addr NAME ADDR[/PREFIX] [ns=NS] [nodad] [noprefixroute]\n");
+	printf("route DST[/PREFIX]|default [via=ADDR] [dev=IFACE] [ns=NS]\n\n");
+	printf("NS := { NAME in /var/run/netns | PID | PATH }\n");
+}
+
+static char *read_spec(FILE *f)
+{
+	size_t len = 0, size = 4096;
+	char *buf = SAFE_MALLOC(size);
+
+	while (!feof(f)) {
+		len += fread(buf + len, 1, size - len - 1, f);
+
+		if (ferror(f))
+			tst_brk(TBROK | TERRNO, "Failed to read topology");
+
+		if (size - len == 1) {
+			size *= 2;
+			buf = SAFE_REALLOC(buf, size);
+		}
+	}
+
+	buf[len] = '\0';
+
+	return buf;
+}
+
+int main(int argc, char *argv[])
+{
+	char *spec;
+	size_t len = 1;
+	int i, opt;
+
+	while ((opt = getopt(argc, argv, ":h")) != -1) {
+		switch (opt) {
+		case 'h':
+			help(argv[0]);
+			return 0;
+		default:
+			help(argv[0]);
+			return 1;
+		}
+	}
+
+	if (optind == argc) {
+		spec = read_spec(stdin);
+	} else {
+		for (i = optind; i < argc; i++)
+			len += strlen(argv[i]) + 1;
+
+		spec = SAFE_MALLOC(len);
+		spec[0] = '\0';
+
+		for (i = optind; i < argc; i++) {
+			strcat(spec, argv[i]);
+			strcat(spec, "\n");
+		}
+	}
+
+	NETDEV_SETUP_TOPOLOGY(spec);
+	free(spec);
+
+	return 0;
+}
@@ -0,0 +1,269 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) Linux Test Project, 2026
+ *
+ * Statistics over tst_netload results (times in ms of the individual runs).
+ *
+ * With -w, print the median of the samples and the width of its bootstrap
+ * confidence interval in percent of the median, tst_netload uses it to decide
+ * whether more runs are needed.
+ *
+ * With -t, compare base and new samples and print the relative difference of
+ * the medians in percent ((base - new) * 100 / base) together with its
+ * bootstrap confidence interval and the two-sided p-value of the Mann-Whitney
+ * U test: "RES CI_LOW CI_HIGH P".
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_SAMPLES 1024
+#define BOOTSTRAP_ROUNDS 4000
+
+struct samples {
+	double val[MAX_SAMPLES];
+	size_t cnt;
+};
+
+static uint64_t rnd_state = 0x9e3779b97f4a7c15ULL;
+
+static uint32_t rnd(uint32_t max)
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 7;
+	rnd_state ^= rnd_state << 17;
+
+	return rnd_state % max;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+static double median(double *arr, size_t size)
+{
+	qsort(arr, size, sizeof(*arr), cmp_double);
+
+	if (size & 1)
+		return arr[size / 2];
+
+	return (arr[size / 2 - 1] + arr[size / 2]) / 2;
+}
+
+static double resample_median(const struct samples *s)
+{
+	double tmp[MAX_SAMPLES];
+	size_t i;
+
+	for (i = 0; i < s->cnt; i++)
+		tmp[i] = s->val[rnd(s->cnt)];
+
+	return median(tmp, s->cnt);
+}
+
+static int parse_samples(struct samples *s, const char *str)
+{
+	char *end;
+	double val;
+
+	while (*str) {
+		if (*str == ' ' || *str == '\t' || *str == '\n') {
+			str++;
+			continue;
+		}
+
+		errno = 0;
+		val = strtod(str, &end);
+
+		if (errno || end == str || val < 0) {
+			fprintf(stderr, "Invalid sample '%s'\n", str);
+			return 1;
+		}
+
+		if (s->cnt >= MAX_SAMPLES) {
+			fprintf(stderr, "Too many samples\n");
+			return 1;
+		}
+
+		s->val[s->cnt++] = val;
+		str = end;
+	}
+
+	if (!s->cnt) {
+		fprintf(stderr, "Please provide a numeric list\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+static void percentile_ci(double *arr, size_t size, double conf,
+			  double *low, double *high)
+{
+	size_t lo = (size - 1) * (1 - conf) / 2;
+
+	qsort(arr, size, sizeof(*arr), cmp_double);
+	*low = arr[lo];
+	*high = arr[size - 1 - lo];
+}
+
+/*
+ * Two-sided Mann-Whitney U test, normal approximation with tie and
+ * continuity correction.
+ */
+static double mann_whitney_p(const struct samples *a, const struct samples *b)
+{
+	double n1 = a->cnt, n2 = b->cnt, n = n1 + n2;
+	double u = 0, ties = 0, mu, sigma, z;
+	double all[2 * MAX_SAMPLES];
+	size_t i, j, k;
+
+	for (i = 0; i < a->cnt; i++) {
+		for (j = 0; j < b->cnt; j++) {
+			if (a->val[i] > b->val[j])
+				u += 1;
+			else if (a->val[i] == b->val[j])
+				u += 0.5;
+		}
+	}
+
+	memcpy(all, a->val, a->cnt * sizeof(double));
+	memcpy(all + a->cnt, b->val, b->cnt * sizeof(double));
+	qsort(all, a->cnt + b->cnt, sizeof(double), cmp_double);
+
+	for (i = 0; i < a->cnt + b->cnt; i = k) {
+		for (k = i + 1; k < a->cnt + b->cnt && all[k] == all[i]; k++)
+			;
+		ties += pow(k - i, 3) - (k - i);
+	}
+
+	mu = n1 * n2 / 2;
+	sigma = sqrt(n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1))));
+
+	if (sigma == 0)
+		return 1;
+
+	z = (fabs(u - mu) - 0.5) / sigma;
+	if (z < 0)
+		z = 0;
+
+	return erfc(z / sqrt(2));
+}
+
+static void median_width(struct samples *s, double conf)
+{
+	static double meds[BOOTSTRAP_ROUNDS];
+	double med, low, high;
+	int i;
+
+	for (i = 0; i < BOOTSTRAP_ROUNDS; i++)
+		meds[i] = resample_median(s);
+
+	percentile_ci(meds, BOOTSTRAP_ROUNDS, conf, &low, &high);
+	med = median(s->val, s->cnt);
+
+	printf("%.0f %.0f", med, med > 0 ? ceil((high - low) * 100 / med) : 0);
+}
+
+static void compare(struct samples *base, struct samples *new, double conf)
+{
+	static double diffs[BOOTSTRAP_ROUNDS];
+	double mb, mn, low, high, p;
+	int i;
+
+	p = mann_whitney_p(base, new);
+
+	for (i = 0; i < BOOTSTRAP_ROUNDS; i++) {
+		mb = resample_median(base);
+		mn = resample_median(new);
+		diffs[i] = mb > 0 ? (mb - mn) * 100 / mb : 0;
+	}
+
+	percentile_ci(diffs, BOOTSTRAP_ROUNDS, conf, &low, &high);
+
+	mb = median(base->val, base->cnt);
+	mn = median(new->val, new->cnt);
+
+	printf("%.0f %.0f %.0f %.3f", mb > 0 ? trunc((mb - mn) * 100 / mb) : 0,
+	       floor(low), ceil(high), p);
+}
+
+static void help(const char *fname)
+{
+	printf("usage: %s [-c CONFIDENCE] -w SAMPLE...\n", fname);
+	printf("       %s [-c CONFIDENCE] -t 'BASE_SAMPLES' 'NEW_SAMPLES'\n\n", fname);
+	printf("-c CONFIDENCE  confidence level in percent (default 95)\n");
+	printf("-w             print median and its confidence interval width in %%\n");
+	printf("-t             print difference of medians in %%, its confidence interval\n");
+	printf("               and Mann-Whitney U test p-value\n");
+}
+
+int main(int argc, char *argv[])
+{
+	static struct samples base, new;
+	double conf = 0.95;
+	int opt, mode = 0, i;
+
+	while ((opt = getopt(argc, argv, ":c:htw")) != -1) {
+		switch (opt) {
+		case 'c':
+			conf = atof(optarg) / 100;
+			if (conf <= 0 || conf >= 1) {
+				fprintf(stderr, "Invalid confidence '%s'\n", optarg);
+				return 1;
+			}
+			break;
+		case 't':
+		case 'w':
+			mode = opt;
+			break;
+		case 'h':
+			help(argv[0]);
+			return 0;
+		default:
+			help(argv[0]);
+			return 1;
+		}
+	}
+
+	switch (mode) {
+	case 'w':
+		for (i = optind; i < argc; i++) {
+			if (parse_samples(&base, argv[i]))
+				return 1;
+		}
+
+		if (!base.cnt) {
+			help(argv[0]);
+			return 1;
+		}
+
+		median_width(&base, conf);
+		break;
+	case 't':
+		if (argc - optind != 2) {
+			help(argv[0]);
+			return 1;
+		}
+
+		if (parse_samples(&base, argv[optind]) ||
+		    parse_samples(&new, argv[optind + 1]))
+			return 1;
+
+		compare(&base, &new, conf);
+		break;
+	default:
+		help(argv[0]);
+		return 1;
+	}
+
+	return 0;
+}
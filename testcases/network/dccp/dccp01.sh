@@ -12,21 +12,21 @@ test1()
 {
 	tst_res TINFO "run UDP"
 	tst_netload -H $(tst_ipaddr rhost) -T udp
-	res0="$(cat tst_netload.res)"
+	res0="$(tst_netload_runs)"
 }
 test2()
 {
 	tst_res TINFO "compare UDP/DCCP performance"
 	tst_netload -H $(tst_ipaddr rhost) -T dccp
-	res1="$(cat tst_netload.res)"
-	tst_netload_compare $res0 $res1 -100 100
+	res1="$(tst_netload_runs)"
+	tst_netload_compare "$res0" "$res1" -100 100
 }
 test3()
 {
 	tst_res TINFO "compare UDP/UDP-Lite performance"
 	tst_netload -H $(tst_ipaddr rhost) -T udp_lite
-	res1="$(cat tst_netload.res)"
-	tst_netload_compare $res0 $res1 -100 100
+	res1="$(tst_netload_runs)"
+	tst_netload_compare "$res0" "$res1" -100 100
 }
 
 . tst_net.sh
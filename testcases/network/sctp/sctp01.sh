@@ -17,12 +17,12 @@ test()
 	tst_res TINFO "compare TCP/SCTP performance"
 
 	tst_netload -H $(tst_ipaddr rhost) -T tcp -R 3 $opts
-	local res0="$(cat tst_netload.res)"
+	local res0="$(tst_netload_runs)"
 
 	tst_netload -S $(tst_ipaddr) -H $(tst_ipaddr rhost) -T sctp -R 3 $opts
-	local res1="$(cat tst_netload.res)"
+	local res1="$(tst_netload_runs)"
 
-	tst_netload_compare $res0 $res1 -200 200
+	tst_netload_compare "$res0" "$res1" -200 200
 }
 
 . tst_net.sh
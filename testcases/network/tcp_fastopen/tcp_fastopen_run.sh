@@ -44,13 +44,13 @@ test1()
 {
 	tst_res TINFO "using old TCP API and set tcp_fastopen to '0'"
 	tst_netload -H $(tst_ipaddr rhost) -t 0 -R $srv_replies
-	time_tfo_off=$(cat tst_netload.res)
+	time_tfo_off="$(tst_netload_runs)"
 
 	tst_res TINFO "using new TCP API and set tcp_fastopen to '3'"
 	tst_netload -H $(tst_ipaddr rhost) -f -t 3 -R $srv_replies
-	time_tfo_on=$(cat tst_netload.res)
+	time_tfo_on="$(tst_netload_runs)"
 
-	tst_netload_compare $time_tfo_off $time_tfo_on 3
+	tst_netload_compare "$time_tfo_off" "$time_tfo_on" 3
 }
 
 test2()
@@ -60,9 +60,9 @@ test2()
 
 	tst_res TINFO "using connect() and TCP_FASTOPEN_CONNECT socket option"
 	tst_netload -H $(tst_ipaddr rhost) -F -t 3 -R $srv_replies
-	time_tfo_on=$(cat tst_netload.res)
+	time_tfo_on="$(tst_netload_runs)"
 
-	tst_netload_compare $time_tfo_off $time_tfo_on 3
+	tst_netload_compare "$time_tfo_off" "$time_tfo_on" 3
 }
 
 . tst_net.sh
@@ -216,17 +216,13 @@ virt_setup()
 	tst_res TINFO "setup rhost ${virt_type} with '$opt_r'"
 	virt_add_rhost "$opt_r"
 
-	ROD_SILENT "ip addr add ${ip6_virt_local}/64 dev ltp_v0 nodad"
-	tst_rhost_run -s -c "ip addr add ${ip6_virt_remote}/64 dev ltp_v0 nodad"
-
-	ROD_SILENT "ip addr add ${ip_virt_local}/24 dev ltp_v0"
-	tst_rhost_run -s -c "ip addr add ${ip_virt_remote}/24 dev ltp_v0"
-
 	ROD_SILENT "sysctl -q net.ipv6.conf.ltp_v0.accept_dad=0"
 	tst_rhost_run -s -c "sysctl -q net.ipv6.conf.ltp_v0.accept_dad=0"
 
-	ROD_SILENT "ip link set up ltp_v0"
-	tst_rhost_run -s -c "ip link set up ltp_v0"
+	ROD tst_net_topology "addr ltp_v0 ${ip6_virt_local}/64 nodad; \
+		addr ltp_v0 ${ip_virt_local}/24; up ltp_v0"
+	tst_rhost_run -s -c "tst_net_topology 'addr ltp_v0 ${ip6_virt_remote}/64 nodad; \
+		addr ltp_v0 ${ip_virt_remote}/24; up ltp_v0'"
 }
 
 virt_tcp_syn=
@@ -300,8 +296,8 @@ virt_compare_netperf()
 	local lt="$(cat res_lan)"
 	tst_res TINFO "time lan IPv${TST_IPVER}($lt) $virt_type IPv4($vt) and IPv6($vt6) ms"
 
-	tst_netload_compare $lt $vt "-$VIRT_PERF_THRESHOLD"
-	tst_netload_compare $lt $vt6 "-$VIRT_PERF_THRESHOLD"
+	tst_netload_compare "$(tst_netload_runs res_lan)" "$(tst_netload_runs res_ipv4)" "-$VIRT_PERF_THRESHOLD"
+	tst_netload_compare "$(tst_netload_runs res_lan)" "$(tst_netload_runs res_ipv6)" "-$VIRT_PERF_THRESHOLD"
 }
 
 virt_check_cmd()
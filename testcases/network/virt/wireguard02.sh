@@ -31,16 +31,16 @@ test1()
 
 	[ -n "$TST_IPV6" ] && wgaddr="$ip6_virt_remote" || wgaddr="$ip_virt_remote"
 	tst_netload -H $wgaddr -a $clients_num -D ltp_v0
-	local time_wg=$(cat tst_netload.res)
+	local time_wg="$(tst_netload_runs)"
 	wireguard_lib_cleanup
 
 	tst_res TINFO "test IPSec $IPSEC_MODE/$IPSEC_PROTO $EALGO"
 	tst_ipsec_setup_vti
 	tst_netload -H $ip_rmt_tun -a $clients_num -D $tst_vti
-	local time_ipsec=$(cat tst_netload.res)
+	local time_ipsec="$(tst_netload_runs)"
 	tst_ipsec_cleanup
 
-	tst_netload_compare $time_ipsec $time_wg -100
+	tst_netload_compare "$time_ipsec" "$time_wg" -100
 }
 
 . ipsec_lib.sh
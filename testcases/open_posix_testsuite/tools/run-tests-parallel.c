@@ -0,0 +1,745 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) Linux Test Project, 2026
+ *
+ * Runs the tests listed in the run.sh scripts found under the given
+ * directories in parallel. This is a native replacement for calling
+ * run-tests.sh in each directory, it does not fork a shell, t0 and the
+ * helper commands for every test.
+ *
+ * The syntax is:
+ * $ run-tests-parallel [-j jobs] [-t timeout] [-l logfile] [-s summary] dir...
+ *
+ * Tests are mapped to results and logged in the same way as run-tests.sh
+ * does. Tests from one directory are executed one after another since they
+ * often share resources such as named semaphores or message queues, tests
+ * from different directories run concurrently.
+ */
+
+#define _GNU_SOURCE
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_TIMEOUT 300
+#define MAX_ARGS 64
+/* Polling period used when pidfd_open() is not available */
+#define POLL_MS 50
+
+struct test {
+	const char *dir;
+	char *name;
+	char *id;
+	int group;
+	const char *result;
+	int exit_code;
+	double duration;
+	char *out;
+	size_t out_len, out_size;
+};
+
+struct group {
+	char *dir;
+	int first, count, next;
+	int busy;
+};
+
+struct job {
+	struct test *test;
+	pid_t pid;
+	int pidfd;
+	int out_fd;
+	int timed_out;
+	struct timespec start;
+	struct timespec deadline;
+};
+
+static struct test *tests;
+static int test_cnt, test_size;
+
+static struct group *groups;
+static int group_cnt, group_size;
+
+static char **scripts;
+static int script_cnt, script_size;
+
+static struct job *jobs;
+static int job_cnt;
+
+static int timeout = DEFAULT_TIMEOUT;
+static FILE *logfile;
+static volatile sig_atomic_t stop;
+
+static void *xrealloc(void *ptr, size_t size)
+{
+	ptr = realloc(ptr, size);
+
+	if (!ptr) {
+		perror("realloc");
+		exit(1);
+	}
+
+	return ptr;
+}
+
+static char *xstrdup(const char *str)
+{
+	char *ret = strdup(str);
+
+	if (!ret) {
+		perror("strdup");
+		exit(1);
+	}
+
+	return ret;
+}
+
+static double ts_diff(struct timespec *a, struct timespec *b)
+{
+	return (a->tv_sec - b->tv_sec) + (a->tv_nsec - b->tv_nsec) / 1e9;
+}
+
+static int collect_script(const char *path, const struct stat *st, int type,
+			  struct FTW *ftw)
+{
+	(void)st;
+
+	if (type != FTW_F || strcmp(path + ftw->base, "run.sh"))
+		return 0;
+
+	if (script_cnt == script_size) {
+		script_size = script_size ? 2 * script_size : 256;
+		scripts = xrealloc(scripts, script_size * sizeof(*scripts));
+	}
+
+	scripts[script_cnt++] = xstrdup(path);
+	return 0;
+}
+
+static int cmp_str(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static void add_test(struct group *grp, const char *subdir, const char *name)
+{
+	struct test *test;
+	char *ext;
+
+	if (test_cnt == test_size) {
+		test_size = test_size ? 2 * test_size : 1024;
+		tests = xrealloc(tests, test_size * sizeof(*tests));
+	}
+
+	test = &tests[test_cnt++];
+	memset(test, 0, sizeof(*test));
+	test->dir = grp->dir;
+	test->name = xstrdup(name);
+	test->group = grp - groups;
+	test->exit_code = -1;
+
+	/* Same as "$TEST_PATH/${1%.*}" in run-tests.sh */
+	test->id = xrealloc(NULL, strlen(subdir) + strlen(name) + 2);
+	sprintf(test->id, "%s/%s", subdir, name);
+	ext = strrchr(test->id + strlen(subdir) + 1, '.');
+	if (ext)
+		*ext = '\0';
+
+	grp->count++;
+}
+
+/*
+ * run.sh consists of a single call:
+ * .../bin/run-tests.sh subdir test1 test2 ...
+ */
+static void parse_script(const char *path)
+{
+	char line[65536], *tok, *subdir = NULL, *save;
+	struct group *grp;
+	FILE *f;
+	int found = 0;
+
+	f = fopen(path, "r");
+	if (!f) {
+		perror(path);
+		return;
+	}
+
+	while (!found && fgets(line, sizeof(line), f))
+		found = !!strstr(line, "run-tests.sh");
+
+	fclose(f);
+
+	if (!found)
+		return;
+
+	if (group_cnt == group_size) {
+		group_size = group_size ? 2 * group_size : 256;
+		groups = xrealloc(groups, group_size * sizeof(*groups));
+	}
+
+	grp = &groups[group_cnt++];
+	memset(grp, 0, sizeof(*grp));
+	grp->dir = xstrdup(path);
+	*strrchr(grp->dir, '/') = '\0';
+	grp->first = test_cnt;
+
+	for (tok = strtok_r(line, " \t\n", &save); tok;
+	     tok = strtok_r(NULL, " \t\n", &save)) {
+		if (found) {
+			found = !strstr(tok, "run-tests.sh");
+			continue;
+		}
+
+		if (!subdir) {
+			subdir = tok;
+			continue;
+		}
+
+		add_test(grp, subdir, tok);
+	}
+}
+
+/* Same as $(cat ./$(echo "$1" | sed 's,\.[^\.]*,,').args) in run-tests.sh */
+static int read_args(const struct test *test, char *buf, size_t size,
+		     char *argv[])
+{
+	char path[4096], *tok, *save, *dot;
+	int argc = 0;
+	ssize_t len;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/%s", test->dir, test->name);
+	dot = strchr(path + strlen(test->dir) + 1, '.');
+	if (dot)
+		*dot = '\0';
+	strncat(path, ".args", sizeof(path) - strlen(path) - 1);
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return 0;
+
+	len = read(fd, buf, size - 1);
+	close(fd);
+
+	if (len <= 0)
+		return 0;
+
+	buf[len] = '\0';
+
+	for (tok = strtok_r(buf, " \t\n", &save); tok && argc < MAX_ARGS;
+	     tok = strtok_r(NULL, " \t\n", &save))
+		argv[argc++] = tok;
+
+	return argc;
+}
+
+static int start_job(struct job *job, struct test *test)
+{
+	char args[4096], path[4096];
+	char *argv[MAX_ARGS + 2];
+	int pipefd[2], argc;
+
+	snprintf(path, sizeof(path), "%s/%s", test->dir, test->name);
+	if (access(path, X_OK)) {
+		test->result = "SKIPPED";
+		test->exit_code = 0;
+		printf("%s: execution: SKIPPED (test not present)\n", test->id);
+		return 1;
+	}
+
+	argv[0] = test->name;
+	argc = read_args(test, args, sizeof(args), argv + 1);
+	argv[argc + 1] = NULL;
+
+	if (pipe(pipefd)) {
+		perror("pipe");
+		exit(1);
+	}
+
+	fcntl(pipefd[0], F_SETFL, O_NONBLOCK);
+	fcntl(pipefd[0], F_SETFD, FD_CLOEXEC);
+
+	clock_gettime(CLOCK_MONOTONIC, &job->start);
+	job->deadline = job->start;
+	job->deadline.tv_sec += timeout;
+	job->test = test;
+	job->timed_out = 0;
+	job->out_fd = pipefd[0];
+
+	job->pid = fork();
+	switch (job->pid) {
+	case -1:
+		perror("fork");
+		exit(1);
+	case 0:
+		setpgid(0, 0);
+		dup2(pipefd[1], STDOUT_FILENO);
+		dup2(pipefd[1], STDERR_FILENO);
+		close(pipefd[1]);
+		close(STDIN_FILENO);
+		open("/dev/null", O_RDONLY);
+		signal(SIGINT, SIG_DFL);
+		signal(SIGTERM, SIG_DFL);
+
+		if (chdir(test->dir)) {
+			perror(test->dir);
+			_exit(1);
+		}
+
+		snprintf(path, sizeof(path), "./%s", test->name);
+		execv(path, argv);
+		perror("execv failed");
+		_exit(1);
+	}
+
+	/* Avoid the race with setpgid() in the child */
+	setpgid(job->pid, job->pid);
+	close(pipefd[1]);
+
+	job->pidfd = -1;
+#ifdef SYS_pidfd_open
+	job->pidfd = syscall(SYS_pidfd_open, job->pid, 0);
+#endif
+
+	return 0;
+}
+
+static void read_output(struct job *job)
+{
+	struct test *test = job->test;
+	ssize_t ret;
+
+	for (;;) {
+		if (test->out_size - test->out_len < 4096) {
+			test->out_size = test->out_size ? 2 * test->out_size
+							: 8192;
+			test->out = xrealloc(test->out, test->out_size);
+		}
+
+		ret = read(job->out_fd, test->out + test->out_len,
+			   test->out_size - test->out_len);
+
+		if (ret <= 0)
+			break;
+
+		test->out_len += ret;
+	}
+
+	if (!ret) {
+		close(job->out_fd);
+		job->out_fd = -1;
+	}
+}
+
+static const char *map_result(int status, int timed_out, int *exit_code)
+{
+	if (timed_out) {
+		*exit_code = SIGALRM + 128;
+		return "HUNG";
+	}
+
+	if (WIFSIGNALED(status)) {
+		*exit_code = WTERMSIG(status) + 128;
+		return "SIGNALED";
+	}
+
+	*exit_code = WEXITSTATUS(status);
+
+	switch (*exit_code) {
+	case 0:
+		return "PASS";
+	case 1:
+		return "FAILED";
+	case 2:
+		return "UNRESOLVED";
+	case 4:
+		return "UNSUPPORTED";
+	case 5:
+		return "UNTESTED";
+	}
+
+	return *exit_code > 128 ? "SIGNALED" : "EXITED ABNORMALLY";
+}
+
+static void finish_job(struct job *job, int status)
+{
+	struct test *test = job->test;
+	struct timespec now;
+
+	if (job->out_fd >= 0) {
+		read_output(job);
+		if (job->out_fd >= 0)
+			close(job->out_fd);
+	}
+
+	if (job->pidfd >= 0)
+		close(job->pidfd);
+
+	/* Reap whatever the test left behind in its process group */
+	kill(-job->pid, SIGKILL);
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	test->duration = ts_diff(&now, &job->start);
+	test->result = map_result(status, job->timed_out, &test->exit_code);
+
+	if (!test->exit_code) {
+		fprintf(logfile, "%s: execution: PASS\n", test->id);
+	} else {
+		fprintf(logfile, "%s: execution: %s: Output: \n", test->id,
+			test->result);
+		fwrite(test->out, 1, test->out_len, logfile);
+		printf("%s: execution: %s \n", test->id, test->result);
+	}
+
+	fflush(logfile);
+	fflush(stdout);
+
+	groups[test->group].busy = 0;
+	job->test = NULL;
+}
+
+static struct test *next_test(void)
+{
+	static int cursor;
+	struct group *grp;
+	int i;
+
+	for (i = 0; i < group_cnt; i++) {
+		grp = &groups[(cursor + i) % group_cnt];
+
+		if (grp->busy || grp->next >= grp->count)
+			continue;
+
+		cursor = (cursor + i + 1) % group_cnt;
+		grp->busy = 1;
+		return &tests[grp->first + grp->next++];
+	}
+
+	return NULL;
+}
+
+static int poll_jobs(struct pollfd *fds, int running, int use_pidfd)
+{
+	struct timespec now;
+	double wait = timeout;
+	int i, n = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	for (i = 0; i < job_cnt; i++) {
+		struct job *job = &jobs[i];
+
+		if (!job->test)
+			continue;
+
+		if (job->out_fd >= 0) {
+			fds[n].fd = job->out_fd;
+			fds[n++].events = POLLIN;
+		}
+
+		if (job->pidfd >= 0) {
+			fds[n].fd = job->pidfd;
+			fds[n++].events = POLLIN;
+		}
+
+		if (!job->timed_out && ts_diff(&job->deadline, &now) < wait)
+			wait = ts_diff(&job->deadline, &now);
+	}
+
+	if (!running)
+		return 0;
+
+	if (!use_pidfd && wait * 1000 > POLL_MS)
+		wait = POLL_MS / 1000.0;
+
+	if (wait < 0)
+		wait = 0;
+
+	return poll(fds, n, wait * 1000 + 1);
+}
+
+static void handle_jobs(void)
+{
+	struct timespec now;
+	int i, status;
+	pid_t ret;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	for (i = 0; i < job_cnt; i++) {
+		struct job *job = &jobs[i];
+
+		if (!job->test)
+			continue;
+
+		if (job->out_fd >= 0)
+			read_output(job);
+
+		ret = waitpid(job->pid, &status, WNOHANG);
+		if (ret == job->pid) {
+			finish_job(job, status);
+			continue;
+		}
+
+		if (!job->timed_out && (stop || ts_diff(&now, &job->deadline) >= 0)) {
+			job->timed_out = 1;
+			kill(-job->pid, SIGKILL);
+		}
+	}
+}
+
+static void run_tests(void)
+{
+	struct pollfd *fds;
+	struct test *test;
+	int i, running, use_pidfd = 1;
+
+	fds = xrealloc(NULL, 2 * job_cnt * sizeof(*fds));
+
+	for (;;) {
+		running = 0;
+
+		for (i = 0; i < job_cnt; i++) {
+			if (!jobs[i].test && !stop) {
+				while ((test = next_test()) &&
+				       start_job(&jobs[i], test))
+					groups[test->group].busy = 0;
+			}
+
+			if (jobs[i].test) {
+				running++;
+				if (jobs[i].pidfd < 0)
+					use_pidfd = 0;
+			}
+		}
+
+		if (!running)
+			break;
+
+		if (poll_jobs(fds, running, use_pidfd) < 0 && errno != EINTR) {
+			perror("poll");
+			exit(1);
+		}
+
+		handle_jobs();
+	}
+
+	free(fds);
+}
+
+static void json_str(FILE *f, const char *str)
+{
+	fputc('"', f);
+
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			fputc('\\', f);
+		fputc(*str, f);
+	}
+
+	fputc('"', f);
+}
+
+static const char *const results[] = {
+	"PASS", "FAILED", "UNRESOLVED", "UNSUPPORTED", "UNTESTED", "HUNG",
+	"SIGNALED", "EXITED ABNORMALLY", "SKIPPED",
+};
+
+#define RESULT_CNT (sizeof(results) / sizeof(results[0]))
+
+static void count_results(int counts[])
+{
+	size_t j;
+	int i;
+
+	memset(counts, 0, RESULT_CNT * sizeof(int));
+
+	for (i = 0; i < test_cnt; i++) {
+		for (j = 0; tests[i].result && j < RESULT_CNT; j++) {
+			if (!strcmp(tests[i].result, results[j]))
+				counts[j]++;
+		}
+	}
+}
+
+static void write_summary(const char *path, double runtime)
+{
+	int counts[RESULT_CNT];
+	FILE *f;
+	size_t j;
+	int i;
+
+	f = fopen(path, "w");
+	if (!f) {
+		perror(path);
+		return;
+	}
+
+	fprintf(f, "{\n  \"results\": [\n");
+
+	for (i = 0; i < test_cnt; i++) {
+		if (!tests[i].result)
+			continue;
+
+		fprintf(f, "    {\"test\": ");
+		json_str(f, tests[i].id);
+		fprintf(f, ", \"result\": ");
+		json_str(f, tests[i].result);
+		fprintf(f, ", \"exit_code\": %d, \"duration\": %.3f}%s\n",
+			tests[i].exit_code, tests[i].duration,
+			i + 1 < test_cnt ? "," : "");
+	}
+
+	count_results(counts);
+	fprintf(f, "  ],\n  \"stats\": {\n");
+
+	for (j = 0; j < RESULT_CNT; j++) {
+		fprintf(f, "    ");
+		json_str(f, results[j]);
+		fprintf(f, ": %d,\n", counts[j]);
+	}
+
+	fprintf(f, "    \"total\": %d,\n    \"runtime\": %.3f\n  }\n}\n",
+		test_cnt, runtime);
+	fclose(f);
+}
+
+static void print_totals(double runtime)
+{
+	int counts[RESULT_CNT];
+	size_t j;
+
+	count_results(counts);
+
+	printf("*******************\n");
+	for (j = 0; j < RESULT_CNT; j++) {
+		if (counts[j])
+			printf("%-17s %5d\n", results[j], counts[j]);
+	}
+	printf("*******************\n");
+	printf("%-17s %5d\n", "TOTAL", test_cnt);
+	printf("%-17s %5.0fs\n", "RUNTIME", runtime);
+	printf("*******************\n");
+}
+
+static void sighandler(int sig)
+{
+	(void)sig;
+	stop = 1;
+}
+
+static void usage(const char *name)
+{
+	printf("\nUsage:\n");
+	printf("  $ %s [-j jobs] [-t timeout] [-l logfile] [-s summary] dir...\n",
+	       name);
+	printf("\nWhere:\n");
+	printf("  jobs     is the number of tests run in parallel (default: CPU count),\n");
+	printf("  timeout  is the timeout of a test in seconds (default: $TIMEOUT_VAL or 300),\n");
+	printf("  logfile  is the file the results are appended to (default: $LOGFILE or logfile),\n");
+	printf("  summary  is a file to write the results to in JSON format,\n");
+	printf("  dir      is a directory searched for run.sh files.\n\n");
+}
+
+int main(int argc, char *argv[])
+{
+	const char *logpath = getenv("LOGFILE");
+	const char *summary = NULL;
+	struct timespec start, end;
+	struct sigaction sa;
+	int c, i, failed = 0;
+
+	if (getenv("TIMEOUT_VAL"))
+		timeout = atoi(getenv("TIMEOUT_VAL"));
+
+	job_cnt = sysconf(_SC_NPROCESSORS_ONLN);
+
+	while ((c = getopt(argc, argv, "hj:l:s:t:")) != -1) {
+		switch (c) {
+		case 'j':
+			job_cnt = atoi(optarg);
+			break;
+		case 'l':
+			logpath = optarg;
+			break;
+		case 's':
+			summary = optarg;
+			break;
+		case 't':
+			timeout = atoi(optarg);
+			break;
+		case 'h':
+			usage(argv[0]);
+			return 0;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (optind >= argc || job_cnt < 1 || timeout < 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	for (i = optind; i < argc; i++) {
+		if (nftw(argv[i], collect_script, 64, FTW_PHYS)) {
+			perror(argv[i]);
+			return 1;
+		}
+	}
+
+	qsort(scripts, script_cnt, sizeof(*scripts), cmp_str);
+
+	for (i = 0; i < script_cnt; i++)
+		parse_script(scripts[i]);
+
+	if (!test_cnt) {
+		fprintf(stderr, "No tests found, have the tests been compiled?\n");
+		return 1;
+	}
+
+	logfile = fopen(logpath ? logpath : "logfile", "a");
+	if (!logfile) {
+		perror(logpath ? logpath : "logfile");
+		return 1;
+	}
+
+	jobs = xrealloc(NULL, job_cnt * sizeof(*jobs));
+	memset(jobs, 0, job_cnt * sizeof(*jobs));
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = sighandler;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	run_tests();
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	fclose(logfile);
+
+	print_totals(ts_diff(&end, &start));
+
+	if (summary)
+		write_summary(summary, ts_diff(&end, &start));
+
+	for (i = 0; i < test_cnt; i++) {
+		if (tests[i].exit_code)
+			failed++;
+	}
+
+	return failed ? 1 : 0;
+}
@@ -57,7 +57,7 @@
 
 nsec_t start;
 nsec_t end;
-unsigned long long tsc_period;	/* in picoseconds */
+static struct tst_tsc tsc;
 int over_20 = 0;
 int over_25 = 0;
 int over_30 = 0;
@@ -92,22 +92,6 @@ int parse_args(int c, char *v)
 	return handled;
 }
 
-/* calculate the tsc period */
-unsigned long long tsc_period_ps(void)
-{
-	nsec_t ns_start;
-	nsec_t ns_end;
-	unsigned long long tsc_start, tsc_end;
-
-	rdtscll(tsc_start);
-	ns_start = rt_gettime();
-	sleep(1);
-	rdtscll(tsc_end);
-	ns_end = rt_gettime();
-
-	return (1000 * (ns_end - ns_start)) / tsc_minus(tsc_start, tsc_end);
-}
-
 void *handler_thread(void *arg)
 {
 	while (atomic_get(&step) != CHILD_QUIT) {
@@ -117,7 +101,7 @@ void *handler_thread(void *arg)
 			perror("pthead_cond_wait");
 			break;
 		}
-		rdtscll(end);
+		end = tst_tsc_read_end();
 		atomic_set(CHILD_HANDLED, &step);
 		pthread_mutex_unlock(&mutex);
 		while (atomic_get(&step) == CHILD_HANDLED)
@@ -144,7 +128,7 @@ void *signal_thread(void *arg)
 		while (atomic_get(&step) != CHILD_WAIT)
 			usleep(10);
 		pthread_mutex_lock(&mutex);
-		rdtscll(start);
+		start = tst_tsc_read_start();
 		if (pthread_cond_signal(&cond) != 0) {
 			perror("pthread_cond_signal");
 			atomic_set(CHILD_QUIT, &step);
@@ -155,7 +139,7 @@ void *signal_thread(void *arg)
 		/* wait for the event handler to schedule */
 		while (atomic_get(&step) != CHILD_HANDLED)
 			usleep(10);
-		delta = (long)(tsc_period * (end - start) / 1000000);
+		delta = (long)(tst_tsc_to_ns(&tsc, end - start) / NS_PER_US);
 		if (delta > 30) {
 			over_30++;
 		} else if (delta > 25) {
@@ -196,10 +180,11 @@ int main(int argc, char *argv[])
 {
 	int signal_id, handler_id;
 
-#ifdef TSC_UNSUPPORTED
-	printf("Error: test cannot be executed on an arch wihout TSC.\n");
-	return ENOTSUP;
-#endif
+	if (tst_tsc_calibrate(&tsc)) {
+		printf("Error: test cannot be executed without a constant rate cycle counter.\n");
+		return ENOTSUP;
+	}
+
 	setup();
 
 	rt_init("h", parse_args, argc, argv);
@@ -208,10 +193,8 @@ int main(int argc, char *argv[])
 	printf("Asynchronous Event Handling Latency\n");
 	printf("-------------------------------\n\n");
 	printf("Running %d iterations\n", ITERATIONS);
-	printf("Calculating tsc period...");
-	fflush(stdout);
-	tsc_period = tsc_period_ps();
-	printf("%llu ps\n", tsc_period);
+	printf("Cycle counter: %.3f ticks/ns, read %.1f ns, overhead %.1f ns\n",
+	       tsc.ticks_per_ns, tsc.read_ns, tsc.overhead_ns);
 
 	init_pi_mutex(&mutex);
 
@@ -0,0 +1,136 @@
+/******************************************************************************
+ *
+ *   Copyright (c) Linux Test Project, 2026
+ *
+ *   This program is free software;  you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY;  without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ *   the GNU General Public License for more details.
+ *
+ * NAME
+ *      cyclic_latency.c
+ *
+ * DESCRIPTION
+ *	Measure the periodic wakeup latency on all CPUs, cyclictest style.
+ *   Steps:
+ *    - One SCHED_FIFO thread is pinned to each CPU, the first wakeups of
+ *      the threads are spread by half of the period.
+ *    - Each thread sleeps until the next period and records
+ *
+ *      latency = now - expected wakeup
+ *
+ *      into its own histogram with 1us buckets.
+ *    - The histograms are merged and the test passes if the maximal
+ *      latency is below the pass criteria.
+ *
+ * USAGE:
+ *      Use run_auto.sh script in current directory to build and run test.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "librttest.h"
+#include "librtcyclic.h"
+
+#define PASS_US 100
+
+static struct rt_cyclic_params params = RT_CYCLIC_DEFAULTS;
+
+void usage(void)
+{
+	rt_help();
+	printf("cyclic_latency specific options:\n");
+	printf("  -tPERIOD      period in us (default %llu)\n",
+	       params.period / NS_PER_US);
+	printf("  -iITERATIONS  number of periods per CPU, overrides -d\n");
+	printf("  -dDURATION    duration in seconds (default %llu)\n",
+	       params.duration / NS_PER_SEC);
+	printf("  -kCLOCK       abstime, nanosleep or timerfd (default abstime)\n");
+	printf("  -nCPUS        number of CPUs to measure on (default all)\n");
+	printf("  -PPRIO        priority of the measurement threads (default %d)\n",
+	       params.prio);
+	printf("  -lTHRESHOLD   stop and print the latency trace when a latency\n"
+	       "                exceeds THRESHOLD us\n");
+}
+
+int parse_args(int c, char *v)
+{
+	int handled = 1;
+
+	switch (c) {
+	case 'h':
+		usage();
+		exit(0);
+	case 't':
+		params.period = strtoull(v, NULL, 0) * NS_PER_US;
+		break;
+	case 'i':
+		params.loops = strtoul(v, NULL, 0);
+		break;
+	case 'd':
+		params.duration = strtoull(v, NULL, 0) * NS_PER_SEC;
+		break;
+	case 'k':
+		params.clock = rt_cyclic_clock_parse(v);
+		if ((int)params.clock < 0) {
+			printf("Invalid clock '%s'\n", v);
+			exit(1);
+		}
+		break;
+	case 'n':
+		params.nr_cpus = atoi(v);
+		break;
+	case 'P':
+		params.prio = atoi(v);
+		break;
+	case 'l':
+		params.trace_threshold_us = strtoull(v, NULL, 0);
+		break;
+	default:
+		handled = 0;
+		break;
+	}
+	return handled;
+}
+
+int main(int argc, char *argv[])
+{
+	struct rt_cyclic_result res;
+	int ret;
+
+	setup();
+
+	pass_criteria = PASS_US;
+	rt_init("ht:i:d:k:n:P:l:", parse_args, argc, argv);
+
+	printf("-------------------------------\n");
+	printf("Cyclic Wakeup Latency\n");
+	printf("-------------------------------\n\n");
+
+	/* the histogram has to cover the pass criteria */
+	if (params.hist_size < 2 * pass_criteria)
+		params.hist_size = 2 * pass_criteria;
+
+	if (rt_cyclic_run(&params, &res)) {
+		printf("Result: FAIL (could not run the measurement)\n");
+		exit(1);
+	}
+
+	rt_cyclic_print(&res);
+	rt_cyclic_hist_save(&res, "hist");
+
+	ret = !res.total.cycles || res.total.max / NS_PER_US >= pass_criteria;
+
+	printf("\nCriteria: latencies < %d us\n", (int)pass_criteria);
+	printf("Result: %s\n", ret ? "FAIL" : "PASS");
+
+	rt_cyclic_free(&res);
+
+	return ret;
+}
@@ -227,6 +227,7 @@ long long timespec_subtract(struct timespec *a, struct timespec *b)
 int main(int argc, char *argv[])
 {
 	int i, j, k, err;
+	unsigned int count;
 	unsigned long long delta;
 	unsigned long long max, min;
 	struct sched_param param;
@@ -295,21 +296,31 @@ int main(int argc, char *argv[])
 
 	/* collect iterations pairs of gtod calls */
 	max = min = 0;
+	count = iterations;
 	if (latency_threshold) {
-		latency_trace_enable();
+		latency_trace_enable(latency_threshold);
 		latency_trace_start();
 	}
 	/* This loop runs for a long time, hence can cause soft lockups.
 	   Calling sleep periodically avoids this. */
-	for (i = 0; i < (iterations / 10000); i++) {
+	for (i = 0; i < (iterations / 10000) && count == iterations; i++) {
 		for (j = 0; j < 10000; j++) {
 			k = (i * 10000) + j;
 			clock_gettime(CLOCK_MONOTONIC, &start_data[k]);
 			clock_gettime(CLOCK_MONOTONIC, &stop_data[k]);
+
+			/* stop before the outlier leaves the trace buffers */
+			if (latency_threshold &&
+			    timespec_subtract(&start_data[k], &stop_data[k]) >
+			    (long long)latency_threshold * 1000) {
+				latency_trace_stop();
+				count = k + 1;
+				break;
+			}
 		}
 		usleep(1000);
 	}
-	for (i = 0; i < iterations; i++) {
+	for (i = 0; i < count; i++) {
 		delta = timespec_subtract(&start_data[i], &stop_data[i]);
 		rec.x = i;
 		rec.y = delta;
@@ -318,17 +329,15 @@ int main(int argc, char *argv[])
 			min = delta;
 		if (delta > max)
 			max = delta;
-		if (latency_threshold && delta > latency_threshold)
-			break;
 	}
 	if (latency_threshold) {
 		latency_trace_stop();
-		if (i != iterations) {
+		if (count != iterations) {
 			printf
-			    ("Latency threshold (%lluus) exceeded at iteration %d\n",
-			     latency_threshold, i);
+			    ("Latency threshold (%lluus) exceeded at iteration %u\n",
+			     latency_threshold, count - 1);
 			latency_trace_print();
-			stats_container_resize(&dat, i + 1);
+			stats_container_resize(&dat, count);
 		}
 	}
 
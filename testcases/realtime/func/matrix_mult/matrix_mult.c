@@ -9,6 +9,22 @@
  * Compare running sequential matrix multiplication routines
  * to running them in parallel to judge multiprocessor
  * performance
+ *
+ * The size of the matrices and the number of matrix sets each thread cycles
+ * through are derived from the selected working set (-w), so that the data
+ * of one thread fits into L1, L2, the LLC, or does not fit into any cache.
+ * For l1 and l2 a few large matrices stay in the cache and the kernel is
+ * compute bound. For llc and dram each multiplication works on the next of
+ * many small matrix sets, which does little work per byte loaded, so that
+ * the kernel is bound by the bandwidth of the cache or memory the sets are
+ * streamed from.
+ * The matrices are initialized once, outside of the measured loop, and
+ * multiplied with a cache blocked kernel whose inner loop the compiler can
+ * vectorize.
+ *
+ * The concurrent part is repeated with 1, 2, 4, ... threads up to the number
+ * of CPUs and the speedup over the sequential run is printed for each step,
+ * the pass criteria is checked for the run on all CPUs.
  */
 
 #include <stdio.h>
@@ -19,38 +35,47 @@
 
 #define MAX_CPUS	8192
 #define PRIO		43
-#define MATRIX_SIZE	100
-#define DEF_OPS		8	/* the higher the number, the more CPU intensive */
-					/* (and therefore SMP performance goes up) */
+#define DEF_WORKING_SET	"l2"
+#define MAX_MATRIX_SIZE	128
+/* 2 * n^3 FLOPs on 3 * n^2 doubles, i.e. n / 12 FLOPs per byte */
+#define STREAM_MATRIX_SIZE	16
+#define BLOCK_SIZE	32
+#define DEF_FLOPS	(2 * 8 * 100 * 100 * 100)	/* 8 mults of 100x100 */
 #define PASS_CRITERIA	0.75	/* Avg concurrent time * pass criteria < avg seq time - */
 					/* for every addition of a cpu */
 #define ITERATIONS	128
 #define HIST_BUCKETS	100
 
-#define THREAD_WAIT	1
-#define THREAD_WORK	2
-#define THREAD_DONE	3
-
-#define THREAD_SLEEP	1 * NS_PER_US
-
-static int ops = DEF_OPS;
+static int ops;
 static int numcpus;
 static float criteria;
-static int *tids;
 static int online_cpu_id = -1;
 static int iterations = ITERATIONS;
 static int iterations_percpu;
+static char *working_set = DEF_WORKING_SET;
+static int msize;
+static int nsets;
 
 stats_container_t sdat, cdat, *curdat;
 stats_container_t shist, chist;
 static pthread_barrier_t mult_start;
 
 struct matrices {
-	double A[MATRIX_SIZE][MATRIX_SIZE];
-	double B[MATRIX_SIZE][MATRIX_SIZE];
-	double C[MATRIX_SIZE][MATRIX_SIZE];
+	double *A;
+	double *B;
+	double *C;
+};
+
+struct mult_thread {
+	int index;
+	int cur;
+	struct matrices *sets;
+	nsec_t start;
+	nsec_t end;
 };
 
+static struct mult_thread *threads;
+
 static void usage(void)
 {
 	rt_help();
@@ -58,6 +83,8 @@ static void usage(void)
 	printf
 	    ("  -l#	   #: number of multiplications per iteration (load)\n");
 	printf("  -i#	   #: number of iterations\n");
+	printf("  -wSET	   per thread working set: l1, l2, llc or dram (default %s)\n",
+	       DEF_WORKING_SET);
 }
 
 static int parse_args(int c, char *v)
@@ -70,6 +97,9 @@ static int parse_args(int c, char *v)
 	case 'l':
 		ops = atoi(v);
 		break;
+	case 'w':
+		working_set = v;
+		break;
 	case 'h':
 		usage();
 		exit(0);
@@ -80,42 +110,217 @@ static int parse_args(int c, char *v)
 	return handled;
 }
 
-static void matrix_init(double A[MATRIX_SIZE][MATRIX_SIZE],
-		 double B[MATRIX_SIZE][MATRIX_SIZE])
+/*
+ * Returns the size of the level (1, 2 or 3) data or unified cache of CPU 0
+ * in bytes, 0 if it's not known.
+ */
+static long cache_size(int level)
+{
+	char path[128], type[32];
+	long size, ret = 0;
+	int i, lvl;
+	char unit;
+	FILE *f;
+
+	for (i = 0; i < 10 && !ret; i++) {
+		snprintf(path, sizeof(path),
+			 "/sys/devices/system/cpu/cpu0/cache/index%d/level", i);
+		f = fopen(path, "r");
+		if (!f)
+			break;
+		if (fscanf(f, "%d", &lvl) != 1)
+			lvl = -1;
+		fclose(f);
+
+		if (lvl != level)
+			continue;
+
+		snprintf(path, sizeof(path),
+			 "/sys/devices/system/cpu/cpu0/cache/index%d/type", i);
+		f = fopen(path, "r");
+		if (!f)
+			continue;
+		if (fscanf(f, "%31s", type) != 1)
+			type[0] = 0;
+		fclose(f);
+
+		if (!strcmp(type, "Instruction"))
+			continue;
+
+		snprintf(path, sizeof(path),
+			 "/sys/devices/system/cpu/cpu0/cache/index%d/size", i);
+		f = fopen(path, "r");
+		if (!f)
+			continue;
+		switch (fscanf(f, "%ld%c", &size, &unit)) {
+		case 2:
+			if (unit == 'K')
+				size *= 1024;
+			else if (unit == 'M')
+				size *= 1024 * 1024;
+			/* fallthrough */
+		case 1:
+			ret = size;
+			break;
+		}
+		fclose(f);
+	}
+
+	return ret;
+}
+
+/*
+ * Chooses the matrix size and the number of matrix sets per thread so that
+ * the data of one thread is about the requested working set.
+ */
+static void setup_working_set(void)
+{
+	long l1 = cache_size(1), l2 = cache_size(2), llc = cache_size(3);
+	long bytes, set_bytes, mem;
+	int stream = 1;
+
+	if (!l1)
+		l1 = 32 * 1024;
+	if (!l2)
+		l2 = 1024 * 1024;
+	if (!llc)
+		llc = l2;
+
+	printf("Caches: L1d %ld KiB, L2 %ld KiB, LLC %ld KiB\n",
+	       l1 / 1024, l2 / 1024, llc / 1024);
+
+	if (!strcmp(working_set, "l1")) {
+		bytes = l1 / 2;
+		stream = 0;
+	} else if (!strcmp(working_set, "l2")) {
+		bytes = l2 / 2;
+		stream = 0;
+	} else if (!strcmp(working_set, "llc")) {
+		/* all threads together should fit into the LLC */
+		bytes = MAX(llc / 2 / numcpus, 2 * l2);
+	} else if (!strcmp(working_set, "dram")) {
+		bytes = 4 * llc;
+		/* but stay within a quarter of the memory */
+		mem = sysconf(_SC_PHYS_PAGES) / 4 / numcpus;
+		mem *= sysconf(_SC_PAGESIZE);
+		if (mem > 0 && bytes > mem)
+			bytes = MAX(mem, 2 * l2);
+	} else {
+		fprintf(stderr, "Invalid working set '%s'\n", working_set);
+		exit(1);
+	}
+
+	msize = sqrt(bytes / (3 * sizeof(double)));
+	msize = MIN(msize, stream ? STREAM_MATRIX_SIZE : MAX_MATRIX_SIZE);
+	if (msize > 8)
+		msize &= ~7;
+	msize = MAX(msize, 4);
+
+	set_bytes = 3 * sizeof(double) * msize * msize;
+	nsets = MAX(bytes / set_bytes, 1);
+
+	/* keep the work per iteration at about the same number of FLOPs */
+	if (!ops)
+		ops = MAX(DEF_FLOPS / (2L * msize * msize * msize), 1);
+
+	printf("Working set: %s, %d set(s) of %dx%d matrices, %ld KiB per thread, %.2f FLOPs/byte\n",
+	       working_set, nsets, msize, msize, nsets * set_bytes / 1024,
+	       msize / 12.0);
+}
+
+static void matrix_init(struct matrices *m)
 {
 	int i, j;
-	for (i = 0; i < MATRIX_SIZE; i++) {
-		for (j = 0; j < MATRIX_SIZE; j++) {
-			A[i][j] = (double)(i * j);
-			B[i][j] = (double)((i * j) % 10);
+
+	for (i = 0; i < msize; i++) {
+		for (j = 0; j < msize; j++) {
+			m->A[i * msize + j] = (double)(i * j);
+			m->B[i * msize + j] = (double)((i * j) % 10);
+		}
+	}
+}
+
+static struct matrices *matrices_alloc(void)
+{
+	struct matrices *sets = calloc(nsets, sizeof(*sets));
+	size_t size = msize * msize * sizeof(double);
+	int i;
+
+	if (!sets) {
+		perror("calloc");
+		exit(1);
+	}
+
+	for (i = 0; i < nsets; i++) {
+		if (posix_memalign((void **)&sets[i].A, 64, size) ||
+		    posix_memalign((void **)&sets[i].B, 64, size) ||
+		    posix_memalign((void **)&sets[i].C, 64, size)) {
+			fprintf(stderr, "Cannot allocate matrices\n");
+			exit(1);
 		}
+		matrix_init(&sets[i]);
 	}
+
+	return sets;
 }
 
+static void matrices_free(struct matrices *sets)
+{
+	int i;
+
+	if (!sets)
+		return;
+
+	for (i = 0; i < nsets; i++) {
+		free(sets[i].A);
+		free(sets[i].B);
+		free(sets[i].C);
+	}
+
+	free(sets);
+}
+
+/*
+ * C = A * B, blocked so that the rows of B and C used by the inner loops
+ * stay in L1. The innermost loop walks B and C with unit stride and is
+ * vectorized by the compiler.
+ */
 static void matrix_mult(struct matrices *matrices)
 {
-	int i, j, k;
-
-	matrix_init(matrices->A, matrices->B);
-	for (i = 0; i < MATRIX_SIZE; i++) {
-		int i_m = MATRIX_SIZE - i - 1;
-		for (j = 0; j < MATRIX_SIZE; j++) {
-			double sum = matrices->A[i_m][j] *  matrices->B[j][i];
-			for (k = 0; k < MATRIX_SIZE; k++)
-				sum +=  matrices->A[i_m][k] *  matrices->B[k][j];
-			 matrices->C[i][j] = sum;
+	const double *restrict A = matrices->A;
+	const double *restrict B = matrices->B;
+	double *restrict C = matrices->C;
+	int n = msize;
+	int i, j, k, kk, jj, kend, jend;
+
+	memset(C, 0, n * n * sizeof(double));
+
+	for (kk = 0; kk < n; kk += BLOCK_SIZE) {
+		kend = MIN(kk + BLOCK_SIZE, n);
+		for (jj = 0; jj < n; jj += BLOCK_SIZE) {
+			jend = MIN(jj + BLOCK_SIZE, n);
+			for (i = 0; i < n; i++) {
+				for (k = kk; k < kend; k++) {
+					double a = A[i * n + k];
+
+					for (j = jj; j < jend; j++)
+						C[i * n + j] += a * B[k * n + j];
+				}
+			}
 		}
 	}
 }
 
-static void matrix_mult_record(struct matrices *matrices, int index)
+static void matrix_mult_record(struct mult_thread *t, int index)
 {
 	nsec_t start, end, delta;
 	int i;
 
 	start = rt_gettime();
-	for (i = 0; i < ops; i++)
-		matrix_mult(matrices);
+	for (i = 0; i < ops; i++) {
+		matrix_mult(&t->sets[t->cur]);
+		t->cur = (t->cur + 1) % nsets;
+	}
 	end = rt_gettime();
 	delta = (long)((end - start) / NS_PER_US);
 	curdat->records[index].x = index;
@@ -147,70 +352,115 @@ static int set_affinity(void)
 static void *concurrent_thread(void *thread)
 {
 	struct thread *t = (struct thread *)thread;
-	struct matrices *matrices = (struct matrices *) t->arg;
-	int thread_id = (intptr_t) t->id;
+	struct mult_thread *mt = (struct mult_thread *) t->arg;
 	int cpuid;
 	int i;
 	int index;
 
 	cpuid = set_affinity();
 	if (cpuid == -1) {
-		fprintf(stderr, "Thread %d: Can't set affinity.\n", thread_id);
+		fprintf(stderr, "Thread %d: Can't set affinity.\n", mt->index);
 		exit(1);
 	}
 
-	index = iterations_percpu * thread_id;	/* To avoid stats overlapping */
+	/* first touch the matrices on the CPU that uses them */
+	if (!mt->sets)
+		mt->sets = matrices_alloc();
+
+	index = iterations_percpu * mt->index;	/* To avoid stats overlapping */
 	pthread_barrier_wait(&mult_start);
+	mt->start = rt_gettime();
 	for (i = 0; i < iterations_percpu; i++)
-		matrix_mult_record(matrices, index++);
+		matrix_mult_record(mt, index++);
+	mt->end = rt_gettime();
 
 	return NULL;
 }
 
+/*
+ * Runs the iterations split between nthreads threads and returns the average
+ * wall clock time per iteration in us.
+ */
+static float run_concurrent(int nthreads)
+{
+	nsec_t start = ULL_MAX, end = 0;
+	int j;
+
+	iterations_percpu = (iterations + nthreads - 1) / nthreads;
+
+	pthread_barrier_init(&mult_start, NULL, nthreads + 1);
+	curdat->index = iterations_percpu * nthreads - 1;
+	online_cpu_id = -1;	/* Redispatch cpus */
+	for (j = 0; j < nthreads; j++) {
+		if (create_fifo_thread(concurrent_thread, &threads[j], PRIO) == -1) {
+			printf
+			    ("Thread creation failed (max threads exceeded?)\n");
+			exit(1);
+		}
+	}
+
+	pthread_barrier_wait(&mult_start);
+	join_threads();
+	pthread_barrier_destroy(&mult_start);
+
+	/*
+	 * The threads take their own timestamps, the main thread may not get
+	 * to run before they are done.
+	 */
+	for (j = 0; j < nthreads; j++) {
+		start = MIN(start, threads[j].start);
+		end = MAX(end, threads[j].end);
+	}
+
+	return (float)((end - start) / NS_PER_US) / (iterations_percpu * nthreads);
+}
+
 static int main_thread(void)
 {
-	int ret, i, j;
+	int ret, i, n;
 	nsec_t start, end;
 	long smin = 0, smax = 0, cmin = 0, cmax = 0, delta = 0;
 	float savg, cavg;
 	int cpuid;
-	struct matrices *matrices[numcpus];
+
+	threads = calloc(numcpus, sizeof(*threads));
+	if (!threads) {
+		perror("malloc");
+		exit(1);
+	}
 
 	for (i = 0; i < numcpus; ++i)
-		matrices[i] = malloc(sizeof(struct matrices));
+		threads[i].index = i;
 
 	if (stats_container_init(&sdat, iterations) ||
 	    stats_container_init(&shist, HIST_BUCKETS) ||
-	    stats_container_init(&cdat, iterations) ||
+	    stats_container_init(&cdat, iterations + numcpus) ||
 	    stats_container_init(&chist, HIST_BUCKETS)
 	    ) {
 		fprintf(stderr, "Cannot init stats container\n");
 		exit(1);
 	}
 
-	tids = calloc(numcpus, sizeof(int));
-	if (!tids) {
-		perror("malloc");
-		exit(1);
-	}
-
 	cpuid = set_affinity();
 	if (cpuid == -1) {
 		fprintf(stderr, "Main thread: Can't set affinity.\n");
 		exit(1);
 	}
 
+	/* the first concurrent thread runs on the same CPU */
+	threads[0].sets = matrices_alloc();
+
 	/* run matrix mult operation sequentially */
 	curdat = &sdat;
 	curdat->index = iterations - 1;
 	printf("\nRunning sequential operations\n");
 	start = rt_gettime();
 	for (i = 0; i < iterations; i++)
-		matrix_mult_record(matrices[0], i);
+		matrix_mult_record(&threads[0], i);
 	end = rt_gettime();
 	delta = (long)((end - start) / NS_PER_US);
 
-	savg = delta / iterations;	/* don't use the stats record, use the total time recorded */
+	savg = (float)delta / iterations;	/* don't use the stats record, use the total time recorded */
 	smin = stats_min(&sdat);
 	smax = stats_max(&sdat);
 
@@ -231,34 +481,25 @@ static int main_thread(void)
 			"Warning: could not save sequential mults stats\n");
 	}
 
-	pthread_barrier_init(&mult_start, NULL, numcpus + 1);
 	set_priority(PRIO);
 	curdat = &cdat;
-	curdat->index = iterations - 1;
-	online_cpu_id = -1;	/* Redispatch cpus */
-	/* Create numcpus-1 concurrent threads */
-	for (j = 0; j < numcpus; j++) {
-		tids[j] = create_fifo_thread(concurrent_thread, matrices[j], PRIO);
-		if (tids[j] == -1) {
-			printf
-			    ("Thread creation failed (max threads exceeded?)\n");
-			exit(1);
-		}
-	}
 
-	/* run matrix mult operation concurrently */
+	/* scaling curve, the last run is on all CPUs */
 	printf("\nRunning concurrent operations\n");
-	pthread_barrier_wait(&mult_start);
-	start = rt_gettime();
-	join_threads();
-	end = rt_gettime();
-
-	delta = (long)((end - start) / NS_PER_US);
+	printf("Threads   Avg (us)   Speedup   Efficiency\n");
+	for (n = 1; ; n = MIN(n * 2, numcpus)) {
+		cavg = run_concurrent(n);
+		printf("%7d %10.2f %9.2f %11.2f\n", n, cavg, savg / cavg,
+		       savg / cavg / n);
+
+		if (n == numcpus)
+			break;
+	}
 
-	cavg = delta / iterations;	/* don't use the stats record, use the total time recorded */
 	cmin = stats_min(&cdat);
 	cmax = stats_max(&cdat);
 
+	printf("\nConcurrent operations on %d CPUs\n", numcpus);
 	printf("Min: %ld us\n", cmin);
 	printf("Max: %ld us\n", cmax);
 	printf("Avg: %.4f us\n", cavg);
@@ -291,20 +532,30 @@ static int main_thread(void)
 	printf("Result: %s\n", ret ? "FAIL" : "PASS");
 
 	for (i = 0; i < numcpus; i++)
-		free(matrices[i]);
+		matrices_free(threads[i].sets);
+	free(threads);
 
 	return ret;
 }
 
 int main(int argc, char *argv[])
 {
+	cpu_set_t mask;
+	int ret;
+
 	setup();
 	pass_criteria = PASS_CRITERIA;
-	rt_init("l:i:h", parse_args, argc, argv);
-	numcpus = sysconf(_SC_NPROCESSORS_ONLN);
+	rt_init("l:i:w:h", parse_args, argc, argv);
+
+	/* only count the CPUs we are allowed to run on */
+	if (sched_getaffinity(0, sizeof(mask), &mask)) {
+		perror("sched_getaffinity");
+		exit(1);
+	}
+	numcpus = CPU_COUNT(&mask);
+
 	/* the minimum avg concurrent multiplier to pass */
 	criteria = pass_criteria * numcpus;
-	int new_iterations, ret;
 
 	if (iterations <= 0) {
 		fprintf(stderr, "iterations must be greater than zero\n");
@@ -315,20 +566,10 @@ int main(int argc, char *argv[])
 	printf("Matrix Multiplication (SMP Performance)\n");
 	printf("---------------------------------------\n\n");
 
-	/* Line below rounds up iterations to a multiple of numcpus.
-	 * Without this, having iterations not a mutiple of numcpus causes
-	 * stats to segfault (overflow stats array).
-	 */
-	new_iterations = (int)((iterations + numcpus - 1) / numcpus) * numcpus;
-	if (new_iterations != iterations)
-		printf
-		    ("Rounding up iterations value to nearest multiple of total online CPUs\n");
-
-	iterations = new_iterations;
-	iterations_percpu = iterations / numcpus;
+	setup_working_set();
 
 	printf("Running %d iterations\n", iterations);
-	printf("Matrix Dimensions: %dx%d\n", MATRIX_SIZE, MATRIX_SIZE);
+	printf("Matrix Dimensions: %dx%d\n", msize, msize);
 	printf("Calculations per iteration: %d\n", ops);
 	printf("Number of CPUs: %u\n", numcpus);
 
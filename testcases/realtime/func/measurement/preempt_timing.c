@@ -57,6 +57,8 @@
 
 #define ITERATIONS 1000000ULL
 #define INTERVALS 10
+/* report deltas longer than this */
+#define REPORT_NS 30000
 
 void usage(void)
 {
@@ -82,15 +84,17 @@ int parse_args(int c, char *v)
 unsigned long long sample_list[ITERATIONS];
 int main(int argc, char *argv[])
 {
-	unsigned long long i, j, delta, min, max, avg;
+	unsigned long long i, j, delta, min, max, avg, report;
 	struct sched_param param;
+	struct tst_tsc tsc;
 	cpu_set_t mask;
 	int err;
 
-#ifdef TSC_UNSUPPORTED
-	printf("Error: test cannot be executed on an arch wihout TSC.\n");
-	return ENOTSUP;
-#endif
+	if (tst_tsc_calibrate(&tsc)) {
+		printf("Error: test cannot be executed without a constant rate cycle counter.\n");
+		return ENOTSUP;
+	}
+	report = REPORT_NS * tsc.ticks_per_ns;
 
 	max = avg = 0;
 	min = -1;
@@ -138,10 +142,10 @@ int main(int argc, char *argv[])
 				min = delta;
 			if (delta > max)
 				max = delta;
-			if (delta > 100000)
-				printf("maxd(%llu:%llu): %llu %llu = %llu\n", j,
+			if (delta > report)
+				printf("maxd(%llu:%llu): %llu %llu = %.0f ns\n", j,
 				       i, sample_list[i], sample_list[i + 1],
-				       delta);
+				       tst_tsc_to_ns(&tsc, delta));
 			avg += delta;
 		}
 		usleep(100);	/*let necessary things happen */
@@ -150,10 +154,12 @@ int main(int argc, char *argv[])
 
 	printf("%lld pairs of gettimeofday() calls completed\n",
 	       ITERATIONS * INTERVALS);
+	printf("Cycle counter: %.3f ticks/ns, read %.1f ns\n",
+	       tsc.ticks_per_ns, tsc.read_ns);
 	printf("Time between calls:\n");
-	printf("Minimum: %llu \n", min);
-	printf("Maximum: %llu \n", max);
-	printf("Average: %llu \n", avg);
+	printf("Minimum: %.1f ns\n", tst_tsc_to_ns(&tsc, min));
+	printf("Maximum: %.1f ns\n", tst_tsc_to_ns(&tsc, max));
+	printf("Average: %.1f ns\n", tst_tsc_to_ns(&tsc, avg));
 
 	return 0;
 }
@@ -71,43 +71,18 @@ int parse_args(int c, char *v)
 	return handled;
 }
 
-/* return difference in nanoseconds */
-unsigned long long tv_minus(struct timeval *tv_start, struct timeval *tv_end)
-{
-	unsigned long long nsecs;
-	nsecs = (tv_end->tv_sec - tv_start->tv_sec) * 1000000000ULL;
-	nsecs += (tv_end->tv_usec - tv_start->tv_usec) * 1000;
-	return nsecs;
-}
-
-/* calculate the tsc period */
-unsigned long long tsc_period_ps(void)
-{
-	struct timeval tv_start;
-	struct timeval tv_end;
-	unsigned long long tsc_start, tsc_end;
-
-	rdtscll(tsc_start);
-	gettimeofday(&tv_start, NULL);
-	sleep(1);
-	rdtscll(tsc_end);
-	gettimeofday(&tv_end, NULL);
-
-	return (1000 * tv_minus(&tv_start, &tv_end)) / tsc_minus(tsc_start,
-								 tsc_end);
-}
-
 int main(int argc, char *argv[])
 {
 	int i, err;
 	unsigned long long deltas[ITERATIONS];
-	unsigned long long max, min, avg, tsc_a, tsc_b, tsc_period;
+	unsigned long long max, min, avg, tsc_a, tsc_b;
+	struct tst_tsc tsc;
 	struct sched_param param;
 
-#ifdef TSC_UNSUPPORTED
-	printf("Error: test cannot be executed on an arch wihout TSC.\n");
-	return ENOTSUP;
-#endif
+	if (tst_tsc_calibrate(&tsc)) {
+		printf("Error: test cannot be executed without a constant rate cycle counter.\n");
+		return ENOTSUP;
+	}
 
 	setup();
 
@@ -138,15 +113,12 @@ int main(int argc, char *argv[])
 		exit(1);
 	}
 
-	/* calculate the tsc period in picoseconds */
-	tsc_period = tsc_period_ps();
-
 	/* collect ITERATIONS pairs of gtod calls */
 	max = min = avg = 0;
 	for (i = 0; i < ITERATIONS; i++) {
 		rdtscll(tsc_a);
 		rdtscll(tsc_b);
-		deltas[i] = (tsc_minus(tsc_a, tsc_b) * tsc_period) / 1000;	/* tsc period is in ps */
+		deltas[i] = tst_tsc_to_ns(&tsc, tsc_minus(tsc_a, tsc_b));
 		if (i == 0 || deltas[i] < min)
 			min = deltas[i];
 		if (deltas[i] > max)
@@ -156,7 +128,8 @@ int main(int argc, char *argv[])
 	avg /= ITERATIONS;
 
 	/* report on deltas */
-	printf("Calculated tsc period = %llu ps\n", tsc_period);
+	printf("Cycle counter: %.3f ticks/ns, read %.1f ns\n",
+	       tsc.ticks_per_ns, tsc.read_ns);
 	printf("%d pairs of rdtsc() calls completed\n", ITERATIONS);
 	printf("Time between calls:\n");
 	printf("     Max: %llu ns\n", max);
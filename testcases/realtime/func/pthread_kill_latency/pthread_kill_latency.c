@@ -142,7 +142,7 @@ void *signal_receiving_thread(void *arg)
 	debug(DBG_DEBUG, "Signal receiving thread ready to receive\n");
 
 	if (latency_threshold) {
-		latency_trace_enable();
+		latency_trace_enable(latency_threshold);
 		latency_trace_start();
 	}
 
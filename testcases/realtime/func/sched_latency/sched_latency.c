@@ -134,7 +134,7 @@ void *periodic_thread(void *arg)
 	debug(DBG_INFO, "--------- --------- ------------- --------\n");
 
 	if (latency_threshold) {
-		latency_trace_enable();
+		latency_trace_enable(latency_threshold);
 		latency_trace_start();
 	}
 	for (i = 0; i < iterations; i++) {
@@ -0,0 +1,146 @@
+/******************************************************************************
+ *
+ *   Copyright (c) Linux Test Project, 2026
+ *
+ *   This program is free software;  you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY;  without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ *   the GNU General Public License for more details.
+ *
+ * NAME
+ *       librtcyclic.h
+ *
+ * DESCRIPTION
+ *      Periodic (cyclictest style) wakeup latency measurement engine. One
+ *      SCHED_FIFO thread per CPU wakes up every period and records the
+ *      difference between the expected and the actual wakeup time into its
+ *      own histogram, the histograms are merged once all threads finished.
+ *
+ * USAGE:
+ *       struct rt_cyclic_params params = RT_CYCLIC_DEFAULTS;
+ *       struct rt_cyclic_result res;
+ *
+ *       params.loops = 10000;
+ *       if (rt_cyclic_run(&params, &res))
+ *               exit(1);
+ *       rt_cyclic_print(&res);
+ *       ... res.total.max ...
+ *       rt_cyclic_free(&res);
+ *
+ *****************************************************************************/
+
+#ifndef LIBRTCYCLIC_H
+#define LIBRTCYCLIC_H
+
+#include "librttest.h"
+
+enum rt_cyclic_clock {
+	/* clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME) */
+	RT_CYCLIC_ABSTIME,
+	/* relative clock_nanosleep() to the next period */
+	RT_CYCLIC_NANOSLEEP,
+	/* periodic CLOCK_MONOTONIC timerfd */
+	RT_CYCLIC_TIMERFD,
+};
+
+struct rt_cyclic_params {
+	/* wakeup period */
+	nsec_t period;
+	/* delay between the first wakeups of subsequent threads */
+	nsec_t distance;
+	/* number of periods per thread, 0 means run for duration */
+	unsigned long loops;
+	nsec_t duration;
+	/* SCHED_FIFO priority of the measurement threads */
+	int prio;
+	enum rt_cyclic_clock clock;
+	/* number of CPUs to measure on, 0 means all CPUs we may run on */
+	int nr_cpus;
+	/* lock the memory with mlockall() */
+	int mlock;
+	/* size of the prefaulted measurement thread stacks */
+	size_t stack_size;
+	/* number of 1us histogram buckets, higher latencies are overflows */
+	unsigned int hist_size;
+	/* stop all threads and freeze the latency trace above this, 0 off */
+	unsigned long long trace_threshold_us;
+	/* optional work done after each wakeup (e.g. periodic load) */
+	void (*work)(int cpu, unsigned long loop, void *arg);
+	void *work_arg;
+};
+
+#define RT_CYCLIC_DEFAULTS {			\
+	.period = NS_PER_MS,			\
+	.distance = 500 * NS_PER_US,		\
+	.duration = 10ULL * NS_PER_SEC,		\
+	.prio = 80,				\
+	.clock = RT_CYCLIC_ABSTIME,		\
+	.mlock = 1,				\
+	.stack_size = 256 * 1024,		\
+	.hist_size = 1000,			\
+}
+
+struct rt_cyclic_stats {
+	int cpu;
+	pid_t tid;
+	unsigned long cycles;
+	/* wakeups later than a whole period */
+	unsigned long missed;
+	/* latencies above the histogram range */
+	unsigned long overflows;
+	nsec_t min;
+	nsec_t max;
+	nsec_t sum;
+	unsigned long *hist;
+};
+
+struct rt_cyclic_result {
+	int nr_threads;
+	unsigned int hist_size;
+	/* set if the trace threshold was exceeded */
+	int threshold_hit;
+	int threshold_cpu;
+	nsec_t threshold_latency;
+	struct rt_cyclic_stats *threads;
+	/* all threads merged, cpu is -1 */
+	struct rt_cyclic_stats total;
+};
+
+/* rt_cyclic_clock_parse: convert "abstime", "nanosleep" or "timerfd" to the
+ * clock, returns -1 for unknown names
+ */
+int rt_cyclic_clock_parse(const char *name);
+
+/* rt_cyclic_run: run the measurement threads and wait for them to finish
+ * params: measurement parameters, see RT_CYCLIC_DEFAULTS
+ * res: filled with per thread and merged statistics, free with
+ *      rt_cyclic_free()
+ * Returns 0 on success, -1 if the measurement could not be started
+ */
+int rt_cyclic_run(const struct rt_cyclic_params *params,
+		  struct rt_cyclic_result *res);
+
+/* rt_cyclic_percentile: latency in ns below which pct percent of the merged
+ * samples lie, with 1us granularity, ULL_MAX if it is in the overflows
+ */
+nsec_t rt_cyclic_percentile(const struct rt_cyclic_result *res, double pct);
+
+/* rt_cyclic_print: print per thread lines and the merged summary
+ */
+void rt_cyclic_print(const struct rt_cyclic_result *res);
+
+/* rt_cyclic_hist_save: save the merged histogram as filename.dat and a
+ * gnuplot script filename.plt if stats saving (-s) is enabled
+ */
+void rt_cyclic_hist_save(const struct rt_cyclic_result *res, char *filename);
+
+/* rt_cyclic_free: free the result
+ */
+void rt_cyclic_free(struct rt_cyclic_result *res);
+
+#endif /* LIBRTCYCLIC_H */
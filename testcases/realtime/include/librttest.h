@@ -324,9 +324,11 @@ void *busy_work_us(int us);
  */
 void init_pi_mutex(pthread_mutex_t *m);
 
-/* latency_trace_enable: Enable latency tracing via sysctls.
+/* latency_trace_enable: Arm tracefs based latency tracing, see librttest.c.
+ * threshold_us: latency budget of the test, used by RT_TRACER=timerlat and
+ *               RT_TRACER=osnoise to stop tracing from the kernel
  */
-void latency_trace_enable(void);
+void latency_trace_enable(unsigned long long threshold_us);
 
 /* latency_trace_start: Start tracing latency; call before running test.
  */
@@ -337,8 +339,7 @@ void latency_trace_start(void);
  */
 void latency_trace_stop(void);
 
-/* latency_trace_print: Print latency trace information from
- * /proc/latency_trace.
+/* latency_trace_print: Print the trace captured before latency_trace_stop().
  */
 void latency_trace_print(void);
 
@@ -0,0 +1,543 @@
+/******************************************************************************
+ *
+ *   Copyright (c) Linux Test Project, 2026
+ *
+ *   This program is free software;  you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY;  without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ *   the GNU General Public License for more details.
+ *
+ * NAME
+ *       librtcyclic.c
+ *
+ * DESCRIPTION
+ *      Periodic wakeup latency measurement engine, see librtcyclic.h.
+ *
+ *      Each measurement thread owns its statistics and histogram, which are
+ *      allocated and prefaulted before the thread starts, so the hot loop
+ *      does neither take locks nor fault pages. The thread stacks are
+ *      allocated and touched by the engine as well.
+ *
+ *****************************************************************************/
+
+#include "librtcyclic.h"
+#include "libstats.h"
+
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+
+struct cyclic_thread {
+	const struct rt_cyclic_params *params;
+	struct rt_cyclic_stats *stats;
+	struct rt_cyclic_result *res;
+	pthread_t pthread;
+	void *stack;
+	nsec_t start;
+	int started;
+} __attribute__((aligned(64)));
+
+static volatile int cyclic_stop;
+static atomic_t threshold_hit;
+
+int rt_cyclic_clock_parse(const char *name)
+{
+	if (!strcmp(name, "abstime"))
+		return RT_CYCLIC_ABSTIME;
+
+	if (!strcmp(name, "nanosleep"))
+		return RT_CYCLIC_NANOSLEEP;
+
+	if (!strcmp(name, "timerfd"))
+		return RT_CYCLIC_TIMERFD;
+
+	return -1;
+}
+
+static const char *clock_name(enum rt_cyclic_clock clock)
+{
+	switch (clock) {
+	case RT_CYCLIC_ABSTIME:
+		return "clock_nanosleep(TIMER_ABSTIME)";
+	case RT_CYCLIC_NANOSLEEP:
+		return "clock_nanosleep()";
+	case RT_CYCLIC_TIMERFD:
+		return "timerfd";
+	}
+
+	return "?";
+}
+
+static inline void ns_to_ts(nsec_t ns, struct timespec *ts)
+{
+	ts->tv_sec = ns / NS_PER_SEC;
+	ts->tv_nsec = ns % NS_PER_SEC;
+}
+
+static inline void record(struct rt_cyclic_stats *st, unsigned int hist_size,
+			  nsec_t lat)
+{
+	unsigned long us = lat / NS_PER_US;
+
+	if (us < hist_size)
+		st->hist[us]++;
+	else
+		st->overflows++;
+
+	if (lat < st->min)
+		st->min = lat;
+
+	if (lat > st->max)
+		st->max = lat;
+
+	st->sum += lat;
+	st->cycles++;
+}
+
+static void threshold_exceeded(struct cyclic_thread *t, nsec_t lat)
+{
+	latency_trace_stop();
+	cyclic_stop = 1;
+
+	if (atomic_inc(&threshold_hit) != 1)
+		return;
+
+	t->res->threshold_hit = 1;
+	t->res->threshold_cpu = t->stats->cpu;
+	t->res->threshold_latency = lat;
+}
+
+static int pin_cpu(int cpu)
+{
+	cpu_set_t mask;
+
+	CPU_ZERO(&mask);
+	CPU_SET(cpu, &mask);
+
+	return sched_setaffinity(0, sizeof(mask), &mask);
+}
+
+static void *cyclic_thread_fn(void *arg)
+{
+	struct cyclic_thread *t = arg;
+	const struct rt_cyclic_params *p = t->params;
+	struct rt_cyclic_stats *st, local;
+	nsec_t next = t->start, now, lat;
+	nsec_t threshold = p->trace_threshold_us * NS_PER_US;
+	unsigned long loop = 0;
+	struct itimerspec its = {};
+	struct timespec ts;
+	uint64_t ticks;
+	int fd = -1;
+
+	t->stats->tid = syscall(SYS_gettid);
+
+	/*
+	 * The stats are updated on every wakeup, keep them on the stack of the
+	 * thread so that threads on neighbouring CPUs do not share cache lines
+	 * and copy them to the result once the loop is done.
+	 */
+	local = *t->stats;
+	st = &local;
+
+	if (pin_cpu(st->cpu)) {
+		printf("Failed to pin thread to CPU %d: %d (%s)\n", st->cpu,
+		       errno, strerror(errno));
+		cyclic_stop = 1;
+		return NULL;
+	}
+
+	if (p->clock == RT_CYCLIC_TIMERFD) {
+		fd = timerfd_create(CLOCK_MONOTONIC, 0);
+		if (fd < 0) {
+			perror("timerfd_create");
+			cyclic_stop = 1;
+			return NULL;
+		}
+
+		ns_to_ts(next, &its.it_value);
+		ns_to_ts(p->period, &its.it_interval);
+
+		if (timerfd_settime(fd, TFD_TIMER_ABSTIME, &its, NULL)) {
+			perror("timerfd_settime");
+			close(fd);
+			cyclic_stop = 1;
+			return NULL;
+		}
+	}
+
+	while (!cyclic_stop && (!p->loops || loop < p->loops)) {
+		ticks = 1;
+
+		switch (p->clock) {
+		case RT_CYCLIC_ABSTIME:
+			ns_to_ts(next, &ts);
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts,
+					NULL);
+			break;
+		case RT_CYCLIC_NANOSLEEP:
+			now = rt_gettime();
+			if (next > now) {
+				ns_to_ts(next - now, &ts);
+				clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, NULL);
+			}
+			break;
+		case RT_CYCLIC_TIMERFD:
+			if (read(fd, &ticks, sizeof(ticks)) != sizeof(ticks))
+				ticks = 1;
+			break;
+		}
+
+		now = rt_gettime();
+		lat = now > next ? now - next : 0;
+
+		record(st, p->hist_size, lat);
+
+		if (threshold && lat > threshold)
+			threshold_exceeded(t, lat);
+
+		if (p->work)
+			p->work(st->cpu, loop, p->work_arg);
+
+		next += p->period * ticks;
+		if (ticks > 1)
+			st->missed += ticks - 1;
+
+		/* Skip the periods we have already missed */
+		now = rt_gettime();
+		while (next < now) {
+			next += p->period;
+			st->missed++;
+		}
+
+		loop++;
+	}
+
+	*t->stats = local;
+
+	if (fd >= 0)
+		close(fd);
+
+	return NULL;
+}
+
+static int allowed_cpus(int *cpus, int max)
+{
+	cpu_set_t mask;
+	int cpu, n = 0;
+
+	if (sched_getaffinity(0, sizeof(mask), &mask)) {
+		perror("sched_getaffinity");
+		return -1;
+	}
+
+	for (cpu = 0; cpu < CPU_SETSIZE && n < max; cpu++) {
+		if (CPU_ISSET(cpu, &mask))
+			cpus[n++] = cpu;
+	}
+
+	return n;
+}
+
+static void *alloc_prefaulted(size_t size)
+{
+	void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (ptr == MAP_FAILED)
+		return NULL;
+
+	memset(ptr, 0, size);
+
+	return ptr;
+}
+
+static int start_thread(struct cyclic_thread *t)
+{
+	const struct rt_cyclic_params *p = t->params;
+	struct sched_param param = { .sched_priority = p->prio };
+	pthread_attr_t attr;
+	int ret;
+
+	t->stack = alloc_prefaulted(p->stack_size);
+	if (!t->stack) {
+		perror("mmap");
+		return -1;
+	}
+
+	pthread_attr_init(&attr);
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+	pthread_attr_setschedparam(&attr, &param);
+	pthread_attr_setstack(&attr, t->stack, p->stack_size);
+
+	ret = pthread_create(&t->pthread, &attr, cyclic_thread_fn, t);
+	pthread_attr_destroy(&attr);
+
+	if (ret) {
+		printf("Failed to create measurement thread: %d (%s)\n", ret,
+		       strerror(ret));
+		return -1;
+	}
+
+	t->started = 1;
+
+	return 0;
+}
+
+static void merge(struct rt_cyclic_result *res)
+{
+	struct rt_cyclic_stats *tot = &res->total;
+	int i;
+	unsigned int j;
+
+	tot->cpu = -1;
+	tot->min = ULL_MAX;
+
+	for (i = 0; i < res->nr_threads; i++) {
+		struct rt_cyclic_stats *st = &res->threads[i];
+
+		if (!st->cycles)
+			continue;
+
+		tot->cycles += st->cycles;
+		tot->missed += st->missed;
+		tot->overflows += st->overflows;
+		tot->sum += st->sum;
+		tot->min = MIN(tot->min, st->min);
+		tot->max = MAX(tot->max, st->max);
+
+		for (j = 0; j < res->hist_size; j++)
+			tot->hist[j] += st->hist[j];
+	}
+
+	if (!tot->cycles)
+		tot->min = 0;
+}
+
+int rt_cyclic_run(const struct rt_cyclic_params *params,
+		  struct rt_cyclic_result *res)
+{
+	struct cyclic_thread *threads;
+	int cpus[CPU_SETSIZE];
+	int i, n, ret = 0;
+	nsec_t start;
+
+	memset(res, 0, sizeof(*res));
+
+	if (!params->period || !params->hist_size ||
+	    params->stack_size < (size_t)PTHREAD_STACK_MIN) {
+		printf("Invalid measurement parameters\n");
+		return -1;
+	}
+
+	n = allowed_cpus(cpus, params->nr_cpus ? params->nr_cpus : CPU_SETSIZE);
+	if (n <= 0)
+		return -1;
+
+	if (params->mlock && mlockall(MCL_CURRENT | MCL_FUTURE))
+		perror("mlockall");
+
+	res->nr_threads = n;
+	res->hist_size = params->hist_size;
+	res->threads = calloc(n, sizeof(*res->threads));
+	res->total.hist = alloc_prefaulted(params->hist_size * sizeof(unsigned long));
+	threads = calloc(n, sizeof(*threads));
+
+	if (!res->threads || !res->total.hist || !threads) {
+		printf("Failed to allocate measurement data\n");
+		free(threads);
+		rt_cyclic_free(res);
+		return -1;
+	}
+
+	cyclic_stop = 0;
+	atomic_set(0, &threshold_hit);
+
+	if (params->trace_threshold_us) {
+		latency_trace_enable(params->trace_threshold_us);
+		latency_trace_start();
+	}
+
+	printf("Measuring on %d CPUs: %s, period %llu us, priority %d\n",
+	       n, clock_name(params->clock), params->period / NS_PER_US,
+	       params->prio);
+
+	/* give all the threads enough time to start */
+	start = rt_gettime() + 100 * NS_PER_MS;
+
+	for (i = 0; i < n; i++) {
+		struct rt_cyclic_stats *st = &res->threads[i];
+
+		st->cpu = cpus[i];
+		st->min = ULL_MAX;
+		st->hist = alloc_prefaulted(params->hist_size * sizeof(unsigned long));
+
+		threads[i].params = params;
+		threads[i].stats = st;
+		threads[i].res = res;
+		threads[i].start = start + i * params->distance;
+
+		if (!st->hist || start_thread(&threads[i])) {
+			ret = -1;
+			cyclic_stop = 1;
+			break;
+		}
+	}
+
+	if (!ret && !params->loops) {
+		nsec_t end = start + params->duration;
+
+		while (!cyclic_stop && rt_gettime() < end)
+			usleep(10000);
+
+		cyclic_stop = 1;
+	}
+
+	for (i = 0; i < n; i++) {
+		if (threads[i].started)
+			pthread_join(threads[i].pthread, NULL);
+
+		if (threads[i].stack)
+			munmap(threads[i].stack, params->stack_size);
+	}
+
+	free(threads);
+
+	if (params->trace_threshold_us) {
+		latency_trace_stop();
+
+		if (res->threshold_hit) {
+			printf("Latency threshold (%lluus) exceeded on CPU %d: %llu us\n",
+			       params->trace_threshold_us, res->threshold_cpu,
+			       res->threshold_latency / NS_PER_US);
+			latency_trace_print();
+		}
+	}
+
+	if (ret) {
+		rt_cyclic_free(res);
+		return ret;
+	}
+
+	merge(res);
+
+	return 0;
+}
+
+nsec_t rt_cyclic_percentile(const struct rt_cyclic_result *res, double pct)
+{
+	unsigned long long want, cnt = 0;
+	unsigned int i;
+
+	if (!res->total.cycles)
+		return 0;
+
+	want = res->total.cycles * pct / 100;
+	if (want >= res->total.cycles)
+		want = res->total.cycles - 1;
+
+	for (i = 0; i < res->hist_size; i++) {
+		cnt += res->total.hist[i];
+
+		if (cnt > want)
+			return (nsec_t)(i + 1) * NS_PER_US;
+	}
+
+	return ULL_MAX;
+}
+
+static void print_stats(const struct rt_cyclic_stats *st, const char *name)
+{
+	printf("%s C:%9lu Min:%7llu Avg:%7llu Max:%7llu Missed:%6lu Overflows:%6lu\n",
+	       name, st->cycles, st->min / NS_PER_US,
+	       st->cycles ? st->sum / st->cycles / NS_PER_US : 0,
+	       st->max / NS_PER_US, st->missed, st->overflows);
+}
+
+static void print_percentile(const struct rt_cyclic_result *res,
+			     const char *name, double pct)
+{
+	nsec_t val = rt_cyclic_percentile(res, pct);
+
+	if (val == ULL_MAX)
+		printf("  %-6s > %u us\n", name, res->hist_size);
+	else
+		printf("  %-6s <= %llu us\n", name, val / NS_PER_US);
+}
+
+void rt_cyclic_print(const struct rt_cyclic_result *res)
+{
+	char name[64];
+	int i;
+
+	for (i = 0; i < res->nr_threads; i++) {
+		const struct rt_cyclic_stats *st = &res->threads[i];
+
+		snprintf(name, sizeof(name), "T:%3d (%6d) CPU:%3d", i, st->tid,
+			 st->cpu);
+		print_stats(st, name);
+	}
+
+	print_stats(&res->total, "Total:            ");
+
+	printf("Latency percentiles:\n");
+	print_percentile(res, "50%", 50);
+	print_percentile(res, "90%", 90);
+	print_percentile(res, "99%", 99);
+	print_percentile(res, "99.9%", 99.9);
+	print_percentile(res, "99.99%", 99.99);
+}
+
+void rt_cyclic_hist_save(const struct rt_cyclic_result *res, char *filename)
+{
+	stats_container_t hist;
+	stats_record_t rec;
+	unsigned int i, last = 0;
+
+	if (!save_stats)
+		return;
+
+	for (i = 0; i < res->hist_size; i++) {
+		if (res->total.hist[i])
+			last = i;
+	}
+
+	if (stats_container_init(&hist, last + 1))
+		return;
+
+	for (i = 0; i <= last; i++) {
+		rec.x = i;
+		rec.y = res->total.hist[i];
+		stats_container_append(&hist, rec);
+	}
+
+	stats_container_save(filename, "Periodic Wakeup Latency Histogram",
+			     "Latency (us)", "Samples", &hist, "steps");
+	stats_container_free(&hist);
+}
+
+void rt_cyclic_free(struct rt_cyclic_result *res)
+{
+	size_t size = res->hist_size * sizeof(unsigned long);
+	int i;
+
+	if (res->threads) {
+		for (i = 0; i < res->nr_threads; i++) {
+			if (res->threads[i].hist)
+				munmap(res->threads[i].hist, size);
+		}
+
+		free(res->threads);
+	}
+
+	if (res->total.hist)
+		munmap(res->total.hist, size);
+
+	memset(res, 0, sizeof(*res));
+}
@@ -53,13 +53,14 @@
 #include <errno.h>
 #include <unistd.h>
 #include <getopt.h>
-#include <sys/prctl.h>
+#include <sys/mount.h>
 #include <sys/stat.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/mman.h>
 #include <fcntl.h>
 #include <math.h>
+#include <limits.h>
 
 static LIST_HEAD(_threads);
 static atomic_t _thread_count = { -1 };
@@ -634,32 +635,6 @@ static void write_or_complain(int fd, const void *data, size_t len)
 	}
 }
 
-/* Write the given data to the existing file specified by pathname.  Complain
- * if unable to do so. */
-static void write_file(const char *pathname, const void *data, size_t len)
-{
-	int fd = open(pathname, O_WRONLY);
-	if (fd < 0) {
-		printf("Failed to open file \"%s\": %d (%s)\n",
-		       pathname, errno, strerror(errno));
-		return;
-	}
-
-	write_or_complain(fd, data, len);
-
-	if (close(fd) < 0) {
-		printf("Failed to close file \"%s\": %d (%s)\n",
-		       pathname, errno, strerror(errno));
-	}
-}
-
-/* Write the given '\0'-terminated string to the existing file specified by
- * pathname.  Complain if unable to do so. */
-static void write_string_to_file(const char *pathname, const char *string)
-{
-	write_file(pathname, string, strlen(string));
-}
-
 static void read_and_print(const char *pathname, int output_fd)
 {
 	char data[4096];
@@ -691,51 +666,328 @@ static void read_and_print(const char *pathname, int output_fd)
 	}
 }
 
-void latency_trace_enable(void)
+/*
+ * Latency tracing is done through tracefs. By default the scheduler, irq,
+ * softirq and hrtimer events are recorded into the per-CPU ring buffers of a
+ * private trace instance, which works as a flight recorder: the buffers keep
+ * overwriting the oldest events and latency_trace_stop() freezes them right
+ * after the test observed a sample above its latency budget, so that the
+ * trace contains what happened on all CPUs just before.
+ *
+ * Setting RT_TRACER=timerlat or RT_TRACER=osnoise arms the respective tracer
+ * on the top level buffer instead, with the kernel stopping the trace once
+ * the tracer itself measures a latency (noise) above the threshold.
+ */
+#define TRACE_INSTANCE_FMT "instances/ltp_rt_%d"
+#define TRACE_BUFFER_KB "4096"
+
+static const char *const trace_events[] = {
+	"sched/sched_switch",
+	"sched/sched_wakeup",
+	"sched/sched_waking",
+	"sched/sched_migrate_task",
+	"irq/irq_handler_entry",
+	"irq/irq_handler_exit",
+	"irq/softirq_entry",
+	"irq/softirq_exit",
+	"timer/hrtimer_expire_entry",
+	"timer/hrtimer_expire_exit",
+	"irq_vectors/local_timer_entry",
+	"irq_vectors/local_timer_exit",
+	"osnoise",
+	NULL
+};
+
+static char tracefs_path[PATH_MAX];
+static char trace_dir[PATH_MAX + 32];
+static char saved_tracer[64];
+static char saved_tracing_on[8];
+static int tracefs_mounted;
+static int trace_instance;
+static int tracing_on_fd = -1;
+static int trace_marker_fd = -1;
+
+static int tracefs_write(const char *dir, const char *file, const char *val)
+{
+	char path[PATH_MAX + 256];
+	ssize_t len = strlen(val);
+	int fd, ret;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, file);
+
+	fd = open(path, O_WRONLY | O_TRUNC);
+	if (fd < 0)
+		return -1;
+
+	ret = write(fd, val, len) == len ? 0 : -1;
+	close(fd);
+
+	return ret;
+}
+
+static int tracefs_read(const char *dir, const char *file, char *buf,
+			size_t size)
+{
+	char path[PATH_MAX + 256];
+	ssize_t ret;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, file);
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	ret = read(fd, buf, size - 1);
+	close(fd);
+
+	if (ret < 0)
+		return -1;
+
+	buf[ret] = '\0';
+	if (ret && buf[ret - 1] == '\n')
+		buf[ret - 1] = '\0';
+
+	return 0;
+}
+
+static int tracefs_find(void)
+{
+	static const char *const paths[] = {
+		"/sys/kernel/tracing",
+		"/sys/kernel/debug/tracing",
+	};
+	char path[PATH_MAX];
+	unsigned int i;
+
+	for (i = 0; i < sizeof(paths) / sizeof(paths[0]); i++) {
+		snprintf(path, sizeof(path), "%s/trace", paths[i]);
+		if (!access(path, F_OK)) {
+			strcpy(tracefs_path, paths[i]);
+			return 0;
+		}
+	}
+
+	if (mount("nodev", paths[0], "tracefs", 0, NULL)) {
+		printf("Failed to mount tracefs: %d (%s)\n", errno,
+		       strerror(errno));
+		return -1;
+	}
+
+	tracefs_mounted = 1;
+	strcpy(tracefs_path, paths[0]);
+
+	return 0;
+}
+
+static int tracer_available(const char *tracer)
 {
-	printf("Enabling latency tracer.\n");
-	write_string_to_file("/proc/sys/kernel/trace_use_raw_cycles", "1");
-	write_string_to_file("/proc/sys/kernel/trace_all_cpus", "1");
-	write_string_to_file("/proc/sys/kernel/trace_enabled", "1");
-	write_string_to_file("/proc/sys/kernel/trace_freerunning", "1");
-	write_string_to_file("/proc/sys/kernel/trace_print_on_crash", "0");
-	write_string_to_file("/proc/sys/kernel/trace_user_triggered", "1");
-	write_string_to_file("/proc/sys/kernel/trace_user_trigger_irq", "-1");
-	write_string_to_file("/proc/sys/kernel/trace_verbose", "0");
-	write_string_to_file("/proc/sys/kernel/preempt_thresh", "0");
-	write_string_to_file("/proc/sys/kernel/wakeup_timing", "0");
-	write_string_to_file("/proc/sys/kernel/mcount_enabled", "1");
-	write_string_to_file("/proc/sys/kernel/preempt_max_latency", "0");
+	char buf[4096], *tok, *save;
+
+	if (tracefs_read(tracefs_path, "available_tracers", buf, sizeof(buf)))
+		return 0;
+
+	for (tok = strtok_r(buf, " ", &save); tok;
+	     tok = strtok_r(NULL, " ", &save)) {
+		if (!strcmp(tok, tracer))
+			return 1;
+	}
+
+	return 0;
 }
 
-#ifndef PR_SET_TRACING
-#define PR_SET_TRACING 0
-#endif
+static int arm_tracer(const char *tracer, unsigned long long threshold_us)
+{
+	char val[32];
+
+	if (!tracer_available(tracer)) {
+		printf("Tracer %s is not available\n", tracer);
+		return -1;
+	}
+
+	strcpy(trace_dir, tracefs_path);
+	tracefs_read(trace_dir, "current_tracer", saved_tracer,
+		     sizeof(saved_tracer));
+	if (tracefs_read(trace_dir, "tracing_on", saved_tracing_on,
+			 sizeof(saved_tracing_on)))
+		strcpy(saved_tracing_on, "1");
+
+	tracefs_write(trace_dir, "tracing_on", "0");
+	tracefs_write(trace_dir, "current_tracer", "nop");
+
+	if (threshold_us) {
+		snprintf(val, sizeof(val), "%llu", threshold_us);
+
+		if (!strcmp(tracer, "timerlat")) {
+			tracefs_write(trace_dir, "osnoise/stop_tracing_total_us", val);
+			tracefs_write(trace_dir, "osnoise/print_stack", val);
+		} else {
+			tracefs_write(trace_dir, "osnoise/stop_tracing_us", val);
+		}
+	}
+
+	if (tracefs_write(trace_dir, "current_tracer", tracer)) {
+		printf("Failed to set tracer %s: %d (%s)\n", tracer, errno,
+		       strerror(errno));
+		return -1;
+	}
+
+	tracefs_write(trace_dir, "tracing_on", "0");
+
+	return 0;
+}
+
+static int arm_events(void)
+{
+	char path[PATH_MAX + 256];
+	int i, enabled = 0;
+
+	snprintf(trace_dir, sizeof(trace_dir), "%s/" TRACE_INSTANCE_FMT,
+		 tracefs_path, getpid());
+
+	if (mkdir(trace_dir, 0700)) {
+		printf("Failed to create trace instance %s: %d (%s)\n",
+		       trace_dir, errno, strerror(errno));
+		return -1;
+	}
+
+	trace_instance = 1;
+	tracefs_write(trace_dir, "tracing_on", "0");
+
+	for (i = 0; trace_events[i]; i++) {
+		snprintf(path, sizeof(path), "events/%s/enable", trace_events[i]);
+
+		if (!tracefs_write(trace_dir, path, "1"))
+			enabled++;
+	}
+
+	if (!enabled) {
+		printf("No trace events available\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static void latency_trace_restore(void)
+{
+	if (tracing_on_fd >= 0) {
+		close(tracing_on_fd);
+		tracing_on_fd = -1;
+	}
+
+	if (trace_marker_fd >= 0) {
+		close(trace_marker_fd);
+		trace_marker_fd = -1;
+	}
+
+	if (trace_instance) {
+		tracefs_write(trace_dir, "tracing_on", "0");
+		if (rmdir(trace_dir)) {
+			printf("Failed to remove trace instance %s: %d (%s)\n",
+			       trace_dir, errno, strerror(errno));
+		}
+		trace_instance = 0;
+	} else if (saved_tracer[0]) {
+		tracefs_write(trace_dir, "tracing_on", "0");
+		tracefs_write(trace_dir, "osnoise/stop_tracing_total_us", "0");
+		tracefs_write(trace_dir, "osnoise/stop_tracing_us", "0");
+		tracefs_write(trace_dir, "osnoise/print_stack", "0");
+		tracefs_write(trace_dir, "current_tracer", saved_tracer);
+		tracefs_write(trace_dir, "tracing_on", saved_tracing_on);
+		saved_tracer[0] = '\0';
+	}
+
+	trace_dir[0] = '\0';
+
+	if (tracefs_mounted) {
+		umount2(tracefs_path, MNT_DETACH);
+		tracefs_mounted = 0;
+	}
+}
+
+void latency_trace_enable(unsigned long long threshold_us)
+{
+	const char *tracer = getenv("RT_TRACER");
+	char path[PATH_MAX + 128];
+	int ret;
+
+	if (trace_dir[0])
+		return;
+
+	if (tracefs_find())
+		return;
+
+	if (tracer && strcmp(tracer, "events"))
+		ret = arm_tracer(tracer, threshold_us);
+	else
+		ret = arm_events();
+
+	atexit(latency_trace_restore);
+
+	if (ret) {
+		printf("Latency tracing disabled\n");
+		latency_trace_restore();
+		return;
+	}
+
+	tracefs_write(trace_dir, "buffer_size_kb", TRACE_BUFFER_KB);
+	tracefs_write(trace_dir, "trace", "");
+
+	snprintf(path, sizeof(path), "%s/tracing_on", trace_dir);
+	tracing_on_fd = open(path, O_WRONLY);
+
+	printf("Latency tracing with %s in %s\n",
+	       tracer ? tracer : "events", trace_dir);
+}
 
 void latency_trace_start(void)
 {
-	if (prctl(PR_SET_TRACING, 1) < 0)
+	if (tracing_on_fd < 0)
+		return;
+
+	if (write(tracing_on_fd, "1", 1) != 1)
 		perror("Failed to start tracing");
 }
 
+/*
+ * Called from the hot path right after a sample exceeded the threshold, the
+ * file is kept open so that the ring buffer is frozen with a single write.
+ */
 void latency_trace_stop(void)
 {
-	if (prctl(PR_SET_TRACING, 0) < 0)
+	if (tracing_on_fd < 0)
+		return;
+
+	if (write(tracing_on_fd, "0", 1) != 1)
 		perror("Failed to stop tracing");
 }
 
 void latency_trace_print(void)
 {
-	read_and_print("/proc/latency_trace", STDOUT_FILENO);
-}
+	char path[PATH_MAX + 128];
 
-static int trace_marker_fd = -1;
+	if (!trace_dir[0])
+		return;
+
+	snprintf(path, sizeof(path), "%s/trace", trace_dir);
+	fflush(stdout);
+	read_and_print(path, STDOUT_FILENO);
+}
 
 void trace_marker_prep(void)
 {
+	char path[PATH_MAX + 128];
+
 	if (trace_marker_fd != -1)
 		return;
-	trace_marker_fd = open("/sys/kernel/tracing/trace_marker", O_RDWR, 0);
+
+	if (trace_dir[0])
+		snprintf(path, sizeof(path), "%s/trace_marker", trace_dir);
+	else
+		strcpy(path, "/sys/kernel/tracing/trace_marker");
+
+	trace_marker_fd = open(path, O_RDWR, 0);
 }
 
 int trace_marker_write(char *buf, int len)
@@ -39,8 +39,16 @@
  * Fiddle with the command line options until you get something
  * resembling the kind of workload you want to investigate.
  *
+ * To attribute changes to the memory management, the chunks can be
+ * backed by transparent or hugetlb huge pages and, on NUMA machines,
+ * threads can be bound to nodes with either node local or interleaved
+ * copies of the chunks. Per thread and per node rates, latency
+ * percentiles of the individual operations and a single line key=value
+ * summary can be printed.
+ *
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
@@ -51,8 +59,13 @@
 #include <sys/time.h>
 #include <sys/resource.h>
 #include <stdint.h>
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
 
 #include "ebizzy.h"
+#include "tst_hist.h"
 
 /*
  * Command line options
@@ -71,6 +84,26 @@ static unsigned int verbose;
 static unsigned int linear;
 static unsigned int touch_pages;
 static unsigned int no_lib_memcpy;
+static unsigned int chunk_pages;
+static unsigned int numa_mode;
+static unsigned int measure_latency;
+static unsigned int result_line;
+
+enum {
+	PAGES_BASE,
+	PAGES_THP,
+	PAGES_HUGETLB,
+};
+
+static const char *const pages_names[] = {"base", "thp", "hugetlb"};
+
+enum {
+	NUMA_OFF,
+	NUMA_LOCAL,
+	NUMA_INTERLEAVE,
+};
+
+static const char *const numa_names[] = {"off", "local", "interleave"};
 
 /*
  * Other global variables
@@ -84,6 +117,25 @@ static char **hole_mem;
 static unsigned int page_size;
 static time_t start_time;
 static volatile int threads_go;
+static size_t huge_page_size;
+
+/*
+ * NUMA nodes with both CPUs and memory, with -N local every node gets its
+ * own copy of the chunks.
+ */
+#define MAX_NODES 1024
+static unsigned int nr_nodes = 1;
+static int node_ids[MAX_NODES];
+static unsigned int mem_copies = 1;
+static record_t ***node_mem;
+
+struct thread_ctx {
+	pthread_t thread;
+	unsigned int node;
+	record_t **mem;
+	uintptr_t records;
+	struct tst_hist hist;
+};
 
 static void usage(void)
 {
@@ -100,7 +152,12 @@ static void usage(void)
 		"-S <seconds>\t Number of seconds to run\n"
 		"-t <num>\t Number of threads (2 * number cpus by default)\n"
 		"-v[v[v]]\t Be verbose (more v's for more verbose)\n"
-		"-z\t\t Linear search instead of binary search\n", cmd);
+		"-z\t\t Linear search instead of binary search\n"
+		"-H <thp|hugetlb> Back the chunks with huge pages\n"
+		"-N <local|interleave> Bind threads to NUMA nodes round robin,\n"
+		"\t\t use node local or interleaved chunks\n"
+		"-L\t\t Print latency percentiles of the operations\n"
+		"-r\t\t Print a machine readable result line\n", cmd);
 	exit(1);
 }
 
@@ -132,8 +189,30 @@ static void read_options(int argc, char *argv[])
 	cmd = argv[0];
 	opterr = 1;
 
-	while ((c = getopt(argc, argv, "lmMn:pPRs:S:t:vzT")) != -1) {
+	while ((c = getopt(argc, argv, "lmMn:pPRs:S:t:vzTH:N:Lr")) != -1) {
 		switch (c) {
+		case 'H':
+			if (!strcmp(optarg, "thp"))
+				chunk_pages = PAGES_THP;
+			else if (!strcmp(optarg, "hugetlb"))
+				chunk_pages = PAGES_HUGETLB;
+			else
+				usage();
+			break;
+		case 'N':
+			if (!strcmp(optarg, "local"))
+				numa_mode = NUMA_LOCAL;
+			else if (!strcmp(optarg, "interleave"))
+				numa_mode = NUMA_INTERLEAVE;
+			else
+				usage();
+			break;
+		case 'L':
+			measure_latency = 1;
+			break;
+		case 'r':
+			result_line = 1;
+			break;
 		case 'l':
 			no_lib_memcpy = 1;
 			break;
@@ -206,6 +285,8 @@ static void read_options(int argc, char *argv[])
 		printf("linear %u\n", linear);
 		printf("touch_pages %u\n", touch_pages);
 		printf("page size %d\n", page_size);
+		printf("chunk pages %s\n", pages_names[chunk_pages]);
+		printf("numa %s\n", numa_names[numa_mode]);
 	}
 
 	/* Check for incompatible options */
@@ -224,7 +305,206 @@ static void read_options(int argc, char *argv[])
 			chunk_size, record_size);
 		usage();
 	}
+#ifndef __linux__
+	if (chunk_pages != PAGES_BASE || numa_mode != NUMA_OFF) {
+		fprintf(stderr, "Huge pages and NUMA options need Linux\n");
+		usage();
+	}
+#endif
+}
+
+#ifdef __linux__
+static size_t read_huge_page_size(void)
+{
+	unsigned long val = 0;
+	char line[128];
+	FILE *f;
+
+	if (chunk_pages == PAGES_THP) {
+		f = fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size",
+			  "r");
+		if (f) {
+			if (fscanf(f, "%lu", &val) != 1)
+				val = 0;
+			fclose(f);
+		}
+
+		return val ? val : 2 * 1024 * 1024;
+	}
+
+	f = fopen("/proc/meminfo", "r");
+	if (!f)
+		return 0;
+
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "Hugepagesize: %lu kB", &val) == 1)
+			break;
+	}
+
+	fclose(f);
+
+	return val * 1024;
+}
+
+/* MADV_HUGEPAGE has no effect when THP are disabled system wide */
+static int thp_disabled(void)
+{
+	char buf[128];
+	FILE *f;
+	int ret = 0;
+
+	f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+	if (!f)
+		return 1;
+
+	if (fgets(buf, sizeof(buf), f) && strstr(buf, "[never]"))
+		ret = 1;
+
+	fclose(f);
+
+	return ret;
+}
+
+/* Parse kernel list format, e.g. "0-3,8", from a sysfs file */
+static int read_list(const char *path, int *ids, int max)
+{
+	char buf[4096], *p;
+	int cnt = 0, start, end;
+	FILE *f;
+
+	f = fopen(path, "r");
+	if (!f)
+		return -1;
+
+	if (!fgets(buf, sizeof(buf), f))
+		buf[0] = '\0';
+
+	fclose(f);
+
+	for (p = buf; *p && *p != '\n'; ) {
+		start = end = strtol(p, &p, 10);
+		if (*p == '-')
+			end = strtol(p + 1, &p, 10);
+
+		for (; start <= end && cnt < max; start++)
+			ids[cnt++] = start;
+
+		if (*p == ',')
+			p++;
+		else
+			break;
+	}
+
+	return cnt;
+}
+
+static void node_cpus(int node, cpu_set_t *set)
+{
+	static int cpus[CPU_SETSIZE];
+	char path[128];
+	int i, cnt;
+
+	snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+		 node);
+	cnt = read_list(path, cpus, CPU_SETSIZE);
+
+	CPU_ZERO(set);
+	for (i = 0; i < cnt; i++)
+		CPU_SET(cpus[i], set);
+}
+
+static void discover_nodes(void)
+{
+	static int mem_nodes[MAX_NODES];
+	int i, j, cnt, nr_mem;
+	cpu_set_t set;
+
+	nr_mem = read_list("/sys/devices/system/node/has_memory", mem_nodes,
+			   MAX_NODES);
+	if (nr_mem <= 0) {
+		/* No NUMA support, treat the machine as a single node */
+		node_ids[0] = 0;
+		nr_nodes = 1;
+		return;
+	}
+
+	cnt = read_list("/sys/devices/system/node/has_cpu", node_ids,
+			MAX_NODES);
+
+	/* Drop memoryless and CPU-less nodes */
+	for (i = 0, nr_nodes = 0; i < cnt; i++) {
+		for (j = 0; j < nr_mem && mem_nodes[j] != node_ids[i]; j++)
+			;
+
+		node_cpus(node_ids[i], &set);
+		if (j < nr_mem && CPU_COUNT(&set))
+			node_ids[nr_nodes++] = node_ids[i];
+	}
+
+	if (!nr_nodes) {
+		fprintf(stderr, "No NUMA node with both CPUs and memory\n");
+		exit(1);
+	}
+
+	if (verbose)
+		printf("NUMA nodes %u\n", nr_nodes);
+}
+
+#define NODEMASK_LONGS (MAX_NODES / (8 * sizeof(unsigned long)))
+
+static void node_mask(unsigned long *mask, int node)
+{
+	unsigned int i;
+
+	memset(mask, 0, NODEMASK_LONGS * sizeof(*mask));
+
+	for (i = 0; i < nr_nodes; i++) {
+		if (node >= 0 && node_ids[i] != node)
+			continue;
+
+		mask[node_ids[i] / (8 * sizeof(*mask))] |=
+			1UL << (node_ids[i] % (8 * sizeof(*mask)));
+	}
+}
+
+/* Place the memory on the given node, or interleave it if node < 0 */
+static void bind_mem(void *p, size_t size, int node)
+{
+	unsigned long mask[NODEMASK_LONGS];
+	int mode = node < 0 ? MPOL_INTERLEAVE : MPOL_BIND;
+
+	node_mask(mask, node);
+
+	if (syscall(__NR_mbind, p, size, mode, mask, MAX_NODES + 1, 0)) {
+		perror("mbind");
+		exit(1);
+	}
+}
+
+/* Bind the calling thread to the node, interleave its allocations too */
+static void bind_thread(unsigned int node)
+{
+	unsigned long mask[NODEMASK_LONGS];
+	cpu_set_t set;
+
+	node_cpus(node_ids[node], &set);
+
+	if (sched_setaffinity(0, sizeof(set), &set)) {
+		perror("sched_setaffinity");
+		exit(1);
+	}
+
+	if (numa_mode != NUMA_INTERLEAVE)
+		return;
+
+	node_mask(mask, -1);
+
+	if (syscall(__NR_set_mempolicy, MPOL_INTERLEAVE, mask, MAX_NODES + 1)) {
+		perror("set_mempolicy");
+		exit(1);
+	}
 }
+#endif
 
 static void touch_mem(char *dest, size_t size)
 {
@@ -270,6 +550,73 @@ static void free_mem(void *p, size_t size)
 		free(p);
 }
 
+/*
+ * Chunks are always mapped when they have to be backed by huge pages or
+ * placed on NUMA nodes. All chunks of a copy are carved from one mapping, so
+ * that chunks smaller than a huge page still share huge pages. They are
+ * never freed.
+ */
+static int alloc_chunks(record_t **chunk_mem, unsigned int copy)
+{
+#ifdef __linux__
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+	size_t stride, len, align = 0;
+	char *p, *aligned;
+	unsigned int i;
+
+	if (chunk_pages == PAGES_BASE && numa_mode == NUMA_OFF)
+		return 0;
+
+	stride = (chunk_size + page_size - 1) & ~((size_t)page_size - 1);
+	len = stride * chunks;
+
+	if (chunk_pages != PAGES_BASE)
+		len = (len + huge_page_size - 1) & ~(huge_page_size - 1);
+
+	if (chunk_pages == PAGES_HUGETLB)
+		flags |= MAP_HUGETLB;
+
+	/* THP needs huge page aligned memory */
+	if (chunk_pages == PAGES_THP)
+		align = huge_page_size;
+
+	p = mmap(NULL, len + align, PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (p == MAP_FAILED) {
+		fprintf(stderr, "Couldn't map %zu bytes for the chunks%s\n", len,
+			chunk_pages == PAGES_HUGETLB ?
+			", check /proc/sys/vm/nr_hugepages" : "");
+		exit(1);
+	}
+
+	if (align) {
+		aligned = (char *)(((uintptr_t)p + align - 1) & ~(align - 1));
+		if (aligned != p)
+			munmap(p, aligned - p);
+		munmap(aligned + len, p + align - aligned);
+		p = aligned;
+
+		if (madvise(p, len, MADV_HUGEPAGE)) {
+			perror("madvise(MADV_HUGEPAGE)");
+			exit(1);
+		}
+	}
+
+	if (numa_mode == NUMA_LOCAL)
+		bind_mem(p, len, node_ids[copy]);
+	else if (numa_mode == NUMA_INTERLEAVE)
+		bind_mem(p, len, -1);
+
+	for (i = 0; i < chunks; i++)
+		chunk_mem[i] = (record_t *)(p + i * stride);
+
+	return 1;
+#else
+	(void)chunk_mem;
+	(void)copy;
+	return 0;
+#endif
+}
+
 /*
  * Factor out differences in memcpy implementation by optionally using
  * our own simple memcpy implementation.
@@ -288,24 +635,55 @@ static void my_memcpy(void *dest, void *src, size_t len)
 
 static void allocate(void)
 {
-	unsigned int i;
+	unsigned int i, c;
 
-	mem = alloc_mem(chunks * sizeof(record_t *));
+#ifdef __linux__
+	if (chunk_pages != PAGES_BASE) {
+		huge_page_size = read_huge_page_size();
+		if (!huge_page_size) {
+			fprintf(stderr, "Huge pages are not supported\n");
+			exit(1);
+		}
+	}
+
+	if (chunk_pages == PAGES_THP && thp_disabled()) {
+		fprintf(stderr, "Transparent huge pages are disabled, "
+			"check /sys/kernel/mm/transparent_hugepage/enabled\n");
+		exit(1);
+	}
+
+	if (numa_mode != NUMA_OFF)
+		discover_nodes();
+#endif
+
+	if (numa_mode == NUMA_LOCAL)
+		mem_copies = nr_nodes;
+
+	node_mem = alloc_mem(mem_copies * sizeof(record_t **));
 
 	if (use_holes)
 		hole_mem = alloc_mem(chunks * sizeof(record_t *));
 
-	for (i = 0; i < chunks; i++) {
-		mem[i] = (record_t *) alloc_mem(chunk_size);
-		/* Prevent coalescing using holes */
+	for (c = 0; c < mem_copies; c++) {
+		mem = node_mem[c] = alloc_mem(chunks * sizeof(record_t *));
+
+		if (alloc_chunks(mem, c))
+			continue;
+
+		for (i = 0; i < chunks; i++) {
+			mem[i] = (record_t *) alloc_mem(chunk_size);
+			/* Prevent coalescing using holes */
+			if (use_holes)
+				hole_mem[i] = alloc_mem(page_size);
+		}
+
+		/* Free hole memory */
 		if (use_holes)
-			hole_mem[i] = alloc_mem(page_size);
+			for (i = 0; i < chunks; i++)
+				free_mem(hole_mem[i], page_size);
 	}
 
-	/* Free hole memory */
-	if (use_holes)
-		for (i = 0; i < chunks; i++)
-			free_mem(hole_mem[i], page_size);
+	mem = node_mem[0];
 
 	if (verbose)
 		printf("Allocated memory\n");
@@ -313,14 +691,17 @@ static void allocate(void)
 
 static void write_pattern(void)
 {
-	unsigned int i, j;
-
-	for (i = 0; i < chunks; i++) {
-		for (j = 0; j < chunk_size / record_size; j++)
-			mem[i][j] = (record_t) j;
-		/* Prevent coalescing by alternating permissions */
-		if (use_permissions && (i % 2) == 0)
-			mprotect((void *)mem[i], chunk_size, PROT_READ);
+	unsigned int i, j, c;
+
+	for (c = 0; c < mem_copies; c++) {
+		for (i = 0; i < chunks; i++) {
+			for (j = 0; j < chunk_size / record_size; j++)
+				node_mem[c][i][j] = (record_t) j;
+			/* Prevent coalescing by alternating permissions */
+			if (use_permissions && (i % 2) == 0)
+				mprotect((void *)node_mem[c][i], chunk_size,
+					 PROT_READ);
+		}
 	}
 	if (verbose)
 		printf("Wrote memory\n");
@@ -366,7 +747,7 @@ static inline unsigned int rand_num(unsigned int max, unsigned int *state)
  *
  */
 
-static uintptr_t search_mem(void)
+static uintptr_t search_mem(struct thread_ctx *ctx)
 {
 	record_t key, *found;
 	record_t *src, *copy;
@@ -374,10 +755,14 @@ static uintptr_t search_mem(void)
 	size_t copy_size = chunk_size;
 	uintptr_t i;
 	unsigned int state = 0;
+	uint64_t start = 0;
 
 	for (i = 0; threads_go == 1; i++) {
+		if (measure_latency)
+			start = tst_hist_now_ns();
+
 		chunk = rand_num(chunks, &state);
-		src = mem[chunk];
+		src = ctx->mem[chunk];
 		/*
 		 * If we're doing random sizes, we need a non-zero
 		 * multiple of record size.
@@ -416,15 +801,24 @@ static uintptr_t search_mem(void)
 		}		/* end if ! touch_pages */
 
 		free_mem(copy, copy_size);
+
+		if (measure_latency)
+			tst_hist_add(&ctx->hist, tst_hist_now_ns() - start);
 	}
 
 	return (i);
 }
 
-static void *thread_run(void *arg __attribute__((unused)))
+static void *thread_run(void *arg)
 {
+	struct thread_ctx *ctx = arg;
 	uintptr_t records_thread;
 
+#ifdef __linux__
+	if (numa_mode != NUMA_OFF)
+		bind_thread(ctx->node);
+#endif
+
 	if (verbose > 1)
 		printf("Thread started\n");
 
@@ -432,7 +826,7 @@ static void *thread_run(void *arg __attribute__((unused)))
 
 	while (threads_go == 0) ;
 
-	records_thread = search_mem();
+	records_thread = search_mem(ctx);
 
 	if (verbose > 1)
 		printf("Thread finished, %f seconds\n",
@@ -449,9 +843,95 @@ static struct timeval difftimeval(struct timeval *end, struct timeval *start)
 	return diff;
 }
 
+static void print_results(struct thread_ctx *ctx, double elapsed,
+			  double records_per_sec, double usr, double sys)
+{
+	struct tst_hist *total = NULL;
+	double node_rate;
+	unsigned int i, j;
+
+	if (verbose || numa_mode != NUMA_OFF) {
+		for (i = 0; i < threads; i++)
+			printf("thread %u node %d: %tu records/s\n", i,
+			       node_ids[ctx[i].node],
+			       (uintptr_t)(ctx[i].records / elapsed));
+	}
+
+	for (j = 0; numa_mode != NUMA_OFF && j < nr_nodes; j++) {
+		node_rate = 0;
+		for (i = j; i < threads; i += nr_nodes)
+			node_rate += ctx[i].records / elapsed;
+
+		printf("node %d: %tu records/s\n", node_ids[j],
+		       (uintptr_t)node_rate);
+	}
+
+	if (measure_latency) {
+		total = calloc(1, sizeof(*total));
+		if (!total) {
+			fprintf(stderr, "Couldn't allocate histogram\n");
+			exit(1);
+		}
+
+		for (i = 0; i < threads; i++)
+			tst_hist_merge(total, &ctx[i].hist);
+
+		printf("latency us: p50 %.1f p90 %.1f p99 %.1f p99.9 %.1f "
+		       "max %.1f\n",
+		       tst_hist_percentile(total, 50) / 1000.0,
+		       tst_hist_percentile(total, 90) / 1000.0,
+		       tst_hist_percentile(total, 99) / 1000.0,
+		       tst_hist_percentile(total, 99.9) / 1000.0,
+		       total->max / 1000.0);
+	}
+
+	if (!result_line) {
+		free(total);
+		return;
+	}
+
+	printf("ebizzy: records_per_sec=%tu threads=%u chunks=%u "
+	       "chunk_size=%u pages=%s numa=%s mmap=%s real=%.2f "
+	       "user=%.2f sys=%.2f", (uintptr_t)records_per_sec, threads,
+	       chunks, chunk_size, pages_names[chunk_pages],
+	       numa_names[numa_mode],
+	       always_mmap ? "always" : never_mmap ? "never" : "default",
+	       elapsed, usr, sys);
+
+	if (total) {
+		printf(" lat_p50_us=%.1f lat_p90_us=%.1f lat_p99_us=%.1f "
+		       "lat_p99_9_us=%.1f lat_max_us=%.1f",
+		       tst_hist_percentile(total, 50) / 1000.0,
+		       tst_hist_percentile(total, 90) / 1000.0,
+		       tst_hist_percentile(total, 99) / 1000.0,
+		       tst_hist_percentile(total, 99.9) / 1000.0,
+		       total->max / 1000.0);
+	}
+
+	printf(" thread_records_per_sec=");
+	for (i = 0; i < threads; i++)
+		printf("%s%tu", i ? "," : "",
+		       (uintptr_t)(ctx[i].records / elapsed));
+
+	if (numa_mode != NUMA_OFF) {
+		printf(" node_records_per_sec=");
+		for (j = 0; j < nr_nodes; j++) {
+			node_rate = 0;
+			for (i = j; i < threads; i += nr_nodes)
+				node_rate += ctx[i].records / elapsed;
+
+			printf("%s%d:%tu", j ? "," : "", node_ids[j],
+			       (uintptr_t)node_rate);
+		}
+	}
+
+	printf("\n");
+	free(total);
+}
+
 static void start_threads(void)
 {
-	pthread_t thread_array[threads];
+	struct thread_ctx *ctx;
 	double elapsed;
 	unsigned int i;
 	struct rusage start_ru, end_ru;
@@ -459,11 +939,19 @@ static void start_threads(void)
 	double records_per_sec = 0.0;
 	int err;
 
+	ctx = calloc(threads, sizeof(*ctx));
+	if (!ctx) {
+		fprintf(stderr, "Couldn't allocate thread contexts\n");
+		exit(1);
+	}
+
 	if (verbose)
 		printf("Threads starting\n");
 
 	for (i = 0; i < threads; i++) {
-		err = pthread_create(&thread_array[i], NULL, thread_run, NULL);
+		ctx[i].node = i % nr_nodes;
+		ctx[i].mem = node_mem[ctx[i].node % mem_copies];
+		err = pthread_create(&ctx[i].thread, NULL, thread_run, &ctx[i]);
 		if (err) {
 			fprintf(stderr, "Error creating thread %d\n", i);
 			exit(1);
@@ -488,11 +976,12 @@ static void start_threads(void)
 
 	for (i = 0; i < threads; i++) {
 		uintptr_t record_thread;
-		err = pthread_join(thread_array[i], (void *)&record_thread);
+		err = pthread_join(ctx[i].thread, (void *)&record_thread);
 		if (err) {
 			fprintf(stderr, "Error joining thread %d\n", i);
 			exit(1);
 		}
+		ctx[i].records = record_thread;
 		records_per_sec += ((double)record_thread / elapsed);
 	}
 
@@ -507,6 +996,11 @@ static void start_threads(void)
 	printf("real %5.2f s\n", elapsed);
 	printf("user %5.2f s\n", usr_time.tv_sec + usr_time.tv_usec / 1e6);
 	printf("sys  %5.2f s\n", sys_time.tv_sec + sys_time.tv_usec / 1e6);
+
+	print_results(ctx, elapsed, records_per_sec,
+		      usr_time.tv_sec + usr_time.tv_usec / 1e6,
+		      sys_time.tv_sec + sys_time.tv_usec / 1e6);
+	free(ctx);
 }
 
 int main(int argc, char *argv[])
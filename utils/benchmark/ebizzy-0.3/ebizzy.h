@@ -29,6 +29,24 @@
 #define _SC_NPROCESSORS_ONLN pthread_num_processors_np()
 #endif
 
+/*
+ * Linux memory policies, to avoid dependency on libnuma
+ */
+#ifdef __linux__
+#ifndef MPOL_BIND
+#define MPOL_BIND	2
+#endif
+#ifndef MPOL_INTERLEAVE
+#define MPOL_INTERLEAVE	3
+#endif
+#ifndef MAP_HUGETLB
+#define MAP_HUGETLB	0x40000
+#endif
+#ifndef MADV_HUGEPAGE
+#define MADV_HUGEPAGE	14
+#endif
+#endif
+
 
 
 #endif /* EBIZZY_H */
@@ -0,0 +1,575 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) Linux Test Project, 2026
+ *
+ * Based on the kernbench script by Con Kolivas <kernbench@kolivas.org>
+ */
+
+/*\
+ * Compile benchmark, builds a source tree (a kernel tree, the LTP tree or
+ * anything else built by make) repeatedly with different numbers of jobs.
+ *
+ * When the cpu and memory cgroup controllers are available each clean and
+ * build phase runs in its own cgroup below the test cgroup. CPU time, peak
+ * memory, context switches and the cpu, memory and io pressure stall totals
+ * of the phase are collected at its end, the CPU usage and memory of the
+ * group are sampled while it runs. Otherwise only the elapsed time and the
+ * resource usage of the phase are reported.
+ *
+ * Without any of -o, -s, -H, -O and -M the job count is doubled starting
+ * with one until the median build time improves by less than -k percent
+ * and the knee of the curve is reported. Otherwise the fixed kernbench load
+ * levels are used: single threaded, half load (CPUs / 2), optimal load
+ * (4 * CPUs or -o) and maximal load (unlimited jobs).
+ *
+ * Note that the clean command is run before every build, do not point the
+ * benchmark at the tree it is installed from.
+ */
+
+#include <math.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "tst_test.h"
+#include "lapi/syscalls.h"
+
+#define MAX_LEVELS 64
+#define MAX_RUNS 100
+#define CG_EMPTY_TIMEOUT_MS 10000
+
+struct phase_stats {
+	double elapsed;
+	double user;
+	double sys;
+	double cg_usage;
+	double cpus_avg;
+	double cpus_max;
+	double mem_peak;
+	double ctx_vol;
+	double ctx_invol;
+	double psi_cpu;
+	double psi_mem;
+	double psi_io;
+};
+
+/* Values which could not be collected are negative and not reported */
+static const struct metric {
+	const char *name;
+	size_t off;
+} metrics[] = {
+	{"Elapsed time (s)", offsetof(struct phase_stats, elapsed)},
+	{"User time (s)", offsetof(struct phase_stats, user)},
+	{"System time (s)", offsetof(struct phase_stats, sys)},
+	{"cgroup CPU time (s)", offsetof(struct phase_stats, cg_usage)},
+	{"CPUs busy avg", offsetof(struct phase_stats, cpus_avg)},
+	{"CPUs busy max", offsetof(struct phase_stats, cpus_max)},
+	{"Peak memory (MiB)", offsetof(struct phase_stats, mem_peak)},
+	{"Voluntary ctx switches", offsetof(struct phase_stats, ctx_vol)},
+	{"Involuntary ctx switches", offsetof(struct phase_stats, ctx_invol)},
+	{"CPU pressure (s)", offsetof(struct phase_stats, psi_cpu)},
+	{"Memory pressure (s)", offsetof(struct phase_stats, psi_mem)},
+	{"IO pressure (s)", offsetof(struct phase_stats, psi_io)},
+};
+
+struct level {
+	const char *name;
+	/* 0 means unlimited */
+	unsigned int jobs;
+	double median;
+};
+
+static char *src_dir, *build_cmd = "make", *clean_cmd = "make clean";
+static char *log_path, *runs_str, *max_jobs_str, *knee_str, *interval_str;
+static char *opti_str, *single_str, *no_half_str, *no_opti_str, *no_max_str;
+static char *fast_str;
+
+static unsigned int runs = 3, max_jobs, interval_ms = 250;
+static float knee_pct = 5;
+static long ncpus;
+static int use_cg, has_cpu_stat, has_mem_current, has_mem_peak;
+static int has_psi_cpu, has_psi_mem, has_psi_io, has_kill;
+static unsigned int phase_cnt;
+
+static struct level levels[MAX_LEVELS];
+static unsigned int level_cnt;
+static struct phase_stats build_stats[MAX_RUNS], clean_stats[MAX_RUNS];
+
+static double stat_val(const struct phase_stats *st, const struct metric *m)
+{
+	return *(const double *)((const char *)st + m->off);
+}
+
+static double timespec_diff(const struct timespec *a, const struct timespec *b)
+{
+	return (a->tv_sec - b->tv_sec) + (a->tv_nsec - b->tv_nsec) / 1e9;
+}
+
+static unsigned long long cg_cpu_usage(const struct tst_cg_group *cg)
+{
+	unsigned long long usage;
+
+	SAFE_CG_LINES_SCANF(cg, "cpu.stat", "usage_usec %llu", &usage);
+
+	return usage;
+}
+
+static double cg_pressure(const struct tst_cg_group *cg, const char *file)
+{
+	unsigned long long total;
+
+	SAFE_CG_LINES_SCANF(cg, file,
+		"some avg10=%*f avg60=%*f avg300=%*f total=%llu", &total);
+
+	return total / 1e6;
+}
+
+/* cgroup.kill is asynchronous, the group can be removed once it's empty */
+static void cg_wait_empty(const struct tst_cg_group *cg)
+{
+	int populated, i;
+
+	for (i = 0; i < CG_EMPTY_TIMEOUT_MS; i++) {
+		SAFE_CG_LINES_SCANF(cg, "cgroup.events", "populated %d",
+				    &populated);
+		if (!populated)
+			return;
+
+		usleep(1000);
+	}
+
+	tst_brk(TBROK, "Group still populated %i ms after cgroup.kill",
+		CG_EMPTY_TIMEOUT_MS);
+}
+
+static int open_pidfd(pid_t pid)
+{
+#ifdef __NR_pidfd_open
+	return syscall(__NR_pidfd_open, pid, 0);
+#else
+	return -1;
+#endif
+}
+
+/*
+ * Run the command in a new child cgroup, sample it every interval_ms until
+ * it exits and collect the totals.
+ */
+static void run_phase(const char *name, const char *cmd,
+		      struct phase_stats *st)
+{
+	struct tst_cg_group *cg = NULL;
+	struct pollfd pfd = {.events = POLLIN};
+	struct timespec start, now, prev;
+	unsigned long long usage = 0, prev_usage = 0, start_usage = 0;
+	long long mem, mem_max = 0;
+	double busy, busy_sum = 0, busy_max = 0;
+	unsigned int samples = 0;
+	struct rusage ru;
+	int status, fd;
+	pid_t pid, ret;
+
+	tst_res(TDEBUG, "%s: %s", name, cmd);
+
+	if (use_cg)
+		cg = tst_cg_group_mk(tst_cg, "phase%u", phase_cnt++);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	pid = SAFE_FORK();
+	if (!pid) {
+		if (cg)
+			SAFE_CG_PRINTF(cg, "cgroup.procs", "%d", getpid());
+
+		if (log_path)
+			fd = SAFE_OPEN(log_path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+		else
+			fd = SAFE_OPEN("/dev/null", O_WRONLY);
+
+		SAFE_DUP2(fd, STDOUT_FILENO);
+		SAFE_DUP2(fd, STDERR_FILENO);
+		SAFE_CLOSE(fd);
+
+		execl("/bin/sh", "sh", "-c", cmd, NULL);
+		tst_brk(TBROK | TERRNO, "execl(/bin/sh)");
+	}
+
+	pfd.fd = open_pidfd(pid);
+	prev = start;
+
+	if (has_cpu_stat)
+		start_usage = prev_usage = cg_cpu_usage(cg);
+
+	for (;;) {
+		if (pfd.fd >= 0) {
+			if (poll(&pfd, 1, interval_ms) < 0 && errno != EINTR)
+				tst_brk(TBROK | TERRNO, "poll(pidfd)");
+		} else {
+			usleep(interval_ms * 1000);
+		}
+
+		ret = wait4(pid, &status, WNOHANG, &ru);
+		if (ret < 0)
+			tst_brk(TBROK | TERRNO, "wait4()");
+
+		if (ret)
+			break;
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		if (has_mem_current) {
+			SAFE_CG_SCANF(cg, "memory.current", "%lld", &mem);
+			mem_max = MAX(mem_max, mem);
+		}
+
+		if (has_cpu_stat) {
+			usage = cg_cpu_usage(cg);
+			busy = (usage - prev_usage) / 1e6 /
+				timespec_diff(&now, &prev);
+			busy_sum += busy;
+			busy_max = MAX(busy_max, busy);
+			prev_usage = usage;
+			samples++;
+		}
+
+		prev = now;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	if (pfd.fd >= 0)
+		SAFE_CLOSE(pfd.fd);
+
+	if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+		tst_brk(TBROK, "%s '%s' %s%s", name, cmd, tst_strstatus(status),
+			log_path ? "" : ", use -l to log the output");
+	}
+
+	st->elapsed = timespec_diff(&now, &start);
+	st->user = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6;
+	st->sys = ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+	st->ctx_vol = ru.ru_nvcsw;
+	st->ctx_invol = ru.ru_nivcsw;
+	st->cg_usage = has_cpu_stat ? (cg_cpu_usage(cg) - start_usage) / 1e6 : -1;
+	st->cpus_avg = samples ? busy_sum / samples : -1;
+	st->cpus_max = samples ? busy_max : -1;
+	st->psi_cpu = has_psi_cpu ? cg_pressure(cg, "cpu.pressure") : -1;
+	st->psi_mem = has_psi_mem ? cg_pressure(cg, "memory.pressure") : -1;
+	st->psi_io = has_psi_io ? cg_pressure(cg, "io.pressure") : -1;
+
+	if (has_mem_peak)
+		SAFE_CG_SCANF(cg, "memory.peak", "%lld", &mem_max);
+
+	st->mem_peak = (has_mem_peak || has_mem_current) ?
+		mem_max / (1024.0 * 1024) : -1;
+
+	/* Daemons left behind by the build would keep the group busy */
+	if (has_kill) {
+		SAFE_CG_PRINT(cg, "cgroup.kill", "1");
+		cg_wait_empty(cg);
+	}
+
+	if (cg)
+		cg = tst_cg_group_rm(cg);
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+static double median_elapsed(const struct phase_stats *st, unsigned int cnt)
+{
+	double vals[MAX_RUNS];
+	unsigned int i;
+
+	for (i = 0; i < cnt; i++)
+		vals[i] = st[i].elapsed;
+
+	qsort(vals, cnt, sizeof(*vals), cmp_double);
+
+	if (cnt & 1)
+		return vals[cnt / 2];
+
+	return (vals[cnt / 2 - 1] + vals[cnt / 2]) / 2;
+}
+
+static void print_stats(const char *phase, const struct level *lvl,
+			const struct phase_stats *st, unsigned int cnt)
+{
+	double sum, sum_sq, val, avg, sdev;
+	unsigned int i, j;
+
+	tst_res(TINFO, "%s %s, average of %u runs (std deviation):",
+		lvl->name, phase, cnt);
+
+	for (i = 0; i < ARRAY_SIZE(metrics); i++) {
+		if (stat_val(&st[0], &metrics[i]) < 0)
+			continue;
+
+		sum = sum_sq = 0;
+		for (j = 0; j < cnt; j++) {
+			val = stat_val(&st[j], &metrics[i]);
+			sum += val;
+			sum_sq += val * val;
+		}
+
+		avg = sum / cnt;
+		sdev = cnt > 1 ? sqrt(MAX(0, (sum_sq - sum * sum / cnt) /
+					  (cnt - 1))) : 0;
+
+		tst_res(TINFO, "  %-25s %12.2f (%.2f)", metrics[i].name, avg,
+			sdev);
+	}
+}
+
+static char *jobs_cmd(const char *cmd, unsigned int jobs)
+{
+	static char buf[4096];
+
+	if (jobs)
+		snprintf(buf, sizeof(buf), "%s -j%u", cmd, jobs);
+	else
+		snprintf(buf, sizeof(buf), "%s -j", cmd);
+
+	return buf;
+}
+
+static void run_level(struct level *lvl)
+{
+	unsigned int i;
+
+	for (i = 0; i < runs; i++) {
+		tst_res(TINFO, "%s run %u/%u", lvl->name, i + 1, runs);
+		run_phase("clean", clean_cmd, &clean_stats[i]);
+		sync();
+		run_phase("build", jobs_cmd(build_cmd, lvl->jobs),
+			  &build_stats[i]);
+	}
+
+	lvl->median = median_elapsed(build_stats, runs);
+
+	print_stats("clean", lvl, clean_stats, runs);
+	print_stats("build", lvl, build_stats, runs);
+	tst_res(TINFO, "%s build median %.2fs", lvl->name, lvl->median);
+}
+
+static struct level *add_level(unsigned int jobs)
+{
+	static char names[MAX_LEVELS][32];
+	struct level *lvl;
+
+	if (level_cnt >= MAX_LEVELS)
+		tst_brk(TBROK, "Too many load levels");
+
+	lvl = &levels[level_cnt];
+
+	if (jobs)
+		snprintf(names[level_cnt], sizeof(names[0]), "-j%u", jobs);
+	else
+		strcpy(names[level_cnt], "-j");
+
+	lvl->name = names[level_cnt++];
+	lvl->jobs = jobs;
+
+	return lvl;
+}
+
+static void sweep(void)
+{
+	struct level *lvl, *prev = NULL;
+	unsigned int jobs;
+	double gain = 0;
+
+	for (jobs = 1; ; jobs = MIN(jobs * 2, max_jobs)) {
+		lvl = add_level(jobs);
+		run_level(lvl);
+
+		if (prev) {
+			gain = (prev->median - lvl->median) * 100 / prev->median;
+			tst_res(TINFO, "%s -> %s: %.1f%% faster", prev->name,
+				lvl->name, gain);
+
+			if (gain < knee_pct)
+				break;
+		}
+
+		if (jobs >= max_jobs)
+			break;
+
+		prev = lvl;
+	}
+
+	if (!prev || gain >= knee_pct) {
+		tst_res(TPASS, "No knee up to %s, median build time %.2fs",
+			lvl->name, lvl->median);
+		return;
+	}
+
+	tst_res(TPASS, "Knee at %s, median build time %.2fs, %s gains %.1f%%",
+		prev->name, prev->median, lvl->name, gain);
+}
+
+static void fixed_levels(void)
+{
+	unsigned int i, half_jobs = ncpus / 2;
+	int opti_jobs = 4 * ncpus;
+
+	if (opti_str && tst_parse_int(opti_str, &opti_jobs, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid number of optimal jobs '%s'", opti_str);
+
+	if (single_str)
+		add_level(1)->name = "Single threaded";
+
+	if (!no_half_str && half_jobs < 2) {
+		tst_res(TINFO, "Half load is no greater than single; disabling");
+	} else if (!no_half_str) {
+		/* A kernel compile won't guarantee 2 jobs */
+		add_level(half_jobs == 2 ? 3 : half_jobs);
+	}
+
+	if (!no_opti_str)
+		add_level(opti_jobs);
+
+	if (!no_max_str)
+		add_level(0);
+
+	if (!level_cnt)
+		tst_brk(TCONF, "Nothing to do");
+
+	for (i = 0; i < level_cnt; i++)
+		run_level(&levels[i]);
+
+	tst_res(TPASS, "Finished %u load levels", level_cnt);
+}
+
+static void run(void)
+{
+	struct phase_stats warmup;
+	unsigned int i;
+
+	if (!fast_str) {
+		tst_res(TINFO, "Warmup run");
+		run_phase("clean", clean_cmd, &warmup);
+		run_phase("build", jobs_cmd(build_cmd, max_jobs), &warmup);
+	}
+
+	if (opti_str || single_str || no_half_str || no_opti_str || no_max_str)
+		fixed_levels();
+	else
+		sweep();
+
+	tst_res(TINFO, "Load level  median build time  speedup");
+	for (i = 0; i < level_cnt; i++) {
+		tst_res(TINFO, "%-16s %12.2fs %8.2fx", levels[i].name,
+			levels[i].median, levels[0].median / levels[i].median);
+	}
+}
+
+/* The cgroup accounting is optional, e.g. pm_sched_mc.py runs kernbench as load */
+static void setup_cgroups(void)
+{
+	const struct tst_cg_opts opts = {};
+
+	if (!tst_cg_ctrl_mounted("cpu") || !tst_cg_ctrl_mounted("memory")) {
+		tst_res(TINFO, "cpu or memory cgroup controller not mounted, "
+			"reporting resource usage only");
+		return;
+	}
+
+	tst_cg_require("cpu", &opts);
+	tst_cg_require("memory", &opts);
+	tst_cg_init();
+	use_cg = 1;
+
+	has_cpu_stat = SAFE_CG_HAS(tst_cg, "cpu.stat");
+	has_mem_current = SAFE_CG_HAS(tst_cg, "memory.current");
+	has_mem_peak = SAFE_CG_HAS(tst_cg, "memory.peak");
+	has_psi_cpu = SAFE_CG_HAS(tst_cg, "cpu.pressure");
+	has_psi_mem = SAFE_CG_HAS(tst_cg, "memory.pressure");
+	has_psi_io = SAFE_CG_HAS(tst_cg, "io.pressure");
+	has_kill = SAFE_CG_HAS(tst_cg, "cgroup.kill");
+}
+
+static void setup(void)
+{
+	int val;
+	struct phase_stats st;
+
+	ncpus = tst_ncpus();
+	max_jobs = 4 * ncpus;
+
+	if (runs_str && tst_parse_int(runs_str, &val, 1, MAX_RUNS))
+		tst_brk(TBROK, "Invalid number of runs '%s'", runs_str);
+	else if (runs_str)
+		runs = val;
+
+	if (max_jobs_str && tst_parse_int(max_jobs_str, &val, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid maximal number of jobs '%s'", max_jobs_str);
+	else if (max_jobs_str)
+		max_jobs = val;
+
+	if (interval_str && tst_parse_int(interval_str, &val, 10, 60000))
+		tst_brk(TBROK, "Invalid sampling interval '%s'", interval_str);
+	else if (interval_str)
+		interval_ms = val;
+
+	if (tst_parse_float(knee_str, &knee_pct, 0, 100))
+		tst_brk(TBROK, "Invalid knee threshold '%s'", knee_str);
+
+	if (log_path && log_path[0] != '/')
+		log_path = realpath(log_path, NULL) ?: log_path;
+
+	if (src_dir)
+		SAFE_CHDIR(src_dir);
+
+	if (!strcmp(build_cmd, "make") && access("Makefile", F_OK) &&
+	    access("makefile", F_OK) && access("GNUmakefile", F_OK))
+		tst_brk(TCONF, "No Makefile found, use -d to select a source tree");
+
+	setup_cgroups();
+
+	if (!access("include/linux/kernel.h", F_OK) &&
+	    access(".config", F_OK)) {
+		tst_res(TINFO, "No kernel config found, using defconfig");
+		run_phase("config", "make defconfig", &st);
+	}
+
+	tst_res(TINFO, "%ld CPUs, building in %s", ncpus,
+		src_dir ? src_dir : "current directory");
+}
+
+static void cleanup(void)
+{
+	tst_cg_cleanup();
+}
+
+static struct tst_test test = {
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+	.forks_child = 1,
+	.timeout = TST_UNLIMITED_TIMEOUT,
+	.options = (struct tst_option[]) {
+		{"d:", &src_dir, "Source tree to build (default: current directory)"},
+		{"c:", &build_cmd, "Build command, -jN is appended (default: make)"},
+		{"C:", &clean_cmd, "Clean command (default: make clean)"},
+		{"l:", &log_path, "Append output of the commands to a file"},
+		{"n:", &runs_str, "Number of runs per load level (default: 3)"},
+		{"m:", &max_jobs_str, "Maximal number of jobs (default: 4 * CPUs)"},
+		{"k:", &knee_str, "Knee when doubling jobs gains less than N % (default: 5)"},
+		{"t:", &interval_str, "Sampling interval in ms (default: 250)"},
+		{"f", &fast_str, "Skip the warmup run"},
+		{"o:", &opti_str, "Number of jobs for optimal load run (default: 4 * CPUs)"},
+		{"s", &single_str, "Perform single threaded runs"},
+		{"H", &no_half_str, "Don't perform half load runs"},
+		{"O", &no_opti_str, "Don't perform optimal load runs"},
+		{"M", &no_max_str, "Don't perform maximal load runs"},
+		{}
+	},
+};